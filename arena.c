@@ -0,0 +1,247 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: arena.c
+	Arena of a game, and check of the heap allocations (built with -DARENA_CHECK_HEAP, see arena.h)
+*/
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "arena.h"
+
+
+/* block of the arena */
+struct ArenaBlock_ {
+	ArenaBlock* next;
+	size_t size;                /* size of `data` */
+	max_align_t data[];
+};
+
+#define ALIGN (sizeof(max_align_t))
+
+
+/* Add a block of (at least) `size` bytes to the arena; it becomes the current block
+ * Returns false if it cannot be allocated */
+static bool newBlock(Arena* arena, size_t size) {
+	if (size < ARENA_BLOCK_SIZE)
+		size = ARENA_BLOCK_SIZE;
+	ArenaBlock* block = malloc(sizeof(ArenaBlock) + size);
+	if (!block)
+		return false;
+	block->next = arena->blocks;
+	block->size = size;
+	arena->blocks = block;
+	arena->used = 0;
+	return true;
+}
+
+
+
+/* -------------------------------------
+ * Initialize an empty arena (nothing is allocated before the first arenaAlloc)
+ *
+ * Parameters:
+ * - arena: (Arena*) the arena (allocated by the user)
+ */
+void initArena(Arena* arena) {
+	arena->blocks = NULL;
+	arena->used = arena->total = 0;
+}
+
+
+/* -------------------------------------
+ * Allocate memory in the arena (aligned for any type, valid until the arena is reset or freed)
+ *
+ * Parameters:
+ * - arena: (Arena*) the arena
+ * - n: (size_t) number of bytes
+ *
+ * Returns the memory, or NULL if it cannot be allocated */
+void* arenaAlloc(Arena* arena, size_t n) {
+	n = (n + ALIGN - 1) & ~(ALIGN - 1);
+	if (!arena->blocks || arena->used + n > arena->blocks->size) {
+		/* the blocks grow, so that a big game needs few of them */
+		size_t size = arena->blocks ? 2 * arena->blocks->size : ARENA_BLOCK_SIZE;
+		if (!newBlock(arena, size > n ? size : n))
+			return NULL;
+	}
+	void* p = (char*) arena->blocks->data + arena->used;
+	arena->used += n;
+	arena->total += n;
+	return p;
+}
+
+
+/* -------------------------------------
+ * Copy a string in the arena
+ *
+ * Parameters:
+ * - arena: (Arena*) the arena
+ * - s: (string) the string
+ *
+ * Returns the copy, or NULL if it cannot be allocated */
+char* arenaStrdup(Arena* arena, const char* s) {
+	size_t n = strlen(s) + 1;
+	char* copy = arenaAlloc(arena, n);
+	if (copy)
+		memcpy(copy, s, n);
+	return copy;
+}
+
+
+/* -------------------------------------
+ * Release at once everything allocated in the arena
+ * The arena keeps a single block, large enough for everything allocated since the last reset (it is reallocated if
+ * the arena had several blocks), so that the next game does not allocate anything if it is not larger
+ *
+ * Parameters:
+ * - arena: (Arena*) the arena
+ */
+void resetArena(Arena* arena) {
+	if (arena->blocks && arena->blocks->next) {
+		size_t total = arena->total;
+		freeArena(arena);
+		newBlock(arena, total);
+	}
+	arena->used = arena->total = 0;
+}
+
+
+/* -------------------------------------
+ * Free the arena (it can be used again, as an empty arena)
+ *
+ * Parameters:
+ * - arena: (Arena*) the arena
+ */
+void freeArena(Arena* arena) {
+	while (arena->blocks) {
+		ArenaBlock* next = arena->blocks->next;
+		free(arena->blocks);
+		arena->blocks = next;
+	}
+	arena->used = arena->total = 0;
+}
+
+
+
+#if defined(ARENA_CHECK_HEAP) && defined(__GLIBC__)
+
+/* the allocator of the glibc, wrapped by the functions below */
+extern void* __libc_malloc(size_t n);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* p, size_t n);
+extern void* __libc_memalign(size_t alignment, size_t n);
+extern void* __libc_valloc(size_t n);
+
+static _Thread_local bool heapForbidden = false;
+
+
+/* A heap allocation has been made while they are forbidden: stop at once (without allocating anything) */
+static void heapViolation(const char* fct) {
+	static const char msg[] = "Heap allocation during the game (see forbidHeap in arena.h): ";
+	heapForbidden = false;
+	write(STDERR_FILENO, msg, sizeof(msg) - 1);
+	write(STDERR_FILENO, fct, strlen(fct));
+	write(STDERR_FILENO, "\n", 1);
+	abort();
+}
+
+
+void* malloc(size_t n) {
+	if (heapForbidden)
+		heapViolation("malloc");
+	return __libc_malloc(n);
+}
+
+
+void* calloc(size_t n, size_t size) {
+	if (heapForbidden)
+		heapViolation("calloc");
+	return __libc_calloc(n, size);
+}
+
+
+void* realloc(void* p, size_t n) {
+	if (heapForbidden)
+		heapViolation("realloc");
+	return __libc_realloc(p, n);
+}
+
+
+void* memalign(size_t alignment, size_t n) {
+	if (heapForbidden)
+		heapViolation("memalign");
+	return __libc_memalign(alignment, n);
+}
+
+
+void* aligned_alloc(size_t alignment, size_t n) {
+	if (heapForbidden)
+		heapViolation("aligned_alloc");
+	return __libc_memalign(alignment, n);
+}
+
+
+int posix_memalign(void** p, size_t alignment, size_t n) {
+	if (heapForbidden)
+		heapViolation("posix_memalign");
+	if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+		return EINVAL;
+	void* block = __libc_memalign(alignment, n);
+	if (!block)
+		return ENOMEM;
+	*p = block;
+	return 0;
+}
+
+
+void* valloc(size_t n) {
+	if (heapForbidden)
+		heapViolation("valloc");
+	return __libc_valloc(n);
+}
+
+
+/* strdup and strndup allocate inside the glibc, without calling malloc */
+char* strdup(const char* s) {
+	if (heapForbidden)
+		heapViolation("strdup");
+	size_t n = strlen(s) + 1;
+	char* copy = __libc_malloc(n);
+	return copy ? memcpy(copy, s, n) : NULL;
+}
+
+
+char* strndup(const char* s, size_t n) {
+	if (heapForbidden)
+		heapViolation("strndup");
+	n = strnlen(s, n);
+	char* copy = __libc_malloc(n + 1);
+	if (!copy)
+		return NULL;
+	memcpy(copy, s, n);
+	copy[n] = '\0';
+	return copy;
+}
+
+
+/* -------------------------------------
+ * Forbid the heap allocations to the thread (built with -DARENA_CHECK_HEAP only, see arena.h)
+ */
+void forbidHeap(void) {
+	heapForbidden = true;
+}
+
+
+/* -------------------------------------
+ * Allow the heap allocations to the thread again
+ */
+void allowHeap(void) {
+	heapForbidden = false;
+}
+
+#endif
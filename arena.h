@@ -0,0 +1,62 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: arena.h
+	Arena of a game: all the data of a game (names, map, state of the bot) is allocated in it, and freed at once
+
+	The allocations are only a few additions in a block; the arena is reset when the next game starts, or freed by
+	quitGame. After a reset, the arena keeps a single block, as large as what the last game has used: a new game of
+	the same size does not allocate anything from the heap.
+
+	Built with -DARENA_CHECK_HEAP (with the glibc): between `forbidHeap()` and `allowHeap()`, a heap allocation made
+	by the thread (malloc, calloc, realloc, the aligned allocations, strdup or strndup, even from a library) aborts the
+	program with a message. A bot can then check that its game loop does not allocate anything. The check replaces
+	the allocator of the whole program: it is only compiled in on demand (forbidHeap and allowHeap do nothing
+	otherwise). The logger allocates the ring of a thread at its first record: call logInitThread before forbidHeap.
+
+	Usage:
+	    sendGameSettings(&game, settings, &gameData);
+	    Graph* graph = arenaAlloc(&game.arena, sizeof(Graph));  // allocated for this game only
+	    logInitThread();
+	    forbidHeap();
+	    ...                                                     // play the game
+	    allowHeap();
+	    quitGame(&game);                                        // the arena is freed
+*/
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+
+#define ARENA_BLOCK_SIZE 4096       /* minimum size of a block of the arena */
+
+
+typedef struct ArenaBlock_ ArenaBlock;
+
+/* arena (allocated by the user, initialized by initArena) */
+typedef struct {
+    ArenaBlock* blocks;     /* blocks of the arena (the current one first) */
+    size_t used;            /* bytes used in the current block */
+    size_t total;           /* bytes used in all the blocks, since the last reset */
+} Arena;
+
+
+/* prototypes */
+void initArena(Arena* arena);
+void* arenaAlloc(Arena* arena, size_t n);
+char* arenaStrdup(Arena* arena, const char* s);
+void resetArena(Arena* arena);
+void freeArena(Arena* arena);
+
+#if defined(ARENA_CHECK_HEAP) && defined(__GLIBC__)
+void forbidHeap(void);
+void allowHeap(void);
+#else
+#define forbidHeap() ((void) 0)
+#define allowHeap() ((void) 0)
+#endif
+
+
+#endif
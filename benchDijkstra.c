@@ -0,0 +1,151 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: benchDijkstra.c
+	Benchmark of the shortest paths of the bot (dijkstra, in main.c): the next city taken by the scan of an array,
+	compared with a binary heap (above SEUIL_TAS cities). The bot is included, with SEUIL_TAS replaced by a variable
+	so that both ways run on the same graph; they are checked to give the same distances.
+	Graphs: the small and USA maps of the local server, and synthetic grids of 1000, 10000 and 100000 cities (each
+	city linked to its right and lower neighbours, and one time in three to a random city).
+	usage: benchDijkstra [maxCities]      (100000 by default: the scan takes about 25 s on the largest grid)
+
+	gcc -O2 -o benchDijkstra benchDijkstra.c ticketToRide.c clientAPI.c ringBuffer.c encoder.c eventLoop.c
+	    coroutine.c transport.c uringTransport.c inprocTransport.c replayTransport.c recorder.c latency.c
+	    gamePool.c ioThread.c logger.c localServer.c localGame.c localMaps.c boardView.c arena.c -pthread
+*/
+
+/* the bot, with its threshold in a variable, and its main renamed */
+static int seuilTas;
+#define SEUIL_TAS seuilTas
+#define main mainBot
+#include "main.c"
+#undef main
+
+#include "localGame.h"
+
+
+#define MAX_CITIES 100000
+#define MIN_NS 200000000ULL         /* each way is timed for at least 0.2 s (or one call) */
+
+
+static int distScan[MAX_CITIES];
+static unsigned int seed = 12345;
+
+
+static unsigned int nextRandom(void) {
+	seed = seed * 1103515245u + 12345u;
+	return seed >> 8;
+}
+
+
+/* Time dijkstra from successive cities, with the threshold given; returns the mean time of a call (ns) */
+static double timeDijkstra(const Graphe* g, int threshold) {
+	uint64_t start = monotonicNs(), ns;
+	long calls = 0;
+
+	seuilTas = threshold;
+	do {
+		dijkstra(g, NULL, calls % g->nbVilles);
+		calls++;
+		ns = monotonicNs() - start;
+	} while (ns < MIN_NS);
+	return (double) ns / calls;
+}
+
+
+/* Measure both ways on the graph, after checking that they give the same distances */
+static bool benchGraph(const char* name, const Graphe* g) {
+	int n = g->nbVilles;
+
+	seuilTas = n;
+	memcpy(distScan, dijkstra(g, NULL, 0)->dist, n * sizeof(int));
+	seuilTas = 0;
+	if (memcmp(distScan, dijkstra(g, NULL, 0)->dist, n * sizeof(int)) != 0) {
+		printf("%s: different distances\n", name);
+		return false;
+	}
+
+	double scan = timeDijkstra(g, n);
+	double heap = timeDijkstra(g, 0);
+	printf("%-16s %7d cities %7d routes: scan %12.0f ns, heap %10.0f ns\n", name, n, g->nbRoutes, scan, heap);
+	return true;
+}
+
+
+/* Graph of a map of the local server (built as in a game) */
+static bool benchMap(const Map* map) {
+	int trackData[5 * MAX_ROUTES];
+	GameData gameData = { .nbCities = map->nbCities, .nbTracks = map->nbTracks, .trackData = trackData };
+
+	for (int i = 0; i < map->nbTracks; i++)
+		memcpy(trackData + 5 * i, map->tracks[i], 5 * sizeof(int));
+	resetArena(&contexte.arena);
+	if (construireGraphe(&partie.graphe, &gameData) != ALL_GOOD) {
+		printf("%s: graph not built\n", map->name);
+		return false;
+	}
+	return benchGraph(map->name, &partie.graphe);
+}
+
+
+/* Synthetic grid of n cities (construireGraphe is limited to MAX_ROUTES routes: the graph is built here) */
+static bool benchGrid(int n) {
+	int width = 1;
+	while (width * width < n)
+		width++;
+
+	Graphe g = { .nbVilles = n, .nbRoutes = 0 };
+	g.routes = malloc(3 * n * sizeof(Route));
+	g.debut = calloc(n + 1, sizeof(int));
+	for (int v = 0; v < n; v++) {
+		if (v % width + 1 < width && v + 1 < n)
+			g.routes[g.nbRoutes++] = (Route) { v, v + 1, 1 + nextRandom() % 6, RED, -1 };
+		if (v + width < n)
+			g.routes[g.nbRoutes++] = (Route) { v, v + width, 1 + nextRandom() % 6, RED, -1 };
+		if (nextRandom() % 3 == 0)
+			g.routes[g.nbRoutes++] = (Route) { v, nextRandom() % n, 1 + nextRandom() % 6, RED, -1 };
+	}
+
+	/* adjacency lists, as in construireGraphe */
+	g.aretes = malloc(2 * g.nbRoutes * sizeof(Arete));
+	int* next = malloc(n * sizeof(int));
+	for (int r = 0; r < g.nbRoutes; r++) {
+		g.debut[g.routes[r].from + 1]++;
+		g.debut[g.routes[r].to + 1]++;
+	}
+	for (int v = 0; v < n; v++)
+		g.debut[v + 1] += g.debut[v];
+	memcpy(next, g.debut, n * sizeof(int));
+	for (int r = 0; r < g.nbRoutes; r++) {
+		g.aretes[next[g.routes[r].from]++] = (Arete) { .ville = g.routes[r].to, .route = r };
+		g.aretes[next[g.routes[r].to]++] = (Arete) { .ville = g.routes[r].from, .route = r };
+	}
+
+	/* arrays of dijkstra */
+	int* arrays = malloc(4 * n * sizeof(int));
+	resultatDijkstra = (DijkstraResult) { arrays, arrays + n, arrays + 2 * n, arrays + 3 * n };
+
+	char name[32];
+	snprintf(name, sizeof(name), "grid %d", n);
+	bool ok = benchGraph(name, &g);
+	free(arrays);
+	free(next);
+	free(g.aretes);
+	free(g.debut);
+	free(g.routes);
+	return ok;
+}
+
+
+int main(int argc, char** argv) {
+	int maxCities = argc > 1 ? atoi(argv[1]) : MAX_CITIES;
+
+	if (maxCities > MAX_CITIES)
+		maxCities = MAX_CITIES;
+	initArena(&contexte.arena);
+	bool ok = benchMap(&mapSmall) && benchMap(&mapUSA);
+	for (int n = 1000; ok && n <= maxCities; n *= 10)
+		ok = benchGrid(n);
+	freeArena(&contexte.arena);
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
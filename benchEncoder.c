@@ -0,0 +1,95 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: benchEncoder.c
+	Benchmark of the building of the commands: a PLAY_MOVE encoded by queueMoveValues (encoder.h) and sent with one
+	writev, compared with the previous way (the move formatted by sprintf, then the command by vsprintf in a 20000-byte
+	buffer zeroed first, as sendString did). The commands are written to /dev/null: only their building and the
+	system call are measured.
+	usage: benchEncoder [moves]      (2000000 moves by default)
+
+	gcc -O2 -o benchEncoder benchEncoder.c clientAPI.c ringBuffer.c encoder.c transport.c uringTransport.c
+	    inprocTransport.c replayTransport.c recorder.c latency.c logger.c arena.c -pthread
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "clientAPI.h"
+
+
+#define DEFAULT_MOVES 2000000
+#define OLD_BUFFER_SIZE 20000       /* size of the buffer of the previous sendString */
+
+
+static int devNull;
+static char oldBuffer[OLD_BUFFER_SIZE];
+
+
+/* Previous sendString: the buffer is zeroed, and the whole command formatted in it */
+static void oldSendString(const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	memset(oldBuffer, 0, OLD_BUFFER_SIZE);
+	vsprintf(oldBuffer, format, args);
+	va_end(args);
+	if (write(devNull, oldBuffer, strlen(oldBuffer)) < 0)
+		perror("benchEncoder");
+}
+
+
+/* Previous sendMove: the move is formatted in a string, given to sendString */
+static void oldSendMove(const int* values) {
+	char move[256];
+	sprintf(move, "%d %d %d %d %d", values[0], values[1], values[2], values[3], values[4]);
+	oldSendString("PLAY_MOVE %s", move);
+}
+
+
+/* sendCGSMoveValues without the answer: the move is encoded in the storage of the connection, and sent by writev */
+static void newSendMove(Connection* cnx, const int* values) {
+	queueMoveValues(cnx, __FUNCTION__, values, 5);
+	struct iovec iov = { cnx->out.data, cnx->out.len };
+	if (writev(devNull, &iov, 1) < 0)
+		perror("benchEncoder");
+}
+
+
+int main(int argc, char** argv) {
+	int moves = argc > 1 ? atoi(argv[1]) : DEFAULT_MOVES;
+	Connection cnx;
+	int values[5] = { 1, 0, 0, 0, 0 };
+
+	devNull = open("/dev/null", O_WRONLY);
+	encInit(&cnx.out, cnx.command, MAX_COMMAND);
+
+	uint64_t start = monotonicNs();
+	for (int i = 0; i < moves; i++) {
+		values[1] = i % 36;
+		values[2] = (i + 7) % 36;
+		values[3] = i % 10;
+		values[4] = i % 3;
+		oldSendMove(values);
+	}
+	uint64_t oldNs = monotonicNs() - start;
+
+	start = monotonicNs();
+	for (int i = 0; i < moves; i++) {
+		values[1] = i % 36;
+		values[2] = (i + 7) % 36;
+		values[3] = i % 10;
+		values[4] = i % 3;
+		newSendMove(&cnx, values);
+	}
+	uint64_t newNs = monotonicNs() - start;
+
+	printf("%d PLAY_MOVE to /dev/null: sprintf + vsprintf %.0f ns per move, encoder + writev %.0f ns per move\n",
+	       moves, (double) oldNs / moves, (double) newNs / moves);
+	close(devNull);
+	return EXIT_SUCCESS;
+}
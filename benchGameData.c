@@ -0,0 +1,194 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: benchGameData.c
+	Benchmark of the parsing of the data of the game (answer of GET_GAME_DATA): the incremental parser
+	(parseGameData, in the arena of the game) compared with the previous one (sscanf for each token, and a malloc
+	for each city name). The data is written by the local server (writeGameData) for the USA map, and for a synthetic
+	map of the size of the Europe map (47 cities, 101 tracks), that the local server does not have.
+	Both parsers are checked to give the same data, the new one with the data cut in two chunks at every position.
+	usage: benchGameData [parses]      (20000 parses of each map by default)
+
+	gcc -O2 -o benchGameData benchGameData.c ticketToRide.c clientAPI.c ringBuffer.c encoder.c eventLoop.c
+	    coroutine.c transport.c uringTransport.c inprocTransport.c replayTransport.c recorder.c latency.c
+	    logger.c localServer.c localGame.c localMaps.c boardView.c arena.c -pthread
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ticketToRide.h"
+#include "localGame.h"
+
+
+#define DEFAULT_PARSES 20000
+#define EUROPE_CITIES 47
+#define EUROPE_TRACKS 101
+#define EUROPE_OBJECTIVES 46
+
+
+/* data of the game, as read by the previous parser */
+typedef struct {
+	char** cityNames;
+	int* trackData;
+	CardColor faceUp[5];
+	CardColor cards[4];
+} OldData;
+
+
+/* Previous strCpyReplace: copy the name, with the '_' replaced by spaces */
+static void oldCopyName(char* dest, const char* src) {
+	for (; *src; src++)
+		*dest++ = (*src == '_') ? ' ' : *src;
+	*dest = '\0';
+}
+
+
+/* Previous parser of the data of the game: a sscanf for each token, a malloc for each name */
+static void oldParseGameData(int nbCities, int nbTracks, const char* data, OldData* old) {
+	int nbchar;
+	char city[64];
+	const char* p = data;
+
+	old->cityNames = malloc(nbCities * sizeof(char*));
+	for (int i = 0; i < nbCities; i++) {
+		sscanf(p, "%63s%n", city, &nbchar);
+		p += nbchar;
+		old->cityNames[i] = malloc(strlen(city) + 1);
+		oldCopyName(old->cityNames[i], city);
+	}
+	old->trackData = malloc(sizeof(int) * nbTracks * 5);
+	int* t = old->trackData;
+	for (int i = 0; i < nbTracks; i++, t += 5) {
+		sscanf(p, "%d %d %d %d %d %n", t, t + 1, t + 2, t + 3, t + 4, &nbchar);
+		p += nbchar;
+	}
+	int* f = (int*) old->faceUp;
+	sscanf(p, "%d %d %d %d %d %n", f, f + 1, f + 2, f + 3, f + 4, &nbchar);
+	p += nbchar;
+	int* c = (int*) old->cards;
+	sscanf(p, "%d %d %d %d", c, c + 1, c + 2, c + 3);
+}
+
+
+static void oldFreeGameData(int nbCities, OldData* old) {
+	for (int i = 0; i < nbCities; i++)
+		free(old->cityNames[i]);
+	free(old->cityNames);
+	free(old->trackData);
+}
+
+
+/* Prepare the context and the data of the game for the parsing (as parseGameSizes does) */
+static void initSizes(GameContext* game, GameData* gameData, const Map* map) {
+	game->nbCities = gameData->nbCities = map->nbCities;
+	game->nbTracks = gameData->nbTracks = map->nbTracks;
+}
+
+
+/* Check that the new parser gives the same data as the previous one, with the data cut in two chunks anywhere */
+static bool checkParser(GameContext* game, GameData* gameData, const char* data, int len, const OldData* old) {
+	for (int cut = 0; cut <= len; cut++) {
+		GameDataParser parser;
+		resetArena(&game->arena);
+		initGameDataParser(&parser, game, gameData);
+		feedGameData(&parser, data, cut);
+		feedGameData(&parser, data + cut, len - cut);
+		if (endGameData(&parser) != ALL_GOOD) {
+			printf("error with the data cut at %d\n", cut);
+			return false;
+		}
+		for (int i = 0; i < game->nbCities; i++)
+			if (strcmp(getCityName(game, i), old->cityNames[i]) != 0) {
+				printf("city %d: '%s' instead of '%s' (cut at %d)\n", i, getCityName(game, i), old->cityNames[i], cut);
+				return false;
+			}
+		if (memcmp(gameData->trackData, old->trackData, sizeof(int) * 5 * game->nbTracks) != 0
+		    || memcmp(game->faceUp, old->faceUp, sizeof(old->faceUp)) != 0
+		    || memcmp(gameData->cards, old->cards, sizeof(old->cards)) != 0) {
+			printf("different data with the data cut at %d\n", cut);
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/* Parse `parses` times the data of the map with each parser, and print their time */
+static bool benchMap(const Map* map, int parses) {
+	static LocalGame local;
+	static char data[65536];
+	GameContext game;
+	GameData gameData;
+	OldData old;
+
+	initLocalGame(&local, map, 12345, 0);
+	int len = writeGameData(&local, data, sizeof(data));
+	memset(&game, 0, sizeof(game));
+	memset(&gameData, 0, sizeof(gameData));
+	initArena(&game.arena);
+	initSizes(&game, &gameData, map);
+
+	oldParseGameData(map->nbCities, map->nbTracks, data, &old);
+	bool same = checkParser(&game, &gameData, data, len, &old);
+	oldFreeGameData(map->nbCities, &old);
+	if (!same) {
+		freeArena(&game.arena);
+		return false;
+	}
+
+	uint64_t start = monotonicNs();
+	for (int i = 0; i < parses; i++) {
+		oldParseGameData(map->nbCities, map->nbTracks, data, &old);
+		oldFreeGameData(map->nbCities, &old);
+	}
+	uint64_t oldNs = monotonicNs() - start;
+
+	/* the arena is reset by each new game (resetGameData) */
+	start = monotonicNs();
+	for (int i = 0; i < parses; i++) {
+		resetArena(&game.arena);
+		parseGameData(&game, data, len, &gameData);
+	}
+	uint64_t newNs = monotonicNs() - start;
+
+	printf("%-7s (%d cities, %d tracks, %d bytes): sscanf %.2f us, incremental %.2f us\n", map->name,
+	       map->nbCities, map->nbTracks, len, oldNs / 1000.0 / parses, newNs / 1000.0 / parses);
+	freeArena(&game.arena);
+	return true;
+}
+
+
+int main(int argc, char** argv) {
+	int parses = argc > 1 ? atoi(argv[1]) : DEFAULT_PARSES;
+
+	/* synthetic map of the size of the Europe map (the names are longer than the USA ones) */
+	static char names[EUROPE_CITIES][32];
+	static const char* cities[EUROPE_CITIES];
+	static int tracks[EUROPE_TRACKS][5];
+	static int objectives[EUROPE_OBJECTIVES][3];
+	for (int i = 0; i < EUROPE_CITIES; i++) {
+		snprintf(names[i], sizeof(names[i]), "Europe City Name %d", i);
+		cities[i] = names[i];
+	}
+	for (int i = 0; i < EUROPE_TRACKS; i++) {
+		tracks[i][0] = i % EUROPE_CITIES;
+		tracks[i][1] = (7 * i + 1) % EUROPE_CITIES;
+		tracks[i][2] = 1 + i % 6;
+		tracks[i][3] = 1 + i % 9;
+		tracks[i][4] = (i % 3) ? NONE : 2;
+	}
+	for (int i = 0; i < EUROPE_OBJECTIVES; i++) {
+		objectives[i][0] = i;
+		objectives[i][1] = (i + 5) % EUROPE_CITIES;
+		objectives[i][2] = 5 + i % 15;
+	}
+	const Map europe = { "Europe", 45, EUROPE_CITIES, cities, EUROPE_TRACKS, (const int (*)[5]) tracks,
+	                     EUROPE_OBJECTIVES, (const int (*)[3]) objectives };
+
+	printf("%d parses of the data of each map\n", parses);
+	if (!benchMap(&mapUSA, parses) || !benchMap(&europe, parses))
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
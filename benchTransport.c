@@ -0,0 +1,120 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: benchTransport.c
+	Benchmark of the transports of the client API (see transport.h): PLAY_MOVE round trips with each of them, to a
+	loopback TCP server that answers at once (it does not play the moves: only the exchanges are measured)
+	usage: benchTransport [moves [port]]      (100000 moves, port 15099 by default)
+
+	gcc -O2 -o benchTransport benchTransport.c clientAPI.c ringBuffer.c encoder.c transport.c uringTransport.c
+	    inprocTransport.c replayTransport.c recorder.c latency.c logger.c arena.c -pthread
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "clientAPI.h"
+
+
+#define DEFAULT_MOVES 100000
+#define DEFAULT_PORT 15099
+#define WARMUP 1000                 /* moves played before the measure */
+
+
+/* answers of the server, framed (header: size in decimal on 6 characters): a move is acknowledged, with an empty
+ * answer and the code of a normal move; the other commands are only acknowledged */
+static const char moveAnswer[] = "     2OK     0     10";
+static const char ackAnswer[] = "     2OK";
+
+
+/* Server: each read is a command (the client waits for the answer before sending the next one) */
+static void* serveClient(void* arg) {
+	int fd = (int) (long) arg;
+	char cmd[MAX_COMMAND + 256];
+	ssize_t r;
+	int one = 1;
+
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	while ((r = read(fd, cmd, sizeof(cmd))) > 0) {
+		const char* answer = (r >= 9 && strncmp(cmd, "PLAY_MOVE", 9) == 0) ? moveAnswer : ackAnswer;
+		size_t n = strlen(answer);
+		if (write(fd, answer, n) != (ssize_t) n)
+			break;
+	}
+	close(fd);
+	return NULL;
+}
+
+
+/* Server: accept the clients (one per transport measured) */
+static void* acceptClients(void* arg) {
+	int s = (int) (long) arg;
+	int c;
+	while ((c = accept(s, NULL, NULL)) >= 0) {
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, serveClient, (void*) (long) c) == 0)
+			pthread_detach(thread);
+		else
+			close(c);
+	}
+	return NULL;
+}
+
+
+/* Play `moves` round trips with the transport, and print their time */
+static void benchTransport(const char* transport, unsigned int port, int moves) {
+	Connection cnx;
+	char answer[MAX_MESSAGE];
+	const int values[5] = { 1, 2, 3, 4, 0 };      /* a claim of a route (its values are not checked) */
+
+	if (!selectTransport(transport)) {
+		printf("%-9s not available\n", transport);
+		return;
+	}
+	connectToCGSServer(&cnx, __FUNCTION__, "127.0.0.1", port, "bench");
+	for (int i = 0; i < WARMUP; i++)
+		sendCGSMoveValues(&cnx, __FUNCTION__, values, 5, answer);
+	latInit(&cnx.latency);
+
+	uint64_t start = monotonicNs();
+	for (int i = 0; i < moves; i++)
+		if (sendCGSMoveValues(&cnx, __FUNCTION__, values, 5, answer) != NORMAL_MOVE)
+			dispError(&cnx, __FUNCTION__, "Unexpected answer to the move %d", i);
+	uint64_t ns = monotonicNs() - start;
+
+	/* the transport actually used (io_uring falls back to the socket if it cannot be set up) */
+	printf("%-9s (%s): %.2f us per move\n", transport, cnx.transport->name, ns / 1000.0 / moves);
+	latPrint(&cnx.latency, stdout, transport);
+	closeCGSConnection(&cnx, __FUNCTION__);
+}
+
+
+int main(int argc, char** argv) {
+	int moves = argc > 1 ? atoi(argv[1]) : DEFAULT_MOVES;
+	unsigned int port = argc > 2 ? atoi(argv[2]) : DEFAULT_PORT;
+
+	/* loopback server */
+	int s = socket(AF_INET, SOCK_STREAM, 0);
+	int one = 1;
+	struct sockaddr_in address = { .sin_family = AF_INET, .sin_port = htons(port) };
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (s < 0 || bind(s, (struct sockaddr*) &address, sizeof(address)) < 0 || listen(s, 4) < 0) {
+		perror("benchTransport: server");
+		return EXIT_FAILURE;
+	}
+	pthread_t server;
+	pthread_create(&server, NULL, acceptClients, (void*) (long) s);
+
+	printf("%d PLAY_MOVE round trips on the loopback\n", moves);
+	benchTransport("socket", port, moves);
+	benchTransport("io_uring", port, moves);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,317 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: boardView.c
+	Board tracked and drawn by the client (see boardView.h)
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "boardView.h"
+
+
+static const char* const colorNames[LOCOMOTIVE + 1] = {
+	"None", "Purple", "White", "Blue", "Yellow", "Orange", "Black", "Red", "Green", "Locomotive"
+};
+
+/* ANSI colors of the cards (the gray tracks are LOCOMOTIVE) */
+static const char* const colorCodes[LOCOMOTIVE + 1] = {
+	"", "\e[35m", "\e[97m", "\e[34m", "\e[33m", "\e[38;5;208m", "\e[90m", "\e[31m", "\e[32m", "\e[1m"
+};
+
+#define RESET "\e[0m"
+
+
+/* Append a formatted text to the frame being drawn (the frame grows if needed)
+ * Returns false if it cannot be allocated */
+static bool appendf(BoardView* view, const char* format, ...) {
+	va_list args;
+	for(;;) {
+		size_t room = view->nextSize - view->nextLen;
+		va_start(args, format);
+		int n = vsnprintf(view->next ? view->next + view->nextLen : NULL, room, format, args);
+		va_end(args);
+		if (n < 0)
+			return false;
+		if ((size_t) n < room) {
+			view->nextLen += n;
+			return true;
+		}
+		size_t size = view->nextSize ? 2 * view->nextSize : 4096;
+		while (size < view->nextLen + n + 1)
+			size *= 2;
+		char* next = realloc(view->next, size);
+		if (!next)
+			return false;
+		view->next = next;
+		view->nextSize = size;
+	}
+}
+
+
+/* Name of a color, colored if needed */
+static void appendColor(BoardView* view, CardColor color, bool ansi) {
+	if (color < NONE || color > LOCOMOTIVE)
+		color = NONE;
+	if (ansi)
+		appendf(view, "%s%s" RESET, colorCodes[color], colorNames[color]);
+	else
+		appendf(view, "%s", colorNames[color]);
+}
+
+
+/* Name of a city (its id if the name is unknown) */
+static void appendCity(BoardView* view, int city, int width) {
+	const char* name = getCityName(view->game, city);
+	if (name)
+		appendf(view, "%-*s", width, name);
+	else
+		appendf(view, "%-*d", width, city);
+}
+
+
+/* Find the free track between two cities that can be claimed with `color` (-1 if none) */
+static int findTrack(const BoardView* view, int from, int to, CardColor color) {
+	int found = -1;
+	for (int t = 0; t < view->nbTracks; t++) {
+		const int* tr = view->tracks + 5 * t;
+		if (view->owner[t] >= 0 || !((tr[0] == from && tr[1] == to) || (tr[0] == to && tr[1] == from)))
+			continue;
+		if (color == LOCOMOTIVE || tr[3] == LOCOMOTIVE || tr[3] == (int) color || tr[4] == LOCOMOTIVE || tr[4] == (int) color)
+			return t;
+		found = t;
+	}
+	return found;
+}
+
+
+/* Draw the whole board in `next` */
+static void drawFrame(BoardView* view, bool ansi) {
+	BoardState board;
+	getBoardState(view->game, &board);
+
+	view->nextLen = 0;
+	appendf(view, "Face up cards:");
+	for (int i = 0; i < 5; i++) {
+		appendf(view, " ");
+		appendColor(view, board.card[i], ansi);
+	}
+	appendf(view, "\n");
+	for (int p = 0; p < 2; p++)
+		appendf(view, "%s: %d wagons, %d cards, %d objectives\n", p ? "Opponent" : "You", view->players[p].wagons,
+		        view->players[p].nbCards, view->players[p].nbObjectives);
+
+	appendf(view, "Your cards:");
+	for (int c = PURPLE; c <= LOCOMOTIVE; c++)
+		if (view->cards[c] > 0) {
+			appendf(view, " %d ", view->cards[c]);
+			appendColor(view, c, ansi);
+		}
+	appendf(view, "\nYour objectives:\n");
+	for (int k = 0; k < view->players[0].nbObjectives && k < BOARD_MAX_OBJECTIVES; k++) {
+		appendf(view, "  ");
+		appendCity(view, view->objectives[k].from, 0);
+		appendf(view, " -> ");
+		appendCity(view, view->objectives[k].to, 0);
+		appendf(view, " (%d points)\n", view->objectives[k].score);
+	}
+
+	appendf(view, "Routes:\n");
+	for (int t = 0; t < view->nbTracks; t++) {
+		const int* tr = view->tracks + 5 * t;
+		appendf(view, "  ");
+		appendCity(view, tr[0], 16);
+		appendf(view, " - ");
+		appendCity(view, tr[1], 16);
+		appendf(view, " %d ", tr[2]);
+		appendColor(view, tr[3], ansi);
+		if (tr[4] != NONE) {
+			appendf(view, "/");
+			appendColor(view, tr[4], ansi);
+		}
+		if (view->owner[t] == 0)
+			appendf(view, ansi ? "  \e[1;7m you " RESET "\n" : "  [you]\n");
+		else if (view->owner[t] == 1)
+			appendf(view, ansi ? "  \e[7m opponent " RESET "\n" : "  [opponent]\n");
+		else
+			appendf(view, "\n");
+	}
+}
+
+
+/* Length of the line beginning at `p` (without its '\n'), in a text ending at `end` */
+static size_t lineLength(const char* p, const char* end) {
+	const char* nl = memchr(p, '\n', end - p);
+	return nl ? (size_t) (nl - p) : (size_t) (end - p);
+}
+
+
+/* Write the lines of `next` that differ from the last frame (the cursor is moved to each of them) */
+static void writeChanges(BoardView* view) {
+	const char *old = view->frame, *oldEnd = view->frame + view->frameLen;
+	const char *cur = view->next, *curEnd = view->next + view->nextLen;
+	char move[32];
+	int row = 1;
+
+	for (; cur < curEnd; row++) {
+		size_t n = lineLength(cur, curEnd);
+		size_t m = old < oldEnd ? lineLength(old, oldEnd) : (size_t) -1;
+		if (n != m || memcmp(cur, old, n) != 0) {
+			logBytes(move, snprintf(move, sizeof(move), "\e[%d;1H", row));
+			logBytes(cur, n);
+			logBytes("\e[K\n", 4);
+		}
+		cur += n + 1;
+		if (old < oldEnd)
+			old += m + 1;
+	}
+	/* clear what remains of the last frame, and leave the cursor below the frame */
+	logBytes(move, snprintf(move, sizeof(move), "\e[%d;1H\e[J", row));
+}
+
+
+
+/* -------------------------------------
+ * Initialize the board, from the data of the game (to be called after sendGameSettings)
+ *
+ * Parameters:
+ * - view: (BoardView*) the board (allocated by the user)
+ * - game: (GameContext*) context of the game
+ * - gameData: (GameData*) the data of the game (the track data is copied, in the arena of the game)
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode initBoardView(BoardView* view, GameContext* game, const GameData* gameData) {
+	memset(view, 0, sizeof(BoardView));
+	view->game = game;
+	view->nbTracks = gameData->nbTracks;
+	view->tracks = arenaAlloc(&game->arena, 5 * gameData->nbTracks * sizeof(int));
+	view->owner = arenaAlloc(&game->arena, gameData->nbTracks);
+	if (!view->tracks || !view->owner) {
+		freeBoardView(view);
+		return MEMORY_ALLOCATION_ERROR;
+	}
+	memcpy(view->tracks, gameData->trackData, 5 * gameData->nbTracks * sizeof(int));
+	memset(view->owner, -1, gameData->nbTracks);
+
+	for (int p = 0; p < 2; p++) {
+		view->players[p].wagons = 45;
+		view->players[p].nbCards = 4;
+	}
+	for (int i = 0; i < 4; i++)
+		if (gameData->cards[i] >= PURPLE && gameData->cards[i] <= LOCOMOTIVE)
+			view->cards[gameData->cards[i]]++;
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Update the board with a move (when the move is a NORMAL_MOVE)
+ *
+ * Parameters:
+ * - view: (BoardView*) the board
+ * - player: (int) 0 for our move (sendMove), 1 for the opponent's one (getMove)
+ * - moveData: (MoveData*) the move
+ * - moveResult: (MoveResult*) its result
+ */
+void boardViewMove(BoardView* view, int player, const MoveData* moveData, const MoveResult* moveResult) {
+	BoardPlayer* p = &view->players[player];
+	if (moveResult->state != NORMAL_MOVE)
+		return;
+
+	switch (moveData->action) {
+		case CLAIM_ROUTE: {
+			const ClaimRouteMove* claim = &moveData->claimRoute;
+			int t = findTrack(view, claim->from, claim->to, claim->color);
+			if (t < 0)
+				break;
+			int length = view->tracks[5 * t + 2];
+			view->owner[t] = player;
+			p->wagons -= length;
+			p->nbCards -= length;
+			if (player == 0) {
+				view->cards[LOCOMOTIVE] -= claim->nbLocomotives;
+				if (claim->color != LOCOMOTIVE)
+					view->cards[claim->color] -= length - claim->nbLocomotives;
+			}
+			break;
+		}
+
+		case DRAW_BLIND_CARD:
+		case DRAW_CARD: {
+			CardColor card = moveData->action == DRAW_CARD ? moveData->drawCard : moveResult->card;
+			p->nbCards++;
+			if (player == 0 && card >= PURPLE && card <= LOCOMOTIVE)
+				view->cards[card]++;
+			break;
+		}
+
+		case DRAW_OBJECTIVES:
+			if (player == 0)
+				memcpy(view->drawn, moveResult->objectives, sizeof(view->drawn));
+			break;
+
+		case CHOOSE_OBJECTIVES:
+			for (int i = 0; i < 3; i++)
+				if (moveData->chooseObjectives[i]) {
+					if (player == 0 && p->nbObjectives < BOARD_MAX_OBJECTIVES)
+						view->objectives[p->nbObjectives] = view->drawn[i];
+					p->nbObjectives++;
+				}
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+/* -------------------------------------
+ * Draw the board (through the logger, see logger.h)
+ *
+ * Parameters:
+ * - view: (BoardView*) the board
+ * - flags: (int) BOARD_COLOR for ANSI colors, BOARD_INCREMENTAL to only redraw the lines that have changed since the
+ *          last frame (the first frame clears the screen)
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode renderBoard(BoardView* view, int flags) {
+	drawFrame(view, flags & BOARD_COLOR);
+	if (!view->next)
+		return MEMORY_ALLOCATION_ERROR;
+
+	if (!(flags & BOARD_INCREMENTAL))
+		logBytes(view->next, view->nextLen);
+	else {
+		if (!view->frame)
+			logBytes("\e[H\e[2J", 7);
+		writeChanges(view);
+	}
+
+	/* the frame drawn is kept, to be compared with the next one */
+	char* frame = view->frame;
+	size_t size = view->frame ? view->nextSize : 0;
+	view->frame = view->next;
+	view->frameLen = view->nextLen;
+	view->next = frame;
+	view->nextSize = size;
+	view->nextLen = 0;
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Free the board
+ *
+ * Parameters:
+ * - view: (BoardView*) the board
+ */
+void freeBoardView(BoardView* view) {
+	free(view->frame);
+	free(view->next);
+	view->tracks = NULL;        /* in the arena of the game */
+	view->owner = NULL;
+	view->frame = view->next = NULL;
+}
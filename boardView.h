@@ -0,0 +1,69 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: boardView.h
+	Board tracked and drawn by the client, without asking the server (DISP_GAME)
+
+	The board is built from the game data, and updated with each move (ours and the opponent's): owner of each
+	track, cards and objectives in our hand, number of wagons, cards and objectives of each player (the face-up cards
+	are the ones of `getBoardState`). It is drawn as text, with ANSI colors or not. In incremental mode, only the lines
+	that have changed since the last frame are redrawn (the frame should then stay at the top of the terminal).
+
+	Usage:
+	    BoardView view;
+	    initBoardView(&view, &game, &gameData);      // after sendGameSettings
+	    ...
+	    sendMove(&game, &move, &result);
+	    boardViewMove(&view, 0, &move, &result);    // 0 for our moves, 1 for the opponent's ones
+	    renderBoard(&view, BOARD_COLOR | BOARD_INCREMENTAL);
+	    ...
+	    freeBoardView(&view);
+*/
+
+#ifndef __BOARD_VIEW_H__
+#define __BOARD_VIEW_H__
+
+#include "ticketToRide.h"
+
+
+#define BOARD_MAX_OBJECTIVES 32     /* maximum number of our objectives tracked */
+
+/* flags of renderBoard */
+#define BOARD_COLOR 0x1             /* ANSI colors */
+#define BOARD_INCREMENTAL 0x2       /* only redraw the lines that have changed since the last frame */
+
+
+/* a player, as seen by the client */
+typedef struct {
+    int wagons;
+    int nbCards;
+    int nbObjectives;
+} BoardPlayer;
+
+
+/* the board */
+typedef struct {
+    GameContext* game;                  /* context of the game (names of the cities, face-up cards) */
+    int nbTracks;
+    int* tracks;                        /* copy of the track data (5 integers per track, see GameData), in game->arena */
+    signed char* owner;                 /* owner of each track (0: us, 1: the opponent, -1: nobody) */
+    BoardPlayer players[2];             /* 0: us, 1: the opponent */
+    int cards[LOCOMOTIVE + 1];          /* our cards, by color */
+    Objective objectives[BOARD_MAX_OBJECTIVES];     /* our objectives */
+    Objective drawn[3];                 /* objectives we have drawn, and not yet chosen */
+    char* frame;                        /* last frame drawn (NULL if none) */
+    size_t frameLen;
+    char* next;                         /* frame being drawn */
+    size_t nextLen;
+    size_t nextSize;
+} BoardView;
+
+
+/* prototypes */
+ResultCode initBoardView(BoardView* view, GameContext* game, const GameData* gameData);
+void boardViewMove(BoardView* view, int player, const MoveData* moveData, const MoveResult* moveResult);
+ResultCode renderBoard(BoardView* view, int flags);
+void freeBoardView(BoardView* view);
+
+
+#endif
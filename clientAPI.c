@@ -23,43 +23,52 @@ Copyright 2016-2020 T. Hilaire, J. Brajard
 #include <stdio.h>
 #include <stdlib.h>
 
-#include <netdb.h>
-#include <netinet/in.h>
+#include <errno.h>
 
 #include <string.h>
 #include <unistd.h>
 #include <stdarg.h>
+#include <sys/uio.h>
 
 #include "clientAPI.h"
-
-#define h_addr h_addr_list[0] /* for backward compatibility */
+#include "ringBuffer.h"
+#include "encoder.h"
+#include "arena.h"
 
 #define HEAD_SIZE 6 			/*number of bytes to code the size of the message (header)*/
-#define MAX_LENGTH 20000 		/* maximum size of the buffer expected for print_Game */
 
 
 
-/* global variables about the connection
- * we use them just to hide all the connection details to the user
- * so no need to know about them, or give them when we use the functions of this API
+/* global variables
+ * everything about a connection is stored in its `Connection` (so several connections can be used at the same time),
+ * only the debug level is shared
 */
-int sockfd = -1;		        /* socket descriptor, equal to -1 when we are not yet connected */
-char buffer[MAX_LENGTH];		/* global buffer used to send message (global so that it is not allocated/desallocated for each message) */
 int DEBUG_LEVEL = NO_DEBUG;			        /* debug constant; we do not use here a #DEFINE, since it allows the client to declare 'extern int debug;' set it to 1 to have debug information, without having to re-compile labyrinthAPI.c */
-char playerName[21] = {};       /* name of the player, stored to display it in debug */
 
 
-/* Display Error message and exit
+static _Thread_local ErrorTrap* errorTrap = NULL;      /* error trap of the thread (NULL: an error exits) */
+
+
+/* Display Error message and exit (or jump to the error trap of the thread, see setErrorTrap)
  *
  * Parameters:
+ * - cnx: connection concerned (used to display the player's name), or NULL
  * - fct: name of the function where the error raises (__FUNCTION__ can be used)
  * - msg: message to display
  * - ...: extra parameters to give to printf...
 */
-void dispError(const char* fct, const char* msg, ...) {
+void dispError(const Connection* cnx, const char* fct, const char* msg, ...) {
 	va_list args;
+	allowHeap();        /* the error is reported even during a game loop that forbids the heap (see arena.h) */
+	logFlush();
 	va_start(args, msg);
-	fprintf(stderr, "\e[5m\e[31m\u2327\e[2m [%s] (%s)\e[0m ", playerName, fct);
+	fprintf(stderr, "\e[5m\e[31m\u2327\e[2m [%s] (%s)\e[0m ", cnx ? cnx->playerName : "", fct);
+	if (errorTrap) {
+		vsnprintf(errorTrap->message, sizeof(errorTrap->message), msg, args);
+		va_end(args);
+		fprintf(stderr, "%s\n", errorTrap->message);
+		longjmp(errorTrap->env, 1);
+	}
 	vfprintf(stderr, msg, args);
 	fprintf(stderr, "\n");
 	va_end(args);
@@ -67,143 +76,375 @@ void dispError(const char* fct, const char* msg, ...) {
 }
 
 
-/* Display Debug message (only if `debug` constant is set to 1)
+/* Set the error trap of the calling thread: its errors (see dispError) are then reported by a longjmp to `trap->env`
+ * (set by setjmp before), with their message in `trap->message`, instead of exiting the program. The connection
+ * concerned is then in an unknown state: it can only be closed.
+ *
+ * Parameters:
+ * - trap: the trap (allocated by the user), or NULL to remove it (the errors exit again)
+*/
+void setErrorTrap(ErrorTrap* trap) {
+	errorTrap = trap;
+}
+
+
+/* Display Debug message (called by the macro dispDebug, only if its level is not above DEBUG_LEVEL)
+ * The message is written by the logger (see logger.h)
  *
  * Parameters:
+ * - cnx: connection concerned (used to display the player's name), or NULL
  * - fct: name of the function where the error raises (__FUNCTION__ can be used)
- * - level : debug level (print if debug>=level, level=0 always print)
  * - msg: message to display
  * - ...: extra parameters to give to printf...
 */
-void dispDebug(const char* fct, int level, const char* msg, ...) {
-  if (DEBUG_LEVEL>=level)	{
-		printf("\e[35m\u26A0\e[0m [%s] (%s) ", playerName, fct);
-
-		/* print the msg, using the varying number of parameters */
-		va_list args;
-		va_start(args, msg);
-		vprintf(msg, args);
-		va_end(args);
+void dispDebugMessage(const Connection* cnx, const char* fct, const char* msg, ...) {
+	char text[1024];
+
+	/* format the msg, using the varying number of parameters */
+	va_list args;
+	va_start(args, msg);
+	vsnprintf(text, sizeof(text), msg, args);
+	va_end(args);
+
+	logWrite("\e[35m\u26A0\e[0m [%s] (%s) %s\n", cnx ? cnx->playerName : "", fct, text);
+}
 
-		printf("\n");
+/* Read from the socket until (at least) `want` bytes are available in the receive ring
+ * A single `read` gets everything the kernel already has (several messages, typically)
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ * - fct : name of the calling function
+ * - want : number of bytes that should be available
+*/
+static void fillRing(Connection* cnx, const char *fct, size_t want) {
+	while (rbAvailable(&cnx->ring) < want) {
+		size_t room;
+		char* p = rbWritePtr(&cnx->ring, &room);
+		ssize_t r = cnx->transport->read(cnx, p, room);
+		if (r <= 0)
+			dispError(cnx, fct, "Cannot read message (server has failed?)");
+		rbCommit(&cnx->ring, r);
 	}
 }
 
+
+/* Parse the header of a message (its size, in decimal), already in the receive ring
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ * - fct : name of the calling function
+*/
+static void parseHeader(Connection* cnx, const char *fct) {
+	const char* head = rbTake(&cnx->ring, HEAD_SIZE);
+	while (*head == ' ')
+		head++;
+	if (*head < '0' || *head > '9')
+		dispError(cnx, fct, "Cannot read message's length (server has failed?)");
+	while (*head >= '0' && *head <= '9')
+		cnx->length = 10 * cnx->length + (*head++ - '0');
+	dispDebug(cnx, fct, 3, "prepare to receive a message of length :%lu", cnx->length);
+}
+
+
+/* Get the next chunk of the message being received (or of the next message)
+ * The chunk is a view inside the receive ring (no copy): it is NUL-terminated, and is valid until the next
+ * reception.
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ * - fct : name of the calling function
+ * - nmax : maximum size of the chunk
+ * - n : filled with the size of the chunk
+ *
+ * Return the view on the chunk
+*/
+static const char* nextChunk(Connection* cnx, const char *fct, size_t nmax, size_t* n) {
+	if (!cnx->length) {
+		fillRing(cnx, fct, HEAD_SIZE);
+		parseHeader(cnx, fct);
+		if (cnx->recorder)
+			recordFrame(cnx->recorder, cnx->length);
+	}
+	*n = cnx->length < nmax ? cnx->length : nmax;
+	if (*n > RING_BUFFER_SIZE)
+		*n = RING_BUFFER_SIZE;
+	fillRing(cnx, fct, *n);
+	cnx->length -= *n; // length to be read again
+	const char* chunk = rbTake(&cnx->ring, *n);
+	if (cnx->recorder)
+		recordBytes(cnx->recorder, chunk, *n);
+	return chunk;
+}
+
+
+/* Receive a message, as a view inside the receive ring (no copy)
+ * The view is NUL-terminated and valid until the next reception.
+ * Messages bigger than the ring are received by chunks (the function should be called again while the remaining
+ * length is not 0)
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ * - fct : name of the calling function
+ * - view: filled with the pointer to the message
+ * - nview: filled with the size of the message (can be NULL)
+ *
+ * Return the remaining length of the message (0 is the message is completely read)
+*/
+size_t recvFrame(Connection* cnx, const char *fct, const char** view, size_t* nview) {
+	size_t n;
+	*view = nextChunk(cnx, fct, RING_BUFFER_SIZE, &n);
+	if (nview)
+		*nview = n;
+	return cnx->length;
+}
+
+
 /* Read the message and fill the buffer
 * Parameters:
+* - cnx: connection to the server
 * - fct : name of the calling function
 * - buf: pointer to the buffer variable (already allocated)
 * - nbuf : size of the buffer
 *
 * Return the remaining length of the message (0 is the message is completely read)
 */
-size_t read_inbuf(const char *fct, char *buf, size_t nbuf) {
-	static char stream_size[HEAD_SIZE];		/* size of the message to be received, static to avoid allocate memory at each call*/
-	ssize_t r;
-	static size_t length=0 ; 				/* static because some length has to be read again */
-	if (!length) {
-		bzero(stream_size, HEAD_SIZE);
-		r = read(sockfd, stream_size, HEAD_SIZE);
+size_t read_inbuf(Connection* cnx, const char *fct, char *buf, size_t nbuf) {
+	size_t n;
+	const char* chunk = nextChunk(cnx, fct, nbuf, &n);
+	memcpy(buf, chunk, n);
+	if (n < nbuf)
+		buf[n] = '\0';
+	return cnx->length;
+}
+
+
+/* Read (without blocking) everything the kernel has for this connection
+ * Used in non-blocking mode (the socket is non-blocking)
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ *
+ * Return the number of bytes received, or -1 if the connection is closed (or has failed)
+*/
+ssize_t recvAvailable(Connection* cnx) {
+	ssize_t total = 0;
+	for(;;) {
+		size_t room;
+		char* p = rbWritePtr(&cnx->ring, &room);
+		if (room == 0)
+			return total;
+		ssize_t r = read(cnx->sockfd, p, room);
 		if (r < 0)
-			dispError (fct, "Cannot read message's length (server has failed?)");
-		r = sscanf (stream_size, "%lu", &length);
-		if (r != 1)
-			dispError (fct, "Cannot read message's length (server has failed?)");
-		dispDebug (fct, 3, "prepare to receive a message of length :%lu",length);
+			return (errno == EAGAIN || errno == EWOULDBLOCK) ? total : -1;
+		if (r == 0)
+			return -1;
+		rbCommit(&cnx->ring, r);
+		total += r;
 	}
-	size_t mini = length > nbuf ? nbuf: length;
-	unsigned int read_length = 0;
-	bzero(buf, nbuf);
-	do {
-		r = read(sockfd, buf + read_length, mini-read_length);
-		if (r < 0)
-			dispError(fct, "Cannot read message (called by : %s)");
-		read_length += r;
-	} while (read_length < mini);
-  
-	length -= mini; // length to be read again
-	return length;
 }
 
 
-/* Send a string through the open socket and get acknowledgment (OK)
+/* Get a message, only if it has been completely received (non-blocking mode)
+ * The message is a view inside the receive ring (as for recvFrame). It should not be bigger than the ring.
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ * - fct : name of the calling function
+ * - view: filled with the pointer to the message
+ * - nview: filled with the size of the message (can be NULL)
+ *
+ * Return true if a message is given, false if it is not yet completely received
+*/
+bool tryRecvFrame(Connection* cnx, const char *fct, const char** view, size_t* nview) {
+	if (!cnx->length) {
+		if (rbAvailable(&cnx->ring) < HEAD_SIZE)
+			return false;
+		parseHeader(cnx, fct);
+	}
+	if (cnx->length > RING_BUFFER_SIZE)
+		dispError(cnx, fct, "Message too long (%lu bytes) for the non-blocking mode", cnx->length);
+	if (rbAvailable(&cnx->ring) < cnx->length)
+		return false;
+	*view = rbTake(&cnx->ring, cnx->length);
+	if (nview)
+		*nview = cnx->length;
+	if (cnx->recorder) {
+		recordFrame(cnx->recorder, cnx->length);
+		recordBytes(cnx->recorder, *view, cnx->length);
+	}
+	cnx->length = 0;
+	return true;
+}
+
+
+/* Send a command through the open socket and get acknowledgment (OK)
+ * The command is given as pieces (iovec), sent all at once by the transport (a single `writev` for the socket), so
+ * that string arguments given by the user do not have to be copied
  * Manage connection problems
  *
  * Parameters:
- * - fct: name of the function that calls sendString (used for the logging)
- * - str: string to send
- * - ...:  accept extra parameters for str (string expansion)
+ * - cnx: connection to the server
+ * - fct: name of the function that calls sendCommand (used for the logging)
+ * - iov: pieces of the command
+ * - niov: number of pieces
  */
-void sendString(const char* fct, const char* str, ...) {
-	va_list args;
-	va_start(args, str);
-	bzero(buffer, MAX_LENGTH);
-	vsprintf(buffer, str, args);
-	/* check if the socket is open */
-	if (sockfd < 0)
-		dispError( fct, "The connection to the server is not established. Call 'connectToServer' before !");
-
-	/* send our message */
-	ssize_t r = write(sockfd, buffer, strlen(buffer));
-	dispDebug(fct,2, "Send '%s' to the server", buffer);
+static void sendCommand(Connection* cnx, const char* fct, const struct iovec* iov, int niov) {
+	/* check if the connection is open */
+	if (!cnx->transport)
+		dispError(cnx, fct, "The connection to the server is not established. Call 'connectToServer' before !");
+
+	/* send our message (the transport may also receive the beginning of the answer) */
+	if (cnx->recorder)
+		recordCommand(cnx->recorder, iov, niov);
+	cnx->commandStart = monotonicNs();
+	ssize_t r = cnx->transport->exchange(cnx, iov, niov);
+	dispDebug(cnx, fct,2, "Send '%.*s%.*s' to the server", (int) iov[0].iov_len, (char*) iov[0].iov_base,
+	          niov > 1 ? (int) iov[1].iov_len : 0, niov > 1 ? (char*) iov[1].iov_base : "");
 	if (r < 0)
-		dispError(fct, "Cannot write to the socket (%s)", buffer);
+		dispError(cnx, fct, "Cannot write to the socket (%.*s)", (int) iov[0].iov_len, (char*) iov[0].iov_base);
 
 	/* get acknowledgment */
-	size_t rr = read_inbuf(fct, buffer, MAX_LENGTH);
+	const char* ack;
+	size_t nack;
+	size_t rr = recvFrame(cnx, fct, &ack, &nack);
 	if (rr > 0)
-	  dispError(fct, "Acknowledgement message too long (sending:%s,receive:%s)", str,buffer);
+	  dispError(cnx, fct, "Acknowledgement message too long (sending:%.*s,receive:%s)", (int) iov[0].iov_len, (char*) iov[0].iov_base, ack);
 
-	if (strcmp(buffer, "OK") != 0)
-		dispError(fct, "Error: The server does not acknowledge, but answered:\n%s",buffer);
+	if (nack != 2 || ack[0] != 'O' || ack[1] != 'K')
+		dispError(cnx, fct, "Error: The server does not acknowledge, but answered:\n%s", ack);
+	timeCommand(cnx, LATENCY_ACK);
 
-	dispDebug(fct, 3, "Receive acknowledgment from the server");
+	dispDebug(cnx, fct, 3, "Receive acknowledgment from the server");
+}
+
+
+/* Send a string through the open socket and get acknowledgment (OK)
+ * Manage connection problems
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ * - fct: name of the function that calls sendString (used for the logging)
+ * - cmd: the command to send (with its trailing space, if it has an argument)
+ * - arg: string argument of the command, or NULL
+ */
+void sendString(Connection* cnx, const char* fct, const char* cmd, const char* arg) {
+	struct iovec iov[2] = {
+		{ (void*) cmd, strlen(cmd) },
+		{ (void*) arg, arg ? strlen(arg) : 0 }
+	};
+	sendCommand(cnx, fct, iov, arg ? 2 : 1);
+}
+
+
+
+/* Prepare a command to be sent in non-blocking mode (the acknowledgment is not read)
+ * The command is built in the encoder of the connection, and sent by `flushCommand`
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ * - fct: name of the function that calls queueCommand (used for the logging)
+ * - cmd: the command to send (with its trailing space, if it has an argument)
+ * - arg: string argument of the command, or NULL
+ */
+void queueCommand(Connection* cnx, const char* fct, const char* cmd, const char* arg) {
+	encReset(&cnx->out);
+	encStr(&cnx->out, cmd);
+	if (arg)
+		encStr(&cnx->out, arg);
+	if (cnx->out.overflow)
+		dispError(cnx, fct, "The command is too long (%s)", cmd);
+	cnx->sent = 0;
+	cnx->commandStart = monotonicNs();
+	dispDebug(cnx, fct, 2, "Send '%s' to the server", encTerminate(&cnx->out));
+}
+
+
+/* Send (without blocking) what remains of the command prepared by queueCommand/queueMoveValues
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ *
+ * Returns 1 if the command is completely sent, 0 if a part remains (socket full), -1 if the connection has failed
+ */
+int flushCommand(Connection* cnx) {
+	while (cnx->sent < cnx->out.len) {
+		ssize_t r = write(cnx->sockfd, cnx->out.data + cnx->sent, cnx->out.len - cnx->sent);
+		if (r < 0)
+			return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+		cnx->sent += r;
+		if (cnx->sent == cnx->out.len && cnx->recorder) {
+			struct iovec iov = { cnx->out.data, cnx->out.len };
+			recordCommand(cnx->recorder, &iov, 1);
+		}
+	}
+	return 1;
+}
+
+
+/* Add the time elapsed since the last command has been sent to the latencies of the connection
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ * - command: the command timed (or LATENCY_ACK, for its acknowledgment)
+ */
+void timeCommand(Connection* cnx, LatencyCommand command) {
+	latAdd(&cnx->latency, command, monotonicNs() - cnx->commandStart);
 }
 
 
 
 /* -------------------------------------
- * Initialize connection with the server
+ * Open the connection with the server (without sending our name)
  * Quit the program if the connection to the server cannot be established
  *
  * Parameters:
- * - fct: name of the function that calls connectToCGS (used for the logging)
- * - serverName: (string) address of the server (it could be "localhost" if the server is run in local, or "pc4521.polytech.upmc.fr" if the server runs there)
+ * - cnx: connection to initialize (allocated by the caller)
+ * - fct: name of the function that calls openCGSConnection (used for the logging)
+ * - serverName: (string) address of the server
  * - port: (int) port number used for the connection
  * - name: (string) name of the bot : max 20 characters (checked by the server)
+ * - nonBlocking: true to have a non-blocking socket (the connection is then in progress when the function returns)
  */
-void connectToCGSServer(const char* fct, const char* serverName, unsigned int port, const char* name) {
-	struct sockaddr_in serv_addr;
-	struct hostent *server;
-
-	/* copy the name */
-	strncpy(playerName, name, 20);
-
-	dispDebug(fct,2, "Initiate connection with %s (port: %d)", serverName, port);
-
-	/* Create a socket point, TCP/IP protocol, connected */
-	sockfd = socket(AF_INET, SOCK_STREAM, 0);
-	if (sockfd < 0)
-		dispError(fct, "Impossible to open socket");
+void openCGSConnection(Connection* cnx, const char* fct, const char* serverName, unsigned int port, const char* name, bool nonBlocking) {
+	/* initialize the connection and copy the name */
+	rbInit(&cnx->ring);
+	encInit(&cnx->out, cnx->command, MAX_COMMAND);
+	cnx->length = 0;
+	cnx->sent = 0;
+	latInit(&cnx->latency);
+	strncpy(cnx->playerName, name, 20);
+	cnx->playerName[20] = '\0';
+
+	dispDebug(cnx, fct,2, "Initiate connection with %s (port: %d)", serverName, port);
+
+	/* connect with the transport that fits the address */
+	cnx->transport = transportFor(serverName, nonBlocking);
+	cnx->transportData = NULL;
+	cnx->sockfd = -1;
+	cnx->recorder = openSessionRecorder();
+	cnx->transport->connect(cnx, fct, serverName, port, nonBlocking);
+	dispDebug(cnx, fct, 2, "Use the transport '%s'", cnx->transport->name);
+}
 
-	/* Get the server */
-	server = gethostbyname(serverName);
-	if (server == NULL)
-		dispError(fct, "Unable to find the server by its name");
-	dispDebug(fct,1, "Open connection with the server %s", serverName);
 
-	/* Allocate sockaddr */
-	bzero((char *) &serv_addr, sizeof(serv_addr));
-	serv_addr.sin_family = AF_INET;
-	bcopy(server->h_addr, &serv_addr.sin_addr.s_addr, server->h_length);
-	serv_addr.sin_port = htons(port);
 
-	/* Now connect to the server */
-	if (connect(sockfd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0)
-		dispError(fct, "Connection to the server '%s' on port %d impossible.", serverName, port);
+/* -------------------------------------
+ * Initialize connection with the server
+ * Quit the program if the connection to the server cannot be established
+ *
+ * Parameters:
+ * - cnx: connection to initialize (allocated by the caller)
+ * - fct: name of the function that calls connectToCGS (used for the logging)
+ * - serverName: (string) address of the server (it could be "localhost" if the server is run in local, or "pc4521.polytech.upmc.fr" if the server runs there)
+ * - port: (int) port number used for the connection
+ * - name: (string) name of the bot : max 20 characters (checked by the server)
+ */
+void connectToCGSServer(Connection* cnx, const char* fct, const char* serverName, unsigned int port, const char* name) {
+	openCGSConnection(cnx, fct, serverName, port, name, false);
 
 	/* Sending our name */
-	sendString(fct, "CLIENT_NAME %s",name);
+	sendString(cnx, fct, "CLIENT_NAME ", name);
 }
 
 
@@ -212,12 +453,16 @@ void connectToCGSServer(const char* fct, const char* serverName, unsigned int po
  * to do, because we are polite
  *
  * Parameters:
+ * - cnx: connection to the server
  * - fct: name of the function that calls closeCGSConnection (used for the logging)
 */
-void closeCGSConnection(const char* fct) {
-	if (sockfd<0)
-		dispError(fct,"The connection to the server is not established. Call 'connectToServer' before !");
-	close(sockfd);
+void closeCGSConnection(Connection* cnx, const char* fct) {
+	if (!cnx->transport)
+		dispError(cnx, fct,"The connection to the server is not established. Call 'connectToServer' before !");
+	cnx->transport->close(cnx);
+	cnx->transport = NULL;
+	closeRecorder(cnx->recorder);
+	cnx->recorder = NULL;
 }
 
 
@@ -226,6 +471,7 @@ void closeCGSConnection(const char* fct) {
  * Wait for a Game, and retrieve its name and first data (typically, array sizes)
  *
  * Parameters:
+ * - cnx: connection to the server
  * - fct: name of the function that calls waitForGame (used for the logging)
  * - gameType: string (max 200 characters) type of the game we want to play (empty string for regular game)
  * - gameName: string (max 50 characters), game name filled by the function
@@ -242,12 +488,10 @@ void closeCGSConnection(const char* fct) {
  *     - 'seed': allows to set the seed of the random generator
  *     - 'start': allows to set who starts ('0' or '1')
  */
-void waitForGame(const char* fct, const char* gameType, char* gameName, char* data) {
+void waitForGame(Connection* cnx, const char* fct, const char* gameType, char* gameName, char* data) {
 	size_t r;
-	if (gameType)
-	    sendString(fct,"WAIT_GAME %s", gameType);
-	else
-	    sendString(fct,"WAIT_GAME ");
+	const char* answer;
+	sendString(cnx, fct, "WAIT_GAME ", gameType);
 
 	/* read Labyrinth name
 	 If the name send is "NOT_READY", then we need to wait again
@@ -255,59 +499,64 @@ void waitForGame(const char* fct, const char* gameType, char* gameName, char* da
 	 if we have disconnected or not
 	 (that's the only way for the server to detect disconnection, ie sending something and check if the socket is still open)*/
 	do {
-        bzero(buffer,MAX_LENGTH);
-        r = read_inbuf(fct,buffer,MAX_LENGTH);
+        r = recvFrame(cnx, fct, &answer, NULL);
         if (r>0)
-            dispError( fct, "Too long answer from 'WAIT_GAME' command (sending:%s)");
+            dispError(cnx, fct, "Too long answer from 'WAIT_GAME' command (sending:%s)");
     }
-    while (strcmp(buffer,"NOT_READY")==0);
+    while (strcmp(answer,"NOT_READY")==0);
 
-	dispDebug(fct,1, "Receive Game name=%s", buffer);
-	strcpy(gameName, buffer);
+	dispDebug(cnx, fct,1, "Receive Game name=%s", answer);
+	strcpy(gameName, answer);
 
 	/* read Labyrinth size */
-	bzero(buffer,MAX_LENGTH);
-	r = read_inbuf(fct,buffer,MAX_LENGTH);
+	r = recvFrame(cnx, fct, &answer, NULL);
 	if (r>0)
-	  dispError(fct, "Answer from 'WAIT_GAME' too long");
+	  dispError(cnx, fct, "Answer from 'WAIT_GAME' too long");
 
-	dispDebug(fct,2, "Receive Game sizes=%s", buffer);
-	strcpy(data, buffer);
+	dispDebug(cnx, fct,2, "Receive Game sizes=%s", answer);
+	strcpy(data, answer);
+	timeCommand(cnx, LATENCY_WAIT_GAME);
 }
 
 
 
 /* -------------------------------------
  * Get the game data and tell who starts
- * It fills the char* data with the data of the game (it will be parsed by the caller)
- * 1 if there's a wall, 0 for nothing
+ * The data of the game is given to `reader` by chunks, as it is received (it is parsed by the caller), so it can be
+ * of any size
  *
  * Parameters:
+ * - cnx: connection to the server
  * - fct: name of the function that calls gameGetData (used for the logging)
- * - data: the array of game (the pointer data MUST HAVE allocated with the right size !!)
+ * - reader: function called with each chunk of the data
+ * - ctx: given back to `reader`
  *
  * Returns 0 if the client begins, or 1 if the opponent begins
  */
-int getGameData(const char* fct, char* data, size_t ndata) {
-	sendString(fct, "GET_GAME_DATA");
+int getGameData(Connection* cnx, const char* fct, DataReader reader, void* ctx) {
+	const char* chunk;
+	size_t n, r;
+	sendString(cnx, fct, "GET_GAME_DATA", NULL);
 
 	/* read game data */
-	size_t r = read_inbuf(fct, data, ndata);
-	if (r > 0)
-		dispError(fct, "too long answer from 'GET_GAME_DATA' command");
-
-	dispDebug(fct,2, "Receive game's data:%s", data);
+	do {
+		r = recvFrame(cnx, fct, &chunk, &n);
+		dispDebug(cnx, fct, 2, "Receive game's data:%s", chunk);
+		reader(ctx, chunk, n);
+	}
+	while (r > 0);
 
 
 	/* read if we begin (0) or if the opponent begins (1) */
-	bzero(buffer,MAX_LENGTH);
-	r = read_inbuf(fct,buffer,MAX_LENGTH);
+	const char* starter;
+	r = recvFrame(cnx, fct, &starter, NULL);
 	if (r > 0)
-		dispError(fct, "too long answer from 'GET_GAME_DATA' ");
+		dispError(cnx, fct, "too long answer from 'GET_GAME_DATA' ");
 
-	dispDebug(fct,2, "Receive these player who begins=%s", buffer);
+	dispDebug(cnx, fct,2, "Receive these player who begins=%s", starter);
+	timeCommand(cnx, LATENCY_GET_GAME_DATA);
 
-	return buffer[0] - '0';
+	return starter[0] - '0';
 }
 
 
@@ -316,6 +565,7 @@ int getGameData(const char* fct, char* data, size_t ndata) {
  * Get the opponent move
  *
  * Parameters:
+ * - cnx: connection to the server
  * - fct: name of the function that calls getCGSMove (used for the logging)
  * - move: a string representing a move (the caller will parse it to extract the move's values)
  * - msg: a string with extra data (or message when the move is not a NORMAL_MOVE), max 256 char.
@@ -324,97 +574,169 @@ int getGameData(const char* fct, char* data, size_t ndata) {
  * Fill the move  and string, and returns a return_code (0 for normal move, 1 for a winning move, -1 for a losing (or illegal) move)
  * this code is relative to the opponent (+1 if HE wins, ...)
  */
-MoveState getCGSMove(const char* fct, char* move ,char* msg) {
+MoveState getCGSMove(Connection* cnx, const char* fct, char* move ,char* msg) {
 	MoveState result;
-	sendString(fct, "GET_MOVE");
+	sendString(cnx, fct, "GET_MOVE", NULL);
 	*move = *msg = 0;
 
 	/* read move */
-	size_t r = read_inbuf(fct, move, MAX_GET_MOVE);
+	size_t r = read_inbuf(cnx, fct, move, MAX_GET_MOVE);
 	if (r>0)
-		dispError(fct, "too long answer from 'GET_MOVE' command");
-	dispDebug(__FUNCTION__,1, "Receive that move:%s", move);
+		dispError(cnx, fct, "too long answer from 'GET_MOVE' command");
+	dispDebug(cnx, __FUNCTION__,1, "Receive that move:%s", move);
 
 	/* read the message */
-	r = read_inbuf(fct, msg, MAX_MESSAGE);
+	r = read_inbuf(cnx, fct, msg, MAX_MESSAGE);
 	if (r>0)
-		dispError(fct, "Too long answer from 'GET_MOVE' command");
-	dispDebug(__FUNCTION__,2, "Receive that return code:%s", buffer);
+		dispError(cnx, fct, "Too long answer from 'GET_MOVE' command");
+	dispDebug(cnx, __FUNCTION__,2, "Receive that message:%s", msg);
 
 	/* read the return code*/
-	bzero(buffer, MAX_LENGTH);
-	r = read_inbuf(fct,buffer, MAX_LENGTH);
+	const char* code;
+	r = recvFrame(cnx, fct, &code, NULL);
 	if (r>0)
-		dispError(fct, "Too long answer from 'GET_MOVE' command");
-	dispDebug(__FUNCTION__,2, "Receive that return code:%s", buffer);
-	sscanf(buffer, "%d", &result);
+		dispError(cnx, fct, "Too long answer from 'GET_MOVE' command");
+	dispDebug(cnx, __FUNCTION__,2, "Receive that return code:%s", code);
+	sscanf(code, "%d", (int*) &result);
+	timeCommand(cnx, LATENCY_GET_MOVE);
 
 	if (result != NORMAL_MOVE)
-		printf("[%s] %s\n", __FUNCTION__, msg);
+		LOG(LOG_INFO, "[%s] %s\n", __FUNCTION__, msg);
 
 	return result;
 }
 
 
 
-/* -----------
- * Send a move
+/* Read the answer of the server to a PLAY_MOVE command (message and return code)
  *
  * Parameters:
- * - fct: name of the function that calls sendCGSMove (used for the logging)
- * - move: a string representing a move (the caller will parse it to extract the move's values)
- * - answer: a string representing the answer (should be allocated)
+ * - cnx: connection to the server
+ * - fct: name of the function that sends the move (used for the logging)
+ * - answer: a string representing the answer (allocated with at least MAX_MESSAGE chars; a longer message is
+ *   truncated), or NULL
  *
  * Returns a return_code (0 for normal move, 1 for a winning move, -1 for a losing (or illegal) move
  */
-MoveState sendCGSMove( const char* fct, char* move, char* answer) {
+static MoveState readMoveAnswer(Connection* cnx, const char* fct, char* answer) {
 	MoveState result;
-	sendString(fct, "PLAY_MOVE %s", move);
 
 	/* read the associated answer */
-	bzero(buffer, MAX_LENGTH);
-	size_t r = read_inbuf(fct, buffer, MAX_LENGTH);
+	const char* msg;
+	size_t nmsg;
+	size_t r = recvFrame(cnx, fct, &msg, &nmsg);
 	if (r>0)
-		dispError(fct, "Too long answer from 'PLAY_MOVE' command ");
-	dispDebug(fct,1, "Receive that message: %s", buffer);
-	if (answer)
-		strcpy(answer, buffer);
+		dispError(cnx, fct, "Too long answer from 'PLAY_MOVE' command ");
+	dispDebug(cnx, fct,1, "Receive that message: %s", msg);
+	if (answer) {
+		size_t n = nmsg < MAX_MESSAGE - 1 ? nmsg : MAX_MESSAGE - 1;
+		memcpy(answer, msg, n);
+		answer[n] = '\0';
+	}
 
 	/* read return code */
-	bzero(buffer, MAX_LENGTH);
-	r = read_inbuf(fct, buffer, MAX_LENGTH);
+	const char* code;
+	r = recvFrame(cnx, fct, &code, NULL);
 	if (r>0)
-		dispError(fct, "Too long answer from 'PLAY_MOVE' command");
-	dispDebug(fct,2, "Receive that return code: %s", buffer);
-	sscanf(buffer, "%d", &result);
+		dispError(cnx, fct, "Too long answer from 'PLAY_MOVE' command");
+	dispDebug(cnx, fct,2, "Receive that return code: %s", code);
+	sscanf(code, "%d", (int*) &result);
+	timeCommand(cnx, LATENCY_PLAY_MOVE);
 
-	/* display the message if the move is not a NORMAL_MOVE */
+	/* display the message if the move is not a NORMAL_MOVE (the caller has not kept it if answer is NULL) */
 	if (result != NORMAL_MOVE)
-		printf("[%s] %s\n", __FUNCTION__, answer);
+		LOG(LOG_INFO, "[%s] %s\n", __FUNCTION__, answer ? answer : "(message not kept)");
 
 	return result;
 }
 
 
 
+/* -----------
+ * Send a move
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ * - fct: name of the function that calls sendCGSMove (used for the logging)
+ * - move: a string representing a move (the caller will parse it to extract the move's values)
+ * - answer: a string representing the answer (allocated with at least MAX_MESSAGE chars), or NULL
+ *
+ * Returns a return_code (0 for normal move, 1 for a winning move, -1 for a losing (or illegal) move
+ */
+MoveState sendCGSMove(Connection* cnx,  const char* fct, char* move, char* answer) {
+	sendString(cnx, fct, "PLAY_MOVE ", move);
+	return readMoveAnswer(cnx, fct, answer);
+}
+
+
+
+/* -----------
+ * Prepare the command `PLAY_MOVE v0 v1 ...` in the encoder of the connection (no formatting by the libc)
+ * It is sent then by sendCGSMoveValues, or by flushCommand (non-blocking mode)
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ * - fct: name of the function that calls queueMoveValues (used for the logging)
+ * - values: the integers defining the move (the 1st one is the action)
+ * - nvalues: number of values
+ */
+void queueMoveValues(Connection* cnx, const char* fct, const int* values, int nvalues) {
+	encReset(&cnx->out);
+	encMem(&cnx->out, "PLAY_MOVE", 9);
+	for (int i = 0; i < nvalues; i++) {
+		encChar(&cnx->out, ' ');
+		encInt(&cnx->out, values[i]);
+	}
+	if (cnx->out.overflow)
+		dispError(cnx, fct, "The move is too long");
+	cnx->sent = 0;
+	cnx->commandStart = monotonicNs();
+}
+
+
+
+/* -----------
+ * Send a move given by its values
+ * The command `PLAY_MOVE v0 v1 ...` is built by the encoder (no formatting by the libc) and sent with one syscall
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ * - fct: name of the function that calls sendCGSMoveValues (used for the logging)
+ * - values: the integers defining the move (the 1st one is the action)
+ * - nvalues: number of values
+ * - answer: a string representing the answer (allocated with at least MAX_MESSAGE chars), or NULL
+ *
+ * Returns a return_code (0 for normal move, 1 for a winning move, -1 for a losing (or illegal) move
+ */
+MoveState sendCGSMoveValues(Connection* cnx, const char* fct, const int* values, int nvalues, char* answer) {
+	queueMoveValues(cnx, fct, values, nvalues);
+	struct iovec iov = { cnx->out.data, cnx->out.len };
+	sendCommand(cnx, fct, &iov, 1);
+	return readMoveAnswer(cnx, fct, answer);
+}
+
+
+
 /* ----------------------
  * Display the game
  * in a pretty way (ask the server what to print)
  *
  * Parameters:
+ * - cnx: connection to the server
  * - fct: name of the function that calls sendCGSMove (used for the logging)
  */
-void printCGSGame(const char* fct) {
-  dispDebug(fct,2, "Try to get string to display Game");
+void printCGSGame(Connection* cnx, const char* fct) {
+  dispDebug(cnx, fct,2, "Try to get string to display Game");
 
 	/* send command */
-	sendString(fct, "DISP_GAME");
+	sendString(cnx, fct, "DISP_GAME", NULL);
 
 	/* get string to print */
-	size_t r ;
+	size_t r, n;
+	const char* chunk;
 	do {
-	  r = read_inbuf(fct,buffer,MAX_LENGTH);
-	  printf("%s",buffer);
+	  r = recvFrame(cnx, fct, &chunk, &n);
+	  logBytes(chunk, n);
 	}
     while (r>0);
 }
@@ -425,16 +747,17 @@ void printCGSGame(const char* fct) {
  * Send a comment to the server
  *
  * Parameters:
+ * - cnx: connection to the server
  * - fct: name of the function that calls sendCGSMove (used for the logging)
  * - comment: (string) comment to send to the server (max 100 char.)
  */
-void sendCGSComment(const char* fct, const char* comment) {
-  dispDebug(fct,2, "Try to send a comment");
+void sendCGSComment(Connection* cnx, const char* fct, const char* comment) {
+  dispDebug(cnx, fct,2, "Try to send a comment");
 
 	/* max 100. car */
 	if (strlen(comment)>100)
-		dispError(fct, "The Comment is more than 100 characters.");
+		dispError(cnx, fct, "The Comment is more than 100 characters.");
 
 	/* send command */
-	sendString(fct, "SEND_COMMENT %s", comment);
+	sendString(cnx, fct, "SEND_COMMENT ", comment);
 }
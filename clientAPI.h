@@ -3,6 +3,15 @@
 #define __CLIENT_API_H__
 
 #include "stdlib.h"
+#include <stdbool.h>
+#include <setjmp.h>
+#include <sys/types.h>
+#include "ringBuffer.h"
+#include "encoder.h"
+#include "transport.h"
+#include "recorder.h"
+#include "latency.h"
+#include "logger.h"
 
 /*
  *   Structure and type definitions
@@ -21,11 +30,10 @@ typedef enum {
 
 /* Debug level
  * in some rare cases, it could be interesting to display some debug messages (log). This can be done by changing the
- * value of a specific variable named `DEBUG_LEVEL`
- * You can declare an extern variable with this name
- * `extern DebugLevel DEBUG_LEVEL;`
+ * value of a specific variable named `DEBUG_LEVEL` (declared below)
  * And then set the level at appropriate message
  * `DEBUG_LEVEL = MESSAGE;`
+ * The messages are written by the logger (see logger.h): the ones above LOG_MAX_LEVEL are removed at compile time
  */
 typedef enum {
     NO_DEBUG = 0x0,
@@ -47,16 +55,73 @@ typedef enum {
 
 #define MAX_GET_MOVE 3000	    	/* maximum size of the string representing a move */
 #define MAX_MESSAGE 3000			/* maximum size of the message move */
+#define MAX_COMMAND 256 		    /* size of the storage used to build the commands (their string arguments are not copied in) */
+
+
+/* Connection to the server
+ * Everything about a connection is stored here (and not in global variables), so that one process can use several
+ * connections (and play several games) at the same time. It is given to every function of this API.
+ * It is filled by `connectToCGSServer`
+ */
+typedef struct Connection_ {
+    int sockfd;		                /* socket descriptor (-1 if the transport has no socket) */
+    char playerName[21];            /* name of the player, stored to display it in debug */
+    RingBuffer ring;                /* receive ring: data received from the server, not yet read */
+    size_t length;                  /* remaining length of the message being received */
+    char command[MAX_COMMAND];      /* storage of the encoder used to build the commands */
+    Encoder out;                    /* encoder of the commands sent */
+    size_t sent;                    /* number of bytes of the encoded command already sent (non-blocking mode) */
+    const Transport* transport;     /* how the bytes are exchanged with the server (NULL when we are not connected) */
+    void* transportData;            /* data of the transport (NULL if it has none) */
+    Recorder* recorder;             /* log of the session (NULL if it is not recorded) */
+    uint64_t commandStart;          /* time when the last command has been sent (ns) */
+    LatencyStats latency;           /* latencies of the commands */
+} Connection;
+
+
+/* function given the chunks of a long answer, as they are received (`ctx` is given back) */
+typedef void (*DataReader)(void* ctx, const char* chunk, size_t n);
+
+
+/* error trap of a thread (see setErrorTrap): the errors are reported to it, instead of exiting the program */
+typedef struct {
+    jmp_buf env;                    /* where dispError jumps (set by setjmp) */
+    char message[MAX_MESSAGE];      /* message of the error */
+} ErrorTrap;
+
+
+/* level of the debug messages displayed (see DebugLevel) */
+extern int DEBUG_LEVEL;
+
+
+/* Display a debug message if its level is not above DEBUG_LEVEL (level 0: always displayed)
+ * dispDebug(cnx, fct, level, msg, ...): see dispDebugMessage; the messages above LOG_MAX_LEVEL are not compiled */
+#define dispDebug(cnx, fct, level, ...) \
+    do { if ((level) <= LOG_MAX_LEVEL && DEBUG_LEVEL >= (level)) dispDebugMessage(cnx, fct, __VA_ARGS__); } while (0)
+
 
 /* prototypes */
-void connectToCGSServer(const char* fct, const char* serverName, unsigned int port, const char* name);
-void closeCGSConnection(const char* fct);
-void waitForGame(const char* fct, const char* gameType, char* gameName, char* data);
-int getGameData(const char* fct, char* data, size_t ndata);
-MoveState getCGSMove(const char* fct, char* move ,char* msg);
-MoveState sendCGSMove( const char* fct, char* move, char* answer);
-void printCGSGame(const char* fct);
-void sendCGSComment(const char* fct, const char* comment);
+void dispError(const Connection* cnx, const char* fct, const char* msg, ...);
+void setErrorTrap(ErrorTrap* trap);
+void dispDebugMessage(const Connection* cnx, const char* fct, const char* msg, ...);
+void openCGSConnection(Connection* cnx, const char* fct, const char* serverName, unsigned int port, const char* name, bool nonBlocking);
+void connectToCGSServer(Connection* cnx, const char* fct, const char* serverName, unsigned int port, const char* name);
+void closeCGSConnection(Connection* cnx, const char* fct);
+void waitForGame(Connection* cnx, const char* fct, const char* gameType, char* gameName, char* data);
+int getGameData(Connection* cnx, const char* fct, DataReader reader, void* ctx);
+MoveState getCGSMove(Connection* cnx, const char* fct, char* move ,char* msg);
+MoveState sendCGSMove(Connection* cnx, const char* fct, char* move, char* answer);
+MoveState sendCGSMoveValues(Connection* cnx, const char* fct, const int* values, int nvalues, char* answer);
+void printCGSGame(Connection* cnx, const char* fct);
+void sendCGSComment(Connection* cnx, const char* fct, const char* comment);
+void timeCommand(Connection* cnx, LatencyCommand command);
+
+/* non-blocking mode (the acknowledgments and answers are read by the caller) */
+ssize_t recvAvailable(Connection* cnx);
+bool tryRecvFrame(Connection* cnx, const char *fct, const char** view, size_t* nview);
+void queueCommand(Connection* cnx, const char* fct, const char* cmd, const char* arg);
+void queueMoveValues(Connection* cnx, const char* fct, const int* values, int nvalues);
+int flushCommand(Connection* cnx);
 
 
 
@@ -0,0 +1,245 @@
+/*
+Non-blocking client for the TicketToRide game with CGS
+
+File: coroutine.c
+	Coroutines above the event loop (see coroutine.h)
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "coroutine.h"
+
+
+/* Switch to the coroutine, until it is suspended (or its function returns) */
+static void resume(CoGame* cg) {
+	swapcontext(&cg->caller, &cg->context);
+	/* the stack cannot be freed by the coroutine itself */
+	if (cg->done && cg->stack) {
+		munmap(cg->stack, cg->stackSize);
+		cg->stack = NULL;
+	}
+}
+
+
+/* Suspend the coroutine (we are back in the context that has resumed it), until the answer of the server is received */
+static void suspend(CoGame* cg) {
+	cg->waiting = true;
+	swapcontext(&cg->context, &cg->caller);
+	cg->waiting = false;
+}
+
+
+/* Entry point of the coroutine (makecontext only gives ints, so the pointer is given in two halves) */
+static void entry(unsigned int hi, unsigned int lo) {
+	CoGame* cg = (CoGame*) (((uintptr_t) hi << 16 << 16) | (uintptr_t) lo);
+	cg->main(cg);
+	if (cg->started && !cg->ended)
+		asyncQuit(&cg->ag);
+	cg->done = true;
+	/* returns to `caller` (uc_link) */
+}
+
+
+/* callbacks given to the event loop: they store the answers, and resume the coroutine */
+static void coOnStart(AsyncGame* ag, GameData* gameData) {
+	CoGame* cg = ag->user;
+	*cg->gameData = *gameData;
+	cg->answered = true;
+}
+
+static void coOnTurn(AsyncGame* ag) {
+	CoGame* cg = ag->user;
+	if (cg->waiting)
+		resume(cg);
+}
+
+static void coOnMove(AsyncGame* ag, bool ourMove, const MoveData* moveData, const MoveResult* moveResult) {
+	CoGame* cg = ag->user;
+	if (!ourMove)
+		*cg->moveData = *moveData;
+	*cg->moveResult = *moveResult;
+	cg->answered = true;
+}
+
+static void coOnEnd(AsyncGame* ag, MoveState state) {
+	CoGame* cg = ag->user;
+	cg->ended = true;
+	cg->endState = state;
+	if (cg->waiting)
+		resume(cg);
+}
+
+static const AsyncBot coBot = { coOnStart, coOnTurn, coOnMove, coOnEnd };
+
+
+/* Wait for the answer of the command just sent (if it has been sent)
+ * Returns ALL_GOOD if the answer has been received, SERVER_ERROR if the game has ended before */
+static ResultCode await(CoGame* cg, ResultCode result) {
+	if (result != ALL_GOOD)
+		return result;
+	if (cg->ag.state != ASYNC_FINISHED)
+		suspend(cg);
+	return (cg->ended && !cg->answered) ? SERVER_ERROR : ALL_GOOD;
+}
+
+
+/* Check that a command can be sent: the game is in progress, and we are in its coroutine */
+static ResultCode ready(CoGame* cg) {
+	if (!cg->started || cg->ended || cg->done || cg->waiting)
+		return PARAM_ERROR;
+	cg->answered = false;
+	return ALL_GOOD;
+}
+
+
+
+/* -------------------------------------
+ * Create the coroutine of a game, and run its function until its first command
+ * The coroutine is then resumed by the event loop (`runEventLoop`) each time the answer of the server has arrived
+ *
+ * Parameters:
+ * - loop: (EventLoop*) the loop
+ * - cg: (CoGame*) the game (allocated by the user, it should stay valid until the function of the bot returns)
+ * - address: (string) address of the server
+ * - port: (int) port number used for the connection
+ * - name: (string) your bot's name
+ * - main: function of the bot
+ * - user: data given to the bot (stored in cg->user)
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode coStartGame(EventLoop* loop, CoGame* cg, const char* address, unsigned int port, const char* name,
+                       CoBotMain main, void* user) {
+	if (!main || strlen(address) >= sizeof(cg->address) || strlen(name) >= sizeof(cg->name))
+		return PARAM_ERROR;
+
+	cg->loop = loop;
+	strcpy(cg->address, address);
+	cg->port = port;
+	strcpy(cg->name, name);
+	cg->main = main;
+	cg->user = user;
+	cg->waiting = cg->done = false;
+	cg->started = cg->ended = false;
+
+	/* stack, with a guard page below (a stack overflow then stops the program, instead of corrupting memory) */
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+	cg->stackSize = COROUTINE_STACK_SIZE + page;
+	cg->stack = mmap(NULL, cg->stackSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+	if (cg->stack == MAP_FAILED) {
+		cg->stack = NULL;
+		return OTHER_ERROR;
+	}
+	mprotect(cg->stack, page, PROT_NONE);
+
+	getcontext(&cg->context);
+	cg->context.uc_stack.ss_sp = cg->stack + page;
+	cg->context.uc_stack.ss_size = COROUTINE_STACK_SIZE;
+	cg->context.uc_link = &cg->caller;
+	uintptr_t p = (uintptr_t) cg;
+	makecontext(&cg->context, (void (*)(void)) entry, 2, (unsigned int) (p >> 16 >> 16), (unsigned int) p);
+
+	resume(cg);
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Connect to the server, and wait for a game (see sendGameSettings)
+ * Can be called again when a game is over, to play another one (on the same connection, if the game has ended by a
+ * move)
+ *
+ * Parameters:
+ * - cg: (CoGame*) the game
+ * - gameSettings: (string) settings of the game
+ * - gameData: (GameData*) filled with the data of the game (`gameName` and `trackData` are in the arena of the game:
+ *             they must not be freed, and are valid until the next game, or until the game is quitted)
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode coSendGameSettings(CoGame* cg, const char* gameSettings, GameData* gameData) {
+	if ((cg->started && !cg->ended) || cg->done || cg->waiting)
+		return PARAM_ERROR;
+	bool again = cg->started;
+	cg->started = true;
+	cg->ended = false;
+	cg->answered = false;
+	cg->gameData = gameData;
+	/* the connection of the previous game is reused if it is still open */
+	ResultCode ret = again ? asyncNextGame(&cg->ag, gameSettings) : PARAM_ERROR;
+	if (ret != ALL_GOOD)
+		ret = asyncStartGame(cg->loop, &cg->ag, cg->address, cg->port, cg->name, gameSettings, &coBot, cg);
+	if (ret != ALL_GOOD) {
+		cg->ended = true;
+		return ret;
+	}
+	return await(cg, ret);
+}
+
+
+/* -------------------------------------
+ * Get the move of the opponent (see getMove)
+ *
+ * Parameters:
+ * - cg: (CoGame*) the game
+ * - moveData: (MoveData*) filled with the opponent's move
+ * - moveResult: (MoveResult*) filled with the result of the move
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode coGetMove(CoGame* cg, MoveData* moveData, MoveResult* moveResult) {
+	ResultCode ret = ready(cg);
+	if (ret != ALL_GOOD)
+		return ret;
+	cg->moveData = moveData;
+	cg->moveResult = moveResult;
+	return await(cg, asyncGetMove(&cg->ag));
+}
+
+
+/* -------------------------------------
+ * Send our move (see sendMove)
+ *
+ * Parameters:
+ * - cg: (CoGame*) the game
+ * - moveData: (MoveData*) our move
+ * - moveResult: (MoveResult*) filled with the result of the move
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode coSendMove(CoGame* cg, const MoveData* moveData, MoveResult* moveResult) {
+	ResultCode ret = ready(cg);
+	if (ret != ALL_GOOD)
+		return ret;
+	cg->moveResult = moveResult;
+	return await(cg, asyncSendMove(&cg->ag, moveData));
+}
+
+
+/* -------------------------------------
+ * Send a message to the opponent (see sendMessage)
+ *
+ * Parameters:
+ * - cg: (CoGame*) the game
+ * - message: (string) the message (max 100 char.)
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode coSendMessage(CoGame* cg, const char* message) {
+	ResultCode ret = ready(cg);
+	if (ret != ALL_GOOD)
+		return ret;
+	return await(cg, asyncSendMessage(&cg->ag, message));
+}
+
+
+/* -------------------------------------
+ * Quit the game (the connection is closed)
+ *
+ * Parameters:
+ * - cg: (CoGame*) the game
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode coQuit(CoGame* cg) {
+	if (!cg->started || cg->ended)
+		return PARAM_ERROR;
+	return asyncQuit(&cg->ag);
+}
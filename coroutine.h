@@ -0,0 +1,90 @@
+/*
+Non-blocking client for the TicketToRide game with CGS
+
+File: coroutine.h
+	Coroutines above the event loop (see eventLoop.h), so that a bot can be written as straight-line code
+	(like with the blocking API of ticketToRide.h) while many games share the same thread
+
+	Each game is a `CoGame`, whose bot is a function run in its own coroutine (with its own small stack). The functions
+	`coSendGameSettings`, `coGetMove`, `coSendMove` and `coSendMessage` behave like `sendGameSettings`, `getMove`,
+	`sendMove` and `sendMessage`, but instead of blocking the thread, they suspend the coroutine: the event loop then
+	drives the other games, and resumes the coroutine when the answer of the server has arrived.
+
+	Usage:
+	    void myBot(CoGame* cg) {
+	        GameData gameData;
+	        MoveData move;
+	        MoveResult result;
+	        if (coSendGameSettings(cg, "TRAINING PLAY_RANDOM", &gameData) != ALL_GOOD)
+	            return;
+	        ...
+	        coGetMove(cg, &move, &result);      // suspended until the opponent has played
+	        ...
+	    }                                       // the game is quitted (if needed) when the function returns
+
+	    EventLoop loop;
+	    initEventLoop(&loop);
+	    for(...)
+	        coStartGame(&loop, &games[i], address, port, name, myBot, myData);
+	    runEventLoop(&loop);                    // returns when all the games are finished
+	    closeEventLoop(&loop);
+
+	The coroutines of a loop are always run by the thread that runs the loop (a program can use one loop per thread).
+	The other functions of ticketToRide.h that do not talk to the server (getBoardState, printCity) can be called
+	with the context `&cg->ag.game`.
+*/
+
+#ifndef __COROUTINE_H__
+#define __COROUTINE_H__
+
+#include <ucontext.h>
+#include "eventLoop.h"
+
+
+#define COROUTINE_STACK_SIZE (256*1024)     /* stack of each coroutine (the memory is only used when touched) */
+
+
+typedef struct CoGame_ CoGame;
+
+/* function of the bot, run in the coroutine of the game */
+typedef void (*CoBotMain)(CoGame* cg);
+
+
+/* a game played by a coroutine (allocated by the user, and given to coStartGame) */
+struct CoGame_ {
+    AsyncGame ag;                   /* the game, driven by the event loop */
+    EventLoop* loop;                /* the event loop */
+    char address[256];              /* address of the server */
+    unsigned int port;              /* port of the server */
+    char name[21];                  /* name of the bot */
+    CoBotMain main;                 /* function of the bot */
+    void* user;                     /* data of the bot (free to use) */
+
+    ucontext_t context;             /* context of the coroutine */
+    ucontext_t caller;              /* context that has resumed the coroutine (where it returns when it is suspended) */
+    char* stack;                    /* stack of the coroutine (with a guard page below) */
+    size_t stackSize;               /* size of the mapping of the stack */
+    bool waiting;                   /* true if the coroutine is suspended, waiting for the server */
+    bool done;                      /* true if the function of the bot has returned */
+
+    bool started;                   /* true if a game has been started by coSendGameSettings */
+    bool ended;                     /* true if the game is over */
+    MoveState endState;             /* state of the last move, when the game is over */
+    bool answered;                  /* true if the answer of the current command has been received */
+    GameData* gameData;             /* where the game data are stored (coSendGameSettings in progress) */
+    MoveData* moveData;             /* where the opponent's move is stored (coGetMove in progress) */
+    MoveResult* moveResult;         /* where the result of the move is stored (coGetMove/coSendMove in progress) */
+};
+
+
+/* prototypes */
+ResultCode coStartGame(EventLoop* loop, CoGame* cg, const char* address, unsigned int port, const char* name,
+                       CoBotMain main, void* user);
+ResultCode coSendGameSettings(CoGame* cg, const char* gameSettings, GameData* gameData);
+ResultCode coGetMove(CoGame* cg, MoveData* moveData, MoveResult* moveResult);
+ResultCode coSendMove(CoGame* cg, const MoveData* moveData, MoveResult* moveResult);
+ResultCode coSendMessage(CoGame* cg, const char* message);
+ResultCode coQuit(CoGame* cg);
+
+
+#endif
@@ -0,0 +1,111 @@
+/*
+Encoder used by the client API to build the messages sent to the server
+
+File: encoder.c
+	Functions for the Encoder type (see encoder.h)
+*/
+
+#include <string.h>
+
+#include "encoder.h"
+
+
+/* the 100 pairs of digits "00", "01", ..., "99", so that integers are formatted two digits at a time */
+static const char digitPairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+
+/* Initialize an encoder on the storage `data` of `size` bytes */
+void encInit(Encoder* enc, char* data, size_t size) {
+	enc->data = data;
+	enc->size = size;
+	encReset(enc);
+}
+
+
+/* Empty the encoder (to build a new message) */
+void encReset(Encoder* enc) {
+	enc->len = 0;
+	enc->overflow = false;
+}
+
+
+/* Append `n` bytes */
+void encMem(Encoder* enc, const char* mem, size_t n) {
+	if (enc->len + n > enc->size) {
+		enc->overflow = true;
+		return;
+	}
+	memcpy(enc->data + enc->len, mem, n);
+	enc->len += n;
+}
+
+
+/* Append a string (without its '\0') */
+void encStr(Encoder* enc, const char* str) {
+	encMem(enc, str, strlen(str));
+}
+
+
+/* Append a character */
+void encChar(Encoder* enc, char c) {
+	if (enc->len >= enc->size) {
+		enc->overflow = true;
+		return;
+	}
+	enc->data[enc->len++] = c;
+}
+
+
+/* Append an unsigned integer, in decimal */
+void encUInt(Encoder* enc, unsigned int value) {
+	char digits[10];
+	char* p = digits + sizeof(digits);
+
+	/* the digits are produced from the end, two by two */
+	while (value >= 100) {
+		unsigned int pair = (value % 100) * 2;
+		value /= 100;
+		*--p = digitPairs[pair + 1];
+		*--p = digitPairs[pair];
+	}
+	if (value >= 10) {
+		*--p = digitPairs[value * 2 + 1];
+		*--p = digitPairs[value * 2];
+	}
+	else
+		*--p = (char) ('0' + value);
+
+	encMem(enc, p, digits + sizeof(digits) - p);
+}
+
+
+/* Append a signed integer, in decimal */
+void encInt(Encoder* enc, int value) {
+	if (value < 0) {
+		encChar(enc, '-');
+		encUInt(enc, 0u - (unsigned int) value);
+	}
+	else
+		encUInt(enc, (unsigned int) value);
+}
+
+
+/* Terminate the message by a '\0' (not counted in its length), so that it can be displayed
+ * Returns the message */
+const char* encTerminate(Encoder* enc) {
+	if (enc->len < enc->size)
+		enc->data[enc->len] = '\0';
+	else
+		enc->data[enc->size - 1] = '\0';
+	return enc->data;
+}
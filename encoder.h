@@ -0,0 +1,32 @@
+#ifndef __ENCODER_H__
+#define __ENCODER_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+
+
+/* Encoder used to build the messages (commands sent to the server)
+ * It writes directly into a storage given by the caller (allocated once, typically with the connection), with its
+ * own integer formatting, so that building a message requires no allocation and no call to the printf family.
+ * If the storage is too small, the encoder stops writing and `overflow` is set.
+ */
+typedef struct {
+    char* data;         /* storage (given to encInit) */
+    size_t size;        /* size of the storage */
+    size_t len;         /* number of bytes already written */
+    bool overflow;      /* true if some bytes have been dropped because the storage is full */
+} Encoder;
+
+
+/* prototypes */
+void encInit(Encoder* enc, char* data, size_t size);
+void encReset(Encoder* enc);
+void encMem(Encoder* enc, const char* mem, size_t n);
+void encStr(Encoder* enc, const char* str);
+void encChar(Encoder* enc, char c);
+void encUInt(Encoder* enc, unsigned int value);
+void encInt(Encoder* enc, int value);
+const char* encTerminate(Encoder* enc);
+
+
+#endif
@@ -0,0 +1,463 @@
+/*
+Non-blocking client for the TicketToRide game with CGS
+
+File: eventLoop.c
+	Event loop (epoll) driving many games at the same time (see eventLoop.h)
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "eventLoop.h"
+
+
+#define MAX_EVENTS 64       /* maximum number of events handled by one epoll_wait */
+
+
+/* Update the events we wait for on the socket of the game
+ * (always readable, and writable only when a command is not completely sent, or when we connect) */
+static void updateEvents(AsyncGame* ag) {
+	struct epoll_event ev;
+	ev.events = EPOLLIN | (ag->writing ? EPOLLOUT : 0);
+	ev.data.ptr = ag;
+	epoll_ctl(ag->loop->epfd, EPOLL_CTL_MOD, ag->game.cnx.sockfd, &ev);
+}
+
+
+/* Returns true if the protocol of the game is in progress (connected, and not finished)
+ * (a game can be started again with the same AsyncGame by the `onEnd` callback, so it can then be connecting) */
+static bool inProgress(const AsyncGame* ag) {
+	return ag->state != ASYNC_CONNECTING && ag->state != ASYNC_FINISHED;
+}
+
+
+/* Close the connection of the game, and remove it from the loop */
+static void closeConnection(AsyncGame* ag) {
+	epoll_ctl(ag->loop->epfd, EPOLL_CTL_DEL, ag->game.cnx.sockfd, NULL);
+	ag->loop->nbGames--;
+	quitGame(&ag->game);
+}
+
+
+/* End the game: the bot is told, and the connection is closed
+ * When the game has ended normally (by a move), the connection is kept open while `onEnd` runs, so that the bot can
+ * play another game on it (asyncNextGame); it is closed after, if it is not reused.
+ *
+ * Parameters:
+ * - ag: the game
+ * - state: state of the last move
+ * - reusable: true if the connection can be used for another game
+ */
+static void finishGame(AsyncGame* ag, MoveState state, bool reusable) {
+	EventLoop* loop = ag->loop;
+	AsyncGame* kept = loop->kept;
+
+	ag->state = ASYNC_FINISHED;
+	if (!reusable)
+		closeConnection(ag);
+	loop->kept = reusable ? ag : NULL;
+	if (ag->bot->onEnd)
+		ag->bot->onEnd(ag, state);
+	if (loop->kept == ag)
+		closeConnection(ag);
+	loop->kept = kept;
+}
+
+
+/* End the game because of a problem (the message is always displayed) */
+static void failGame(AsyncGame* ag, const char* fct, const char* msg) {
+	dispDebug(&ag->game.cnx, fct, 0, "%s", msg);
+	finishGame(ag, LOSING_MOVE, false);
+}
+
+
+/* Send (what remains of) the command prepared in the encoder of the connection */
+static void sendQueued(AsyncGame* ag) {
+	int r = flushCommand(&ag->game.cnx);
+	if (r < 0) {
+		failGame(ag, __FUNCTION__, "Cannot write to the socket");
+		return;
+	}
+	bool writing = (r == 0);
+	if (writing != ag->writing) {
+		ag->writing = writing;
+		updateEvents(ag);
+	}
+}
+
+
+/* Send a command, and wait for its answer in the given state */
+static void command(AsyncGame* ag, AsyncState state, const char* cmd, const char* arg) {
+	queueCommand(&ag->game.cnx, __FUNCTION__, cmd, arg);
+	ag->state = state;
+	ag->step = 0;
+	sendQueued(ag);
+}
+
+
+/* Ask the bot what to do (it must send a command, or quit) */
+static void askBot(AsyncGame* ag) {
+	ag->state = ASYNC_TURN;
+	ag->bot->onTurn(ag);
+	if (ag->state == ASYNC_TURN)
+		failGame(ag, __FUNCTION__, "The bot has not played (it should call asyncGetMove, asyncSendMove, asyncSendMessage or asyncQuit)");
+}
+
+
+/* A move (ours or the opponent's) and its result are completely received */
+static void moveDone(AsyncGame* ag, bool ourMove) {
+	ag->state = ASYNC_TURN;
+	if (ag->bot->onMove)
+		ag->bot->onMove(ag, ourMove, &ag->move, &ag->result);
+	if (ag->state != ASYNC_TURN)
+		return;
+	if (ag->result.state != NORMAL_MOVE)
+		finishGame(ag, ag->result.state, true);
+	else
+		askBot(ag);
+}
+
+
+/* Copy a message in a buffer (of size `size`), truncated if necessary */
+static void copyMessage(char* dest, size_t size, const char* view, size_t n) {
+	if (n >= size)
+		n = size - 1;
+	memcpy(dest, view, n);
+	dest[n] = '\0';
+}
+
+
+/* Advance the protocol of the game with a message received from the server
+ *
+ * Parameters:
+ * - ag: the game
+ * - view: the message (NUL-terminated view in the receive ring)
+ * - n: its size
+ */
+static void onMessage(AsyncGame* ag, const char* view, size_t n) {
+	/* the answer to every command begins by the acknowledgment */
+	if (ag->step == 0) {
+		if (n != 2 || view[0] != 'O' || view[1] != 'K') {
+			dispDebug(&ag->game.cnx, __FUNCTION__, 0, "Error: The server does not acknowledge, but answered:\n%s", view);
+			finishGame(ag, LOSING_MOVE, false);
+			return;
+		}
+		timeCommand(&ag->game.cnx, LATENCY_ACK);
+		ag->step = 1;
+		if (ag->state == ASYNC_NAME)
+			command(ag, ASYNC_WAIT_GAME, "WAIT_GAME ", ag->settings);
+		else if (ag->state == ASYNC_COMMENT)
+			askBot(ag);
+		return;
+	}
+
+	switch (ag->state) {
+		case ASYNC_WAIT_GAME:
+			if (ag->step == 1) {
+				/* the server sends NOT_READY until the game is ready, then its name */
+				if (strcmp(view, "NOT_READY") != 0) {
+					copyMessage(ag->gameName, sizeof(ag->gameName), view, n);
+					ag->step = 2;
+				}
+			}
+			else {
+				timeCommand(&ag->game.cnx, LATENCY_WAIT_GAME);
+				parseGameSizes(&ag->game, ag->gameName, view, &ag->gameData);
+				command(ag, ASYNC_GAME_DATA, "GET_GAME_DATA", NULL);
+			}
+			break;
+
+		case ASYNC_GAME_DATA:
+			if (ag->step == 1) {
+				if (parseGameData(&ag->game, view, n, &ag->gameData) != ALL_GOOD) {
+					failGame(ag, __FUNCTION__, "Cannot parse the game data");
+					return;
+				}
+				ag->step = 2;
+			}
+			else {
+				timeCommand(&ag->game.cnx, LATENCY_GET_GAME_DATA);
+				ag->gameData.starter = view[0] - '0';
+				ag->state = ASYNC_TURN;
+				if (ag->bot->onStart)
+					ag->bot->onStart(ag, &ag->gameData);
+				if (ag->state == ASYNC_TURN)
+					askBot(ag);
+			}
+			break;
+
+		case ASYNC_GET_MOVE:
+			if (ag->step == 1)
+				copyMessage(ag->moveStr, MAX_GET_MOVE, view, n);
+			else if (ag->step == 2)
+				copyMessage(ag->msg, MAX_MESSAGE, view, n);
+			else {
+				timeCommand(&ag->game.cnx, LATENCY_GET_MOVE);
+				ag->result.state = (MoveState) atoi(view);
+				parseOpponentMove(&ag->game, ag->moveStr, ag->msg, &ag->move, &ag->result);
+				moveDone(ag, false);
+				return;
+			}
+			ag->step++;
+			break;
+
+		case ASYNC_PLAY_MOVE:
+			if (ag->step == 1) {
+				copyMessage(ag->msg, MAX_MESSAGE, view, n);
+				ag->step++;
+			}
+			else {
+				timeCommand(&ag->game.cnx, LATENCY_PLAY_MOVE);
+				ag->result.state = (MoveState) atoi(view);
+				parseMoveAnswer(&ag->game, &ag->move, ag->msg, &ag->result);
+				moveDone(ag, true);
+			}
+			break;
+
+		default:
+			failGame(ag, __FUNCTION__, "Unexpected message from the server");
+	}
+}
+
+
+/* The socket is writable while we are connecting: the connection is established (or has failed) */
+static void onConnected(AsyncGame* ag) {
+	int err = 0;
+	socklen_t len = sizeof(err);
+	getsockopt(ag->game.cnx.sockfd, SOL_SOCKET, SO_ERROR, &err, &len);
+	if (err) {
+		dispDebug(&ag->game.cnx, __FUNCTION__, 0, "Connection to the server impossible (%s)", strerror(err));
+		finishGame(ag, LOSING_MOVE, false);
+		return;
+	}
+	command(ag, ASYNC_NAME, "CLIENT_NAME ", ag->game.cnx.playerName);
+}
+
+
+/* The socket is readable: get everything available, and handle all the messages completely received */
+static void onReadable(AsyncGame* ag) {
+	Connection* cnx = &ag->game.cnx;
+	const char* view;
+	size_t n;
+
+	ssize_t r = recvAvailable(cnx);
+	while (inProgress(ag) && tryRecvFrame(cnx, __FUNCTION__, &view, &n))
+		onMessage(ag, view, n);
+	if (r < 0 && inProgress(ag))
+		failGame(ag, __FUNCTION__, "The connection with the server is closed");
+}
+
+
+
+/* -------------------------------------
+ * Initialize an event loop
+ *
+ * Parameters:
+ * - loop: (EventLoop*) the loop (allocated by the user)
+ */
+void initEventLoop(EventLoop* loop) {
+	loop->epfd = epoll_create1(0);
+	if (loop->epfd < 0)
+		dispError(NULL, __FUNCTION__, "Cannot create the epoll instance");
+	loop->nbGames = 0;
+	loop->kept = NULL;
+}
+
+
+/* -------------------------------------
+ * Close an event loop (its games should be finished)
+ *
+ * Parameters:
+ * - loop: (EventLoop*) the loop
+ */
+void closeEventLoop(EventLoop* loop) {
+	close(loop->epfd);
+	loop->epfd = -1;
+}
+
+
+/* -------------------------------------
+ * Start a game: connect to the server (without blocking) and add the game to the loop
+ * The game then progresses when the loop runs (`runEventLoop`), and the bot is called back when needed
+ *
+ * Parameters:
+ * - loop: (EventLoop*) the loop
+ * - ag: (AsyncGame*) the game (allocated by the user, it should stay valid until the end of the game)
+ * - address: (string) address of the server
+ * - port: (int) port number used for the connection
+ * - name: (string) your bot's name
+ * - gameSettings: (string) settings of the game (see sendGameSettings)
+ * - bot: (AsyncBot*) callbacks of the bot
+ * - user: data given to the bot (stored in ag->user)
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode asyncStartGame(EventLoop* loop, AsyncGame* ag, const char* address, unsigned int port, const char* name,
+                          const char* gameSettings, const AsyncBot* bot, void* user) {
+	if (!bot || !bot->onTurn)
+		return PARAM_ERROR;
+	if (gameSettings && strlen(gameSettings) >= sizeof(ag->settings))
+		return PARAM_ERROR;
+
+	/* a game restarted by `onEnd` does not reuse the connection kept open */
+	if (loop->kept == ag) {
+		closeConnection(ag);
+		loop->kept = NULL;
+	}
+
+	ag->loop = loop;
+	ag->bot = bot;
+	ag->user = user;
+	strcpy(ag->settings, gameSettings ? gameSettings : "");
+	ag->game.cityOffsets = NULL;
+	ag->game.cityPool = NULL;
+	initArena(&ag->game.arena);
+	ag->game.nbCities = ag->game.nbTracks = 0;
+
+	openCGSConnection(&ag->game.cnx, __FUNCTION__, address, port, name, true);
+	ag->state = ASYNC_CONNECTING;
+	ag->step = 0;
+	ag->writing = true;
+
+	struct epoll_event ev;
+	ev.events = EPOLLOUT;
+	ev.data.ptr = ag;
+	if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, ag->game.cnx.sockfd, &ev) < 0) {
+		closeCGSConnection(&ag->game.cnx, __FUNCTION__);
+		return OTHER_ERROR;
+	}
+	loop->nbGames++;
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Run the loop, until all its games are finished
+ *
+ * Parameters:
+ * - loop: (EventLoop*) the loop
+ */
+void runEventLoop(EventLoop* loop) {
+	struct epoll_event events[MAX_EVENTS];
+
+	while (loop->nbGames > 0) {
+		int n = epoll_wait(loop->epfd, events, MAX_EVENTS, -1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			dispError(NULL, __FUNCTION__, "epoll_wait has failed");
+		}
+		for (int i = 0; i < n; i++) {
+			AsyncGame* ag = events[i].data.ptr;
+			uint32_t ev = events[i].events;
+			if (ag->state == ASYNC_CONNECTING) {
+				if (ev & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+					onConnected(ag);
+				continue;
+			}
+			if ((ev & EPOLLOUT) && ag->writing)
+				sendQueued(ag);
+			if ((ev & (EPOLLIN | EPOLLERR | EPOLLHUP)) && inProgress(ag))
+				onReadable(ag);
+		}
+	}
+}
+
+
+/* -------------------------------------
+ * Ask for the move of the opponent (to be called by the bot in `onTurn`)
+ * The move is given to the bot by `onMove`
+ *
+ * Parameters:
+ * - ag: (AsyncGame*) the game
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode asyncGetMove(AsyncGame* ag) {
+	if (ag->state != ASYNC_TURN)
+		return PARAM_ERROR;
+	command(ag, ASYNC_GET_MOVE, "GET_MOVE", NULL);
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Send our move (to be called by the bot in `onTurn`)
+ * The result of the move is given to the bot by `onMove`
+ *
+ * Parameters:
+ * - ag: (AsyncGame*) the game
+ * - moveData: (MoveData*) our move
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode asyncSendMove(AsyncGame* ag, const MoveData* moveData) {
+	int values[5];
+	if (ag->state != ASYNC_TURN)
+		return PARAM_ERROR;
+	if (moveData->action < CLAIM_ROUTE || moveData->action > CHOOSE_OBJECTIVES)
+		return PARAM_ERROR;
+
+	ag->move = *moveData;
+	queueMoveValues(&ag->game.cnx, __FUNCTION__, values, encodeMove(moveData, values));
+	ag->state = ASYNC_PLAY_MOVE;
+	ag->step = 0;
+	sendQueued(ag);
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Send a message to the opponent (to be called by the bot in `onTurn`)
+ * The bot's `onTurn` is called again when the message is sent
+ *
+ * Parameters:
+ * - ag: (AsyncGame*) the game
+ * - message: (string) the message (max 100 char.)
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode asyncSendMessage(AsyncGame* ag, const char* message) {
+	if (ag->state != ASYNC_TURN || strlen(message) > 100)
+		return PARAM_ERROR;
+	command(ag, ASYNC_COMMENT, "SEND_COMMENT ", message);
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Quit the game (the connection is closed, and `onEnd` is called)
+ *
+ * Parameters:
+ * - ag: (AsyncGame*) the game
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode asyncQuit(AsyncGame* ag) {
+	if (ag->state == ASYNC_FINISHED)
+		return PARAM_ERROR;
+	finishGame(ag, NORMAL_MOVE, false);
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Play another game on the connection of a game that has just ended (to be called by the bot in `onEnd`)
+ * The connection is already named, so WAIT_GAME is sent at once (no new connection, no CLIENT_NAME). It is only
+ * possible when the game has ended normally (by a move); otherwise, asyncStartGame should be used.
+ *
+ * Parameters:
+ * - ag: (AsyncGame*) the game
+ * - gameSettings: (string) settings of the game (see sendGameSettings)
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode asyncNextGame(AsyncGame* ag, const char* gameSettings) {
+	if (ag->state != ASYNC_FINISHED || ag->loop->kept != ag)
+		return PARAM_ERROR;
+	if (gameSettings && strlen(gameSettings) >= sizeof(ag->settings))
+		return PARAM_ERROR;
+
+	ag->loop->kept = NULL;
+	strcpy(ag->settings, gameSettings ? gameSettings : "");
+	command(ag, ASYNC_WAIT_GAME, "WAIT_GAME ", ag->settings);
+	return ALL_GOOD;
+}
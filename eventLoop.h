@@ -0,0 +1,98 @@
+/*
+Non-blocking client for the TicketToRide game with CGS
+
+File: eventLoop.h
+	An event loop (epoll) that drives many games at the same time, in a single thread
+
+	Each game is an `AsyncGame`, started by `asyncStartGame`. The loop sends the commands, advances the protocol of
+	each game as its data arrives, and calls back the bot (`AsyncBot`) only when the game needs a decision:
+	    - `onStart` when the game data are received
+	    - `onTurn` when the bot has to play: it must then call (once) `asyncGetMove` (to get the opponent's move),
+	      `asyncSendMove` (to play its move), `asyncSendMessage` or `asyncQuit`
+	    - `onMove` when a move (ours or the opponent's) and its result are received
+	    - `onEnd` when the game is over; another game can be played with the same AsyncGame, on the same connection
+	      with `asyncNextGame` (only if the game has ended by a move: WAIT_GAME is then sent at once), or on a new one
+	      with `asyncStartGame`. Otherwise the connection is closed when `onEnd` returns
+
+	Usage:
+	    EventLoop loop;
+	    initEventLoop(&loop);
+	    for(...)
+	        asyncStartGame(&loop, &games[i], address, port, name, "TRAINING PLAY_RANDOM", &myBot, myData);
+	    runEventLoop(&loop);       // returns when all the games are finished
+	    closeEventLoop(&loop);
+*/
+
+#ifndef __EVENT_LOOP_H__
+#define __EVENT_LOOP_H__
+
+#include "ticketToRide.h"
+
+
+/* different states of the protocol of an asynchronous game */
+typedef enum {
+    ASYNC_CONNECTING = 0,   // the connection is in progress
+    ASYNC_NAME,             // CLIENT_NAME is sent, wait for the acknowledgment
+    ASYNC_WAIT_GAME,        // WAIT_GAME is sent, wait for the acknowledgment, the game name and the sizes
+    ASYNC_GAME_DATA,        // GET_GAME_DATA is sent, wait for the acknowledgment, the data and who begins
+    ASYNC_TURN,             // no command in progress, the bot has to decide
+    ASYNC_GET_MOVE,         // GET_MOVE is sent, wait for the acknowledgment, the move, the message and the code
+    ASYNC_PLAY_MOVE,        // PLAY_MOVE is sent, wait for the acknowledgment, the answer and the code
+    ASYNC_COMMENT,          // SEND_COMMENT is sent, wait for the acknowledgment
+    ASYNC_FINISHED          // the game is over
+} AsyncState;
+
+
+typedef struct AsyncGame_ AsyncGame;
+
+
+/* callbacks of the bot (every callback can be NULL, except `onTurn`) */
+typedef struct {
+    void (*onStart)(AsyncGame* ag, GameData* gameData);         /* `gameName` and `trackData` are in the arena of the game */
+    void (*onTurn)(AsyncGame* ag);
+    void (*onMove)(AsyncGame* ag, bool ourMove, const MoveData* moveData, const MoveResult* moveResult);
+    void (*onEnd)(AsyncGame* ag, MoveState state);              /* state of the last move (LOSING_MOVE if the connection has failed) */
+} AsyncBot;
+
+
+/* the event loop */
+typedef struct {
+    int epfd;               /* epoll descriptor */
+    int nbGames;            /* number of games in progress */
+    AsyncGame* kept;        /* game whose connection is kept open during its `onEnd` (NULL if none) */
+} EventLoop;
+
+
+/* an asynchronous game (allocated by the user, and given to asyncStartGame) */
+struct AsyncGame_ {
+    GameContext game;               /* context of the game (connection, cities, face-up cards) */
+    EventLoop* loop;                /* loop that drives the game */
+    const AsyncBot* bot;            /* callbacks of the bot */
+    void* user;                     /* data of the bot (free to use) */
+    AsyncState state;               /* state of the protocol */
+    int step;                       /* number of messages of the answer already received */
+    bool writing;                   /* true if we wait for the socket to be writable (command not completely sent) */
+    char settings[256];             /* game settings (sent with WAIT_GAME) */
+    char gameName[50];              /* name of the game */
+    GameData gameData;              /* data of the game */
+    MoveData move;                  /* move in progress (ours or the opponent's) */
+    MoveResult result;              /* its result */
+    char moveStr[MAX_GET_MOVE];     /* opponent's move, kept until its code is received */
+    char msg[MAX_MESSAGE];          /* message associated to the move, kept until its code is received */
+};
+
+
+/* prototypes */
+void initEventLoop(EventLoop* loop);
+void closeEventLoop(EventLoop* loop);
+ResultCode asyncStartGame(EventLoop* loop, AsyncGame* ag, const char* address, unsigned int port, const char* name,
+                          const char* gameSettings, const AsyncBot* bot, void* user);
+void runEventLoop(EventLoop* loop);
+ResultCode asyncGetMove(AsyncGame* ag);
+ResultCode asyncSendMove(AsyncGame* ag, const MoveData* moveData);
+ResultCode asyncSendMessage(AsyncGame* ag, const char* message);
+ResultCode asyncQuit(AsyncGame* ag);
+ResultCode asyncNextGame(AsyncGame* ag, const char* gameSettings);
+
+
+#endif
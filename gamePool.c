@@ -0,0 +1,118 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: gamePool.c
+	Pool of connections kept connected and named (see gamePool.h)
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gamePool.h"
+
+
+/* Open a new connection (connected and named)
+ * Returns NULL if it cannot be allocated (quit the program if the server cannot be reached, as connectToCGS) */
+static GameContext* openGame(GamePool* pool) {
+	GameContext* game = malloc(sizeof(GameContext));
+	if (game)
+		connectToCGS(game, pool->address, pool->port, pool->name);
+	return game;
+}
+
+
+/* Close a connection and free it */
+static void closeGame(GameContext* game) {
+	quitGame(game);
+	free(game);
+}
+
+
+
+/* -------------------------------------
+ * Initialize a pool, and open its connections
+ *
+ * Parameters:
+ * - pool: (GamePool*) the pool (allocated by the user)
+ * - address: (string) address of the server
+ * - port: (int) port number used for the connections
+ * - name: (string) your bot's name
+ * - size: (int) number of connections kept ready (at most MAX_POOL_SIZE)
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode initGamePool(GamePool* pool, const char* address, unsigned int port, const char* name, int size) {
+	if (size < 0 || size > MAX_POOL_SIZE || strlen(address) >= sizeof(pool->address) || strlen(name) >= sizeof(pool->name))
+		return PARAM_ERROR;
+
+	strcpy(pool->address, address);
+	pool->port = port;
+	strcpy(pool->name, name);
+	pool->size = size;
+	pool->nbIdle = 0;
+	pthread_mutex_init(&pool->lock, NULL);
+
+	for (int i = 0; i < size; i++) {
+		GameContext* game = openGame(pool);
+		if (!game)
+			return MEMORY_ALLOCATION_ERROR;
+		pool->idle[pool->nbIdle++] = game;
+	}
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Take a connection ready to play (a new one is opened if none is ready)
+ *
+ * Parameters:
+ * - pool: (GamePool*) the pool
+ *
+ * Returns the context of the game (to give back with releaseGame), or NULL if it cannot be allocated */
+GameContext* acquireGame(GamePool* pool) {
+	GameContext* game = NULL;
+
+	pthread_mutex_lock(&pool->lock);
+	if (pool->nbIdle > 0)
+		game = pool->idle[--pool->nbIdle];
+	pthread_mutex_unlock(&pool->lock);
+
+	/* the connection is opened outside of the lock (the other threads should not wait for it) */
+	return game ? game : openGame(pool);
+}
+
+
+/* -------------------------------------
+ * Give back a connection, when its game is over
+ * It is kept to play another game if it is reusable and if the pool is not full; otherwise it is closed.
+ *
+ * Parameters:
+ * - pool: (GamePool*) the pool
+ * - game: (GameContext*) the context given by acquireGame
+ * - reusable: (bool) true if the game has ended normally (by a move), false if the connection is not usable (the
+ *             game has been left in the middle, for example)
+ */
+void releaseGame(GamePool* pool, GameContext* game, bool reusable) {
+	pthread_mutex_lock(&pool->lock);
+	if (reusable && pool->nbIdle < pool->size) {
+		pool->idle[pool->nbIdle++] = game;
+		game = NULL;
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	if (game)
+		closeGame(game);
+}
+
+
+/* -------------------------------------
+ * Close the connections of the pool (the connections taken by acquireGame should have been given back)
+ *
+ * Parameters:
+ * - pool: (GamePool*) the pool
+ */
+void closeGamePool(GamePool* pool) {
+	for (int i = 0; i < pool->nbIdle; i++)
+		closeGame(pool->idle[i]);
+	pool->nbIdle = 0;
+	pthread_mutex_destroy(&pool->lock);
+}
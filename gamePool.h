@@ -0,0 +1,53 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: gamePool.h
+	Pool of connections, kept connected and named (CLIENT_NAME sent) ahead of time, for the blocking API
+
+	A game taken from the pool (`acquireGame`) can send WAIT_GAME at once (sendGameSettings): starting a game then
+	costs a single round trip, instead of the name resolution, the connection and the CLIENT_NAME handshake. When the
+	game is over, the connection is given back to the pool (`releaseGame`) and is used again for another game (the
+	CGS sessions can play several games in a row, see sendGameSettings).
+
+	Usage:
+	    GamePool pool;
+	    initGamePool(&pool, address, port, "myBot", 4);
+	    for(...) {                                      // possibly in several threads
+	        GameContext* game = acquireGame(&pool);
+	        sendGameSettings(game, "TRAINING PLAY_RANDOM", &gameData);
+	        ...                                         // play until the end of the game
+	        releaseGame(&pool, game, true);
+	    }
+	    closeGamePool(&pool);
+*/
+
+#ifndef __GAME_POOL_H__
+#define __GAME_POOL_H__
+
+#include <pthread.h>
+#include "ticketToRide.h"
+
+
+#define MAX_POOL_SIZE 256       /* maximum number of connections kept by a pool */
+
+
+/* pool of connections */
+typedef struct {
+    char address[256];          /* address of the server */
+    unsigned int port;          /* port of the server */
+    char name[21];              /* name of the bot */
+    int size;                   /* number of connections kept ready */
+    GameContext* idle[MAX_POOL_SIZE];   /* connections ready (connected and named), not used by a game */
+    int nbIdle;
+    pthread_mutex_t lock;       /* the pool can be shared by several threads */
+} GamePool;
+
+
+/* prototypes */
+ResultCode initGamePool(GamePool* pool, const char* address, unsigned int port, const char* name, int size);
+GameContext* acquireGame(GamePool* pool);
+void releaseGame(GamePool* pool, GameContext* game, bool reusable);
+void closeGamePool(GamePool* pool);
+
+
+#endif
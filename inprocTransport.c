@@ -0,0 +1,158 @@
+/*
+Transports used by the client API to exchange the bytes with the server
+
+File: inprocTransport.c
+	In-process transport (see transport.h): the commands are given directly to a server living in the same program,
+	and its answers are framed (as by the CGS server) in a buffer read by the client. No socket, no syscall.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "clientAPI.h"
+
+
+#define MAX_INPROC_SERVERS 16       /* maximum number of registered servers */
+#define HEAD_SIZE 6                 /* number of bytes to code the size of the message (header) */
+
+
+/* registered servers */
+static struct {
+    char name[32];
+    InprocServer* server;
+} servers[MAX_INPROC_SERVERS];
+static int nbServers = 0;
+
+
+/* in-process session of a connection */
+typedef struct {
+    InprocServer* server;
+    void* session;          /* data of the session (given by the server) */
+    char* pending;          /* answers of the server not yet read by the client */
+    size_t start;           /* first byte not read */
+    size_t len;             /* number of bytes in `pending` */
+    size_t size;            /* size allocated for `pending` */
+} InprocSession;
+
+
+/* Register a server, reachable by the address "inproc:NAME"
+ * (it should be done before the clients connect)
+ * Returns false if too many servers are registered */
+bool registerInprocServer(const char* name, InprocServer* server) {
+	if (nbServers == MAX_INPROC_SERVERS || strlen(name) >= sizeof(servers[0].name))
+		return false;
+	strcpy(servers[nbServers].name, name);
+	servers[nbServers].server = server;
+	nbServers++;
+	return true;
+}
+
+
+/* -------------------------------------
+ * Give a message to the client (called by the server, during `command`)
+ *
+ * Parameters:
+ * - cnx: connection of the client
+ * - msg: the message
+ * - n: its size
+ */
+void inprocReply(Connection* cnx, const char* msg, size_t n) {
+	InprocSession* s = cnx->transportData;
+
+	/* make room (the bytes already read are dropped) */
+	if (s->start == s->len)
+		s->start = s->len = 0;
+	if (s->len + HEAD_SIZE + n > s->size) {
+		if (s->start > 0) {
+			memmove(s->pending, s->pending + s->start, s->len - s->start);
+			s->len -= s->start;
+			s->start = 0;
+		}
+		if (s->len + HEAD_SIZE + n > s->size) {
+			size_t size = 2 * s->size + HEAD_SIZE + n;
+			char* p = realloc(s->pending, size);
+			if (!p)
+				dispError(cnx, __FUNCTION__, "Cannot allocate the answer of the server");
+			s->pending = p;
+			s->size = size;
+		}
+	}
+
+	/* header: the size in decimal, on 6 characters (padded with spaces) */
+	char* head = s->pending + s->len;
+	size_t v = n;
+	for (int i = HEAD_SIZE - 1; i >= 0; i--) {
+		head[i] = (i == HEAD_SIZE - 1 || v) ? (char) ('0' + v % 10) : ' ';
+		v /= 10;
+	}
+	memcpy(head + HEAD_SIZE, msg, n);
+	s->len += HEAD_SIZE + n;
+}
+
+
+
+/* in-process transport */
+
+static void inprocConnect(Connection* cnx, const char* fct, const char* serverName, unsigned int port, bool nonBlocking) {
+	(void) port;
+	if (nonBlocking)
+		dispError(cnx, fct, "The in-process server '%s' cannot be used by a non-blocking connection", serverName);
+
+	InprocServer* server = NULL;
+	for (int i = 0; i < nbServers; i++)
+		if (strcmp(servers[i].name, serverName + 7) == 0)
+			server = servers[i].server;
+	if (!server)
+		dispError(cnx, fct, "There is no in-process server '%s'", serverName + 7);
+
+	InprocSession* s = calloc(1, sizeof(InprocSession));
+	if (!s)
+		dispError(cnx, fct, "Cannot allocate the in-process session");
+	s->server = server;
+	cnx->transportData = s;
+	s->session = server->connect(server, cnx);
+	if (!s->session)
+		dispError(cnx, fct, "Connection to the in-process server '%s' impossible.", serverName + 7);
+}
+
+
+static ssize_t inprocRead(Connection* cnx, char* buf, size_t n) {
+	InprocSession* s = cnx->transportData;
+	/* the server answers during the command, so there is nothing more to wait for */
+	size_t avail = s->len - s->start;
+	if (n > avail)
+		n = avail;
+	memcpy(buf, s->pending + s->start, n);
+	s->start += n;
+	return n;
+}
+
+
+static ssize_t inprocExchange(Connection* cnx, const struct iovec* iov, int niov) {
+	InprocSession* s = cnx->transportData;
+	char cmd[MAX_COMMAND + 256];
+	size_t len = 0;
+
+	/* the command is given in one piece, NUL-terminated */
+	for (int i = 0; i < niov; i++) {
+		if (len + iov[i].iov_len >= sizeof(cmd))
+			return -1;
+		memcpy(cmd + len, iov[i].iov_base, iov[i].iov_len);
+		len += iov[i].iov_len;
+	}
+	cmd[len] = '\0';
+	s->server->command(s->session, cnx, cmd, len);
+	return len;
+}
+
+
+static void inprocClose(Connection* cnx) {
+	InprocSession* s = cnx->transportData;
+	s->server->disconnect(s->session);
+	free(s->pending);
+	free(s);
+	cnx->transportData = NULL;
+}
+
+
+const Transport inprocTransport = { "inproc", inprocConnect, inprocRead, inprocExchange, inprocClose };
@@ -0,0 +1,286 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: ioThread.c
+	Network thread of a game, and its lock-free queues with the decision thread (see ioThread.h)
+*/
+
+#include <string.h>
+#include <time.h>
+#include <setjmp.h>
+
+#include "ioThread.h"
+
+
+#define IO_SPINS 4096           /* number of empty polls before the network thread starts to sleep */
+#define IO_SLEEP_NS 20000       /* then, time slept between two polls (ns) */
+
+
+/* Tell the CPU that we are spinning (lets the other hyper-thread run, and avoids a pipeline flush at the exit) */
+static inline void cpuRelax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+
+/* Number of slots of the queue that are written and not yet read */
+static unsigned int queueUsed(SpscIndex* q) {
+	return atomic_load_explicit(&q->tail, memory_order_acquire) - atomic_load_explicit(&q->head, memory_order_acquire);
+}
+
+
+/* Get the slot to read (the slot is readable if the queue is not empty) */
+static unsigned int queueFront(SpscIndex* q) {
+	return atomic_load_explicit(&q->head, memory_order_relaxed) % IO_QUEUE_SIZE;
+}
+
+
+/* Get the slot to write (the queue should not be full) */
+static unsigned int queueBack(SpscIndex* q) {
+	return atomic_load_explicit(&q->tail, memory_order_relaxed) % IO_QUEUE_SIZE;
+}
+
+
+/* Publish the slot written (producer) */
+static void queuePush(SpscIndex* q) {
+	atomic_fetch_add_explicit(&q->tail, 1, memory_order_release);
+}
+
+
+/* Release the slot read (consumer) */
+static void queuePop(SpscIndex* q) {
+	atomic_fetch_add_explicit(&q->head, 1, memory_order_release);
+}
+
+
+/* Wait for a request (the network thread can sleep: the decision thread does not wait for it) */
+static IoRequest* waitRequest(IoThread* io) {
+	struct timespec pause = { 0, IO_SLEEP_NS };
+	for (unsigned int spins = 0; !queueUsed(&io->requests); spins++) {
+		if (spins < IO_SPINS)
+			cpuRelax();
+		else
+			nanosleep(&pause, NULL);
+	}
+	return &io->request[queueFront(&io->requests)];
+}
+
+
+/* Network thread: play the commands, and give back their answers
+ * The errors of the connection do not exit the program: they are given back as events (see setErrorTrap). After an
+ * error, or a move that ends the game, the commands still queued are not sent (a GET_MOVE queued after our last move,
+ * for example): their events have the code OTHER_ERROR.
+ * The event queue cannot be full: there are never more commands queued than its slots (see queueRequest) */
+static void* ioMain(void* arg) {
+	IoThread* io = arg;
+	ErrorTrap trap;
+	volatile bool over = false;         /* the game is over, or the connection has failed */
+
+	setErrorTrap(&trap);
+	for(;;) {
+		IoRequest* req = waitRequest(io);
+		if (req->command == IO_STOP) {
+			setErrorTrap(NULL);
+			queuePop(&io->requests);
+			return NULL;
+		}
+
+		IoEvent* ev = &io->event[queueBack(&io->events)];
+		ev->command = req->command;
+		if (req->command == IO_SEND_MOVE)
+			ev->move = req->move;
+		memset(&ev->result, 0, sizeof(MoveResult));
+		if (over)
+			ev->code = OTHER_ERROR;
+		else if (setjmp(trap.env)) {
+			/* error of the connection (the message is kept in the scratch of the event) */
+			strcpy(ev->scratch.text, trap.message);
+			ev->result.message = ev->scratch.text;
+			ev->code = SERVER_ERROR;
+			over = true;
+		}
+		else {
+			switch (req->command) {
+				case IO_GET_MOVE:
+					ev->code = getMoveView(io->game, &ev->scratch, &ev->move, &ev->result);
+					break;
+				case IO_SEND_MOVE:
+					ev->code = sendMoveView(io->game, &ev->scratch, &ev->move, &ev->result);
+					break;
+				default:
+					ev->code = sendMessage(io->game, req->comment);
+					break;
+			}
+			if (ev->result.state != NORMAL_MOVE)
+				over = true;
+		}
+		queuePop(&io->requests);
+		queuePush(&io->events);
+	}
+}
+
+
+/* Get the slot of a new request (decision thread)
+ * Returns NULL if too many commands are waiting for their answer */
+static IoRequest* queueRequest(IoThread* io, IoCommand command) {
+	if (io->pending >= IO_QUEUE_SIZE)
+		return NULL;
+	IoRequest* req = &io->request[queueBack(&io->requests)];
+	req->command = command;
+	return req;
+}
+
+
+/* Give the request to the network thread */
+static void sendRequest(IoThread* io) {
+	io->pending++;
+	queuePush(&io->requests);
+}
+
+
+
+/* -------------------------------------
+ * Start the network thread of a game (the game should be started: see sendGameSettings)
+ * Until stopIoThread, the connection of the game is used by the network thread only: the game is played with the
+ * functions below (and not with getMove, sendMove, etc.)
+ *
+ * Parameters:
+ * - io: (IoThread*) the thread (allocated by the user)
+ * - game: (GameContext*) context of the game
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode startIoThread(IoThread* io, GameContext* game) {
+	io->game = game;
+	io->pending = 0;
+	atomic_init(&io->requests.head, 0);
+	atomic_init(&io->requests.tail, 0);
+	atomic_init(&io->events.head, 0);
+	atomic_init(&io->events.tail, 0);
+	if (pthread_create(&io->thread, NULL, ioMain, io) != 0)
+		return OTHER_ERROR;
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Stop the network thread, once the commands queued are played (their events that are not read are dropped)
+ * The game can then be used again by the other functions (quitGame, sendGameSettings, etc.)
+ *
+ * Parameters:
+ * - io: (IoThread*) the thread
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode stopIoThread(IoThread* io) {
+	/* wait for a free slot (the network thread frees them as it plays the commands) */
+	while (queueUsed(&io->requests) >= IO_QUEUE_SIZE)
+		cpuRelax();
+	io->request[queueBack(&io->requests)].command = IO_STOP;
+	queuePush(&io->requests);
+	if (pthread_join(io->thread, NULL) != 0)
+		return OTHER_ERROR;
+	io->pending = 0;
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Ask for the move of the opponent (see getMove); the move comes as an IO_GET_MOVE event
+ *
+ * Parameters:
+ * - io: (IoThread*) the thread
+ *
+ * Returns the error code (PARAM_ERROR if IO_QUEUE_SIZE commands are already waiting for their answer) */
+ResultCode ioGetMove(IoThread* io) {
+	if (!queueRequest(io, IO_GET_MOVE))
+		return PARAM_ERROR;
+	sendRequest(io);
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Send our move (see sendMove); its result comes as an IO_SEND_MOVE event
+ *
+ * Parameters:
+ * - io: (IoThread*) the thread
+ * - moveData: (MoveData*) our move (copied)
+ *
+ * Returns the error code (PARAM_ERROR if IO_QUEUE_SIZE commands are already waiting for their answer) */
+ResultCode ioSendMove(IoThread* io, const MoveData* moveData) {
+	IoRequest* req = queueRequest(io, IO_SEND_MOVE);
+	if (!req)
+		return PARAM_ERROR;
+	req->move = *moveData;
+	sendRequest(io);
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Send a message to the opponent (see sendMessage); its acknowledgment comes as an IO_SEND_MESSAGE event
+ *
+ * Parameters:
+ * - io: (IoThread*) the thread
+ * - message: (string) the message (less than IO_MAX_COMMENT characters, copied)
+ *
+ * Returns the error code (PARAM_ERROR if the message is too long, or if IO_QUEUE_SIZE commands are already waiting
+ * for their answer) */
+ResultCode ioSendMessage(IoThread* io, const char* message) {
+	if (strlen(message) >= IO_MAX_COMMENT)
+		return PARAM_ERROR;
+	IoRequest* req = queueRequest(io, IO_SEND_MESSAGE);
+	if (!req)
+		return PARAM_ERROR;
+	strcpy(req->comment, message);
+	sendRequest(io);
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Get the next event, if it has arrived (the events come in the order of the commands)
+ * The event stays valid until ioDoneEvent
+ *
+ * Parameters:
+ * - io: (IoThread*) the thread
+ *
+ * Returns the event, or NULL if it has not arrived yet */
+const IoEvent* ioPollEvent(IoThread* io) {
+	if (!queueUsed(&io->events))
+		return NULL;
+	return &io->event[queueFront(&io->events)];
+}
+
+
+/* -------------------------------------
+ * Wait for the next event (see ioPollEvent), by spinning (without any system call)
+ *
+ * Parameters:
+ * - io: (IoThread*) the thread
+ *
+ * Returns the event, or NULL if no command is waiting for its answer */
+const IoEvent* ioWaitEvent(IoThread* io) {
+	if (!io->pending)
+		return NULL;
+	const IoEvent* ev;
+	while (!(ev = ioPollEvent(io)))
+		cpuRelax();
+	return ev;
+}
+
+
+/* -------------------------------------
+ * Release the event given by ioPollEvent or ioWaitEvent (its slot can then be reused by the network thread)
+ *
+ * Parameters:
+ * - io: (IoThread*) the thread
+ */
+void ioDoneEvent(IoThread* io) {
+	if (!queueUsed(&io->events))
+		return;
+	queuePop(&io->events);
+	io->pending--;
+}
@@ -0,0 +1,102 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: ioThread.h
+	Optional mode where a network thread owns the connection of a game, so that the bot (decision thread) never waits
+	in the kernel
+
+	The bot queues its commands (`ioGetMove`, `ioSendMove`, `ioSendMessage`) and goes on thinking; the network thread
+	sends them, reads and decodes the answers, and gives back the typed results as events (`ioWaitEvent` or
+	`ioPollEvent`, then `ioDoneEvent`). The commands and the events go through two single-producer/single-consumer
+	lock-free queues: the decision thread only spins on them (it should have a core of its own), and several commands
+	can be queued ahead (our move, then the GET_MOVE of the opponent's move, for example).
+
+	The network thread never exits the program: an error of the connection comes as an event with the code
+	SERVER_ERROR (and its message in `result.message`). After it, or after a move that ends the game (its state is not
+	NORMAL_MOVE), the commands still queued are not sent, and their events have the code OTHER_ERROR.
+
+	Usage:
+	    connectToCGS(&game, ...);
+	    sendGameSettings(&game, ..., &gameData);
+	    IoThread io;
+	    startIoThread(&io, &game);
+	    ioSendMove(&io, &move);
+	    ioGetMove(&io);                             // queued at once: sent as soon as our move is acknowledged
+	    const IoEvent* ev = ioWaitEvent(&io);       // result of our move
+	    ...
+	    ioDoneEvent(&io);
+	    ...
+	    stopIoThread(&io);                          // when the game is over (the connection is given back)
+	    quitGame(&game);
+*/
+
+#ifndef __IO_THREAD_H__
+#define __IO_THREAD_H__
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "ticketToRide.h"
+
+
+#define IO_QUEUE_SIZE 8             /* number of slots of each queue (a power of 2) */
+#define IO_MAX_COMMENT 256          /* maximum size of a message sent to the opponent */
+
+
+/* commands given to the network thread */
+typedef enum {
+    IO_GET_MOVE = 0,        // get the opponent's move
+    IO_SEND_MOVE,           // send our move
+    IO_SEND_MESSAGE,        // send a message to the opponent
+    IO_STOP                 // stop the thread (no event)
+} IoCommand;
+
+
+/* a command, given by the decision thread */
+typedef struct {
+    IoCommand command;
+    MoveData move;                      /* our move (IO_SEND_MOVE) */
+    char comment[IO_MAX_COMMENT];       /* the message (IO_SEND_MESSAGE) */
+} IoRequest;
+
+
+/* the answer to a command, given by the network thread */
+typedef struct {
+    IoCommand command;                  /* the command answered */
+    ResultCode code;                    /* its error code (OTHER_ERROR: not sent, the game is over) */
+    MoveData move;                      /* the opponent's move (IO_GET_MOVE), or ours (IO_SEND_MOVE) */
+    MoveResult result;                  /* result of the move (its message is a view in `scratch`) */
+    MoveScratch scratch;                /* storage of the answer of the server */
+} IoEvent;
+
+
+/* indexes of a single-producer/single-consumer queue (each one on its own cache line) */
+typedef struct {
+    _Alignas(64) atomic_uint head;      /* next slot to read (written by the consumer only) */
+    _Alignas(64) atomic_uint tail;      /* next slot to write (written by the producer only) */
+} SpscIndex;
+
+
+/* network thread of a game */
+typedef struct {
+    GameContext* game;                  /* the game (its connection is used by the thread only, until stopIoThread) */
+    pthread_t thread;
+    SpscIndex requests;                 /* decision thread -> network thread */
+    IoRequest request[IO_QUEUE_SIZE];
+    SpscIndex events;                   /* network thread -> decision thread */
+    IoEvent event[IO_QUEUE_SIZE];
+    int pending;                        /* commands queued and not yet answered (decision thread only) */
+} IoThread;
+
+
+/* prototypes */
+ResultCode startIoThread(IoThread* io, GameContext* game);
+ResultCode stopIoThread(IoThread* io);
+ResultCode ioGetMove(IoThread* io);
+ResultCode ioSendMove(IoThread* io, const MoveData* moveData);
+ResultCode ioSendMessage(IoThread* io, const char* message);
+const IoEvent* ioPollEvent(IoThread* io);
+const IoEvent* ioWaitEvent(IoThread* io);
+void ioDoneEvent(IoThread* io);
+
+
+#endif
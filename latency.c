@@ -0,0 +1,100 @@
+/*
+Latency histograms
+
+File: latency.c
+	Log-bucketed histograms of the latencies of the commands (see latency.h)
+*/
+
+#include <string.h>
+
+#include "latency.h"
+
+
+#define SUB (1 << LATENCY_SUB_BITS)
+
+static const char* const commandNames[NB_LATENCY_COMMANDS] = {
+	"ack", "WAIT_GAME", "GET_GAME_DATA", "GET_MOVE", "PLAY_MOVE"
+};
+
+
+/* Bucket of a value: the values < SUB have their own bucket, then each power of 2 is split in SUB buckets */
+static unsigned int bucketOf(uint64_t v) {
+	if (v < SUB)
+		return (unsigned int) v;
+	unsigned int msb = 63 - __builtin_clzll(v);
+	unsigned int b = (msb - LATENCY_SUB_BITS + 1) * SUB + ((v >> (msb - LATENCY_SUB_BITS)) & (SUB - 1));
+	return b < LATENCY_BUCKETS ? b : LATENCY_BUCKETS - 1;
+}
+
+
+/* Biggest value of a bucket */
+static uint64_t bucketMax(unsigned int b) {
+	if (b < SUB)
+		return b;
+	unsigned int shift = b / SUB - 1;
+	return ((uint64_t) (SUB + b % SUB + 1) << shift) - 1;
+}
+
+
+/* Initialize (empty) the histograms */
+void latInit(LatencyStats* stats) {
+	memset(stats, 0, sizeof(LatencyStats));
+}
+
+
+/* Add the latency (in ns) of a command */
+void latAdd(LatencyStats* stats, LatencyCommand command, uint64_t ns) {
+	Histogram* h = &stats->commands[command];
+	h->count++;
+	h->sum += ns;
+	if (ns > h->max)
+		h->max = ns;
+	h->buckets[bucketOf(ns)]++;
+}
+
+
+/* Add the histograms of `src` to the ones of `dest` (to gather the latencies of several connections) */
+void latMerge(LatencyStats* dest, const LatencyStats* src) {
+	for (int c = 0; c < NB_LATENCY_COMMANDS; c++) {
+		Histogram* d = &dest->commands[c];
+		const Histogram* s = &src->commands[c];
+		d->count += s->count;
+		d->sum += s->sum;
+		if (s->max > d->max)
+			d->max = s->max;
+		for (int b = 0; b < LATENCY_BUCKETS; b++)
+			d->buckets[b] += s->buckets[b];
+	}
+}
+
+
+/* Percentile `p` (between 0 and 1) of the latencies, in ns (upper bound of its bucket, and never more than the max)
+ * Returns 0 if the histogram is empty */
+uint64_t latPercentile(const Histogram* h, double p) {
+	if (!h->count)
+		return 0;
+	uint64_t rank = (uint64_t) (p * h->count + 0.5);
+	if (rank < 1)
+		rank = 1;
+	uint64_t seen = 0;
+	for (unsigned int b = 0; b < LATENCY_BUCKETS; b++) {
+		seen += h->buckets[b];
+		if (seen >= rank)
+			return bucketMax(b) < h->max ? bucketMax(b) : h->max;
+	}
+	return h->max;
+}
+
+
+/* Print the count, mean, p50, p99 and max (in microseconds) of each command */
+void latPrint(const LatencyStats* stats, FILE* f, const char* title) {
+	fprintf(f, "Latencies (us) %s\n", title ? title : "");
+	fprintf(f, "  %-14s %9s %10s %10s %10s %10s\n", "command", "count", "mean", "p50", "p99", "max");
+	for (int c = 0; c < NB_LATENCY_COMMANDS; c++) {
+		const Histogram* h = &stats->commands[c];
+		if (!h->count)
+			continue;
+		fprintf(f, "  %-14s %9llu %10.1f %10.1f %10.1f %10.1f\n", commandNames[c], (unsigned long long) h->count,
+		        h->sum / 1e3 / h->count, latPercentile(h, 0.5) / 1e3, latPercentile(h, 0.99) / 1e3, h->max / 1e3);
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+
+/* Latency histograms
+ * Each connection times the commands it sends (from the sending of the command to the reception of the last message
+ * of its answer) and keeps a histogram per command. The histograms are log-bucketed: each power of 2 is split in 8
+ * buckets, so a percentile is given with less than 12.5% of error, and adding a value is a few instructions.
+ */
+
+#define LATENCY_SUB_BITS 3                          /* each power of 2 is split in 2^3 buckets */
+#define LATENCY_BUCKETS (42 << LATENCY_SUB_BITS)    /* up to 2^44 ns (about 4 hours); the bigger values go in the last bucket */
+
+
+/* the commands timed */
+typedef enum {
+    LATENCY_ACK = 0,        /* acknowledgment of every command */
+    LATENCY_WAIT_GAME,      /* WAIT_GAME, until the game sizes (the NOT_READY polling included) */
+    LATENCY_GET_GAME_DATA,  /* GET_GAME_DATA, until who begins */
+    LATENCY_GET_MOVE,       /* GET_MOVE, until the return code (the opponent's thinking time included) */
+    LATENCY_PLAY_MOVE,      /* PLAY_MOVE, until the return code */
+    NB_LATENCY_COMMANDS
+} LatencyCommand;
+
+
+/* histogram of the latencies (in ns) */
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint32_t buckets[LATENCY_BUCKETS];
+} Histogram;
+
+
+/* latencies of a connection (or of several ones, merged) */
+typedef struct {
+    Histogram commands[NB_LATENCY_COMMANDS];
+} LatencyStats;
+
+
+/* prototypes */
+void latInit(LatencyStats* stats);
+void latAdd(LatencyStats* stats, LatencyCommand command, uint64_t ns);
+void latMerge(LatencyStats* dest, const LatencyStats* src);
+uint64_t latPercentile(const Histogram* h, double p);
+void latPrint(const LatencyStats* stats, FILE* f, const char* title);
+
+
+#endif
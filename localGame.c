@@ -0,0 +1,705 @@
+/*
+Local stand-in for the CGS server (Ticket to Ride)
+
+File: localGame.c
+	The game: rules (see rules-EN.pdf), scores and training bots (see localGame.h)
+*/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "localGame.h"
+
+
+#define MAX_CLAIMS 512              /* maximum number of ways to claim a route considered by the bots */
+
+/* points given by a route, from its length */
+static const int routePoints[7] = {0, 1, 2, 4, 7, 10, 15};
+
+static const char* const colorNames[10] = {
+	"None", "Purple", "White", "Blue", "Yellow", "Orange", "Black", "Red", "Green", "Locomotive"
+};
+
+
+/* Random integer in [0, n[ (xorshift generator, so that a seed always gives the same game) */
+static unsigned int randInt(LocalGame* g, unsigned int n) {
+	unsigned int x = g->rng;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	g->rng = x;
+	return x % n;
+}
+
+
+/* Shuffle an array of cards */
+static void shuffleCards(LocalGame* g, CardColor* cards, int n) {
+	for (int i = n - 1; i > 0; i--) {
+		int j = randInt(g, i + 1);
+		CardColor c = cards[i];
+		cards[i] = cards[j];
+		cards[j] = c;
+	}
+}
+
+
+/* Append a formatted string to a buffer of size `size`, where `len` bytes are already written
+ * Returns the new length */
+static int appendf(char* buf, size_t size, int len, const char* fmt, ...) {
+	va_list args;
+	if ((size_t) len >= size)
+		return len;
+	va_start(args, fmt);
+	int n = vsnprintf(buf + len, size - len, fmt, args);
+	va_end(args);
+	if (n < 0)
+		return len;
+	return (size_t) (len + n) < size ? len + n : (int) size - 1;
+}
+
+
+/* Draw the top card of the deck (the discard pile is shuffled to make a new deck when it is empty)
+ * Returns NONE if there is no card left */
+static CardColor drawDeck(LocalGame* g) {
+	if (g->nbDeck == 0 && g->nbDiscard > 0) {
+		memcpy(g->deck, g->discard, g->nbDiscard * sizeof(CardColor));
+		g->nbDeck = g->nbDiscard;
+		g->nbDiscard = 0;
+		shuffleCards(g, g->deck, g->nbDeck);
+	}
+	if (g->nbDeck == 0)
+		return NONE;
+	return g->deck[--g->nbDeck];
+}
+
+
+/* Fill the empty places of the face up cards
+ * When 3 of them are locomotives, the 5 cards are discarded and replaced (a few times at most, in case the cards
+ * left are mostly locomotives) */
+static void refillFaceUp(LocalGame* g) {
+	for (int tries = 0; tries < 5; tries++) {
+		int locos = 0;
+		for (int i = 0; i < 5; i++) {
+			if (g->faceUp[i] == NONE)
+				g->faceUp[i] = drawDeck(g);
+			locos += g->faceUp[i] == LOCOMOTIVE;
+		}
+		if (locos < 3)
+			return;
+		for (int i = 0; i < 5; i++) {
+			if (g->faceUp[i] != NONE)
+				g->discard[g->nbDiscard++] = g->faceUp[i];
+			g->faceUp[i] = NONE;
+		}
+	}
+}
+
+
+/* Returns true if a second card can be drawn (from the deck, or a face up card that is not a locomotive) */
+static bool canDrawSecond(const LocalGame* g) {
+	if (g->nbDeck + g->nbDiscard > 0)
+		return true;
+	for (int i = 0; i < 5; i++)
+		if (g->faceUp[i] != NONE && g->faceUp[i] != LOCOMOTIVE)
+			return true;
+	return false;
+}
+
+
+/* Returns the track between two cities (in any direction), or -1 */
+static int findTrack(const Map* map, int from, int to) {
+	for (int t = 0; t < map->nbTracks; t++) {
+		const int* tr = map->tracks[t];
+		if ((tr[0] == from && tr[1] == to) || (tr[0] == to && tr[1] == from))
+			return t;
+	}
+	return -1;
+}
+
+
+/* Check if a player can claim the route between `from` and `to` with `color` cards and `locos` locomotives
+ * Returns NULL (and fills `track`) if he can, or the reason why he cannot */
+static const char* checkClaim(const LocalGame* g, int player, int from, int to, int color, int locos, int* track) {
+	const LocalPlayer* p = &g->players[player];
+	int t = findTrack(g->map, from, to);
+	if (t < 0)
+		return "There is no track between these cities";
+	if (g->owner[t] >= 0)
+		return "The track is already claimed";
+	const int* tr = g->map->tracks[t];
+	int len = tr[2];
+	if (color < PURPLE || color > LOCOMOTIVE || locos < 0 || locos > len || (color == LOCOMOTIVE && locos != len))
+		return "Invalid color or number of locomotives";
+	if (color != LOCOMOTIVE && tr[3] != LOCOMOTIVE && tr[3] != color && tr[4] != LOCOMOTIVE && tr[4] != color)
+		return "The color of the cards does not match the color of the track";
+	if (p->wagons < len)
+		return "Not enough wagons";
+	if (p->cards[LOCOMOTIVE] < locos || (color != LOCOMOTIVE && p->cards[color] < len - locos))
+		return "Not enough cards";
+	*track = t;
+	return NULL;
+}
+
+
+/* Returns true if the player has connected the two cities */
+static bool connected(const LocalGame* g, int player, int a, int b) {
+	int parent[MAX_MAP_CITIES];
+	for (int i = 0; i < g->map->nbCities; i++)
+		parent[i] = i;
+	/* union-find on the player's tracks */
+	for (int t = 0; t < g->map->nbTracks; t++)
+		if (g->owner[t] == player) {
+			int x = g->map->tracks[t][0], y = g->map->tracks[t][1];
+			while (parent[x] != x)
+				x = parent[x];
+			while (parent[y] != y)
+				y = parent[y];
+			parent[x] = y;
+		}
+	while (parent[a] != a)
+		a = parent[a];
+	while (parent[b] != b)
+		b = parent[b];
+	return a == b;
+}
+
+
+/* Longest path from `city`, using the tracks of the player that are not used yet (depth-first search) */
+static int longestFrom(const LocalGame* g, int player, int city, bool* used) {
+	int best = 0;
+	for (int t = 0; t < g->map->nbTracks; t++) {
+		const int* tr = g->map->tracks[t];
+		if (g->owner[t] != player || used[t] || (tr[0] != city && tr[1] != city))
+			continue;
+		used[t] = true;
+		int len = tr[2] + longestFrom(g, player, tr[0] == city ? tr[1] : tr[0], used);
+		used[t] = false;
+		if (len > best)
+			best = len;
+	}
+	return best;
+}
+
+
+/* Length of the longest continuous path of the player */
+static int longestPath(const LocalGame* g, int player) {
+	bool used[MAX_MAP_TRACKS] = { false };
+	int best = 0;
+	for (int c = 0; c < g->map->nbCities; c++) {
+		int len = longestFrom(g, player, c, used);
+		if (len > best)
+			best = len;
+	}
+	return best;
+}
+
+
+/* End the game: final scores (objectives, longest path) and winner */
+static void endGame(LocalGame* g, int player, LocalMove* result) {
+	int total[2], completed[2], longest[2];
+
+	for (int i = 0; i < 2; i++) {
+		const LocalPlayer* p = &g->players[i];
+		total[i] = p->score;
+		completed[i] = 0;
+		for (int k = 0; k < p->nbObjectives; k++) {
+			const int* obj = g->map->objectives[p->objectives[k]];
+			if (connected(g, i, obj[0], obj[1])) {
+				total[i] += obj[2];
+				completed[i]++;
+			}
+			else
+				total[i] -= obj[2];
+		}
+		longest[i] = longestPath(g, i);
+	}
+	/* longest path bonus (for both players if they are tied) */
+	for (int i = 0; i < 2; i++)
+		if (longest[i] > 0 && longest[i] >= longest[1 - i])
+			total[i] += 10;
+
+	/* winner: most points, then most objectives completed, then longest path, then the player who has not started */
+	if (total[0] != total[1])
+		g->winner = total[0] > total[1] ? 0 : 1;
+	else if (completed[0] != completed[1])
+		g->winner = completed[0] > completed[1] ? 0 : 1;
+	else if (longest[0] != longest[1])
+		g->winner = longest[0] > longest[1] ? 0 : 1;
+	else
+		g->winner = 1 - g->starter;
+	g->over = true;
+
+	result->state = g->winner == player ? WINNING_MOVE : LOSING_MOVE;
+	snprintf(result->answer, MAX_ANSWER, "End of the game: you have %d points (%d objectives completed), your opponent %d",
+	         total[player], completed[player], total[1 - player]);
+	snprintf(result->msg, MAX_ANSWER, "End of the game: you have %d points (%d objectives completed), your opponent %d",
+	         total[1 - player], completed[1 - player], total[player]);
+}
+
+
+/* End the turn of the player (and the game after the final turns) */
+static void endTurn(LocalGame* g, int player, LocalMove* result) {
+	g->step = 0;
+	if (g->finalTurns > 0) {
+		if (--g->finalTurns == 0)
+			endGame(g, player, result);
+	}
+	else if (g->finalTurns < 0 && g->players[player].wagons <= 2)
+		g->finalTurns = 2;     /* each player, including this one, has one final turn */
+	g->current = 1 - player;
+}
+
+
+
+/* -------------------------------------
+ * Initialize a game
+ *
+ * Parameters:
+ * - g: the game
+ * - map: the map
+ * - seed: seed of the random generator (the same seed gives the same game)
+ * - starter: player who starts (0 or 1)
+ */
+void initLocalGame(LocalGame* g, const Map* map, unsigned int seed, int starter) {
+	memset(g, 0, sizeof(LocalGame));
+	g->map = map;
+	g->seed = seed;
+	g->rng = seed ? seed : 0x9E3779B9;     /* xorshift needs a non-zero state */
+	for (int t = 0; t < map->nbTracks; t++)
+		g->owner[t] = -1;
+
+	/* train car cards */
+	for (int c = PURPLE; c <= GREEN; c++)
+		for (int i = 0; i < 12; i++)
+			g->deck[g->nbDeck++] = c;
+	for (int i = 0; i < 14; i++)
+		g->deck[g->nbDeck++] = LOCOMOTIVE;
+	shuffleCards(g, g->deck, g->nbDeck);
+
+	/* objectives */
+	g->nbObjDeck = map->nbObjectives;
+	for (int i = 0; i < map->nbObjectives; i++)
+		g->objDeck[i] = i;
+	for (int i = map->nbObjectives - 1; i > 0; i--) {
+		int j = randInt(g, i + 1);
+		int o = g->objDeck[i];
+		g->objDeck[i] = g->objDeck[j];
+		g->objDeck[j] = o;
+	}
+
+	/* players: 4 cards each */
+	for (int i = 0; i < 2; i++) {
+		LocalPlayer* p = &g->players[i];
+		p->wagons = map->nbWagons;
+		p->initial = true;
+		for (int k = 0; k < 4; k++) {
+			p->cards[drawDeck(g)]++;
+			p->nbCards++;
+		}
+	}
+
+	refillFaceUp(g);
+	g->starter = g->current = starter;
+	g->finalTurns = -1;
+}
+
+
+/* -------------------------------------
+ * A player makes an illegal move (or does not respect the protocol): he loses the game
+ *
+ * Parameters:
+ * - g: the game
+ * - player: the player
+ * - why: reason
+ * - result: filled with the result of the move
+ */
+void illegalLocalMove(LocalGame* g, int player, const char* why, LocalMove* result) {
+	g->over = true;
+	g->winner = 1 - player;
+	result->state = LOSING_MOVE;
+	strcpy(result->move, "0");
+	snprintf(result->answer, MAX_ANSWER, "Illegal move: %s", why);
+	snprintf(result->msg, MAX_ANSWER, "Your opponent has made an illegal move (%s)", why);
+}
+
+
+/* Check and apply a move of the player
+ * Returns NULL if the move is legal, or the reason why it is not (and nothing is changed) */
+static const char* applyMove(LocalGame* g, int player, const int* values, int nvalues, LocalMove* result) {
+	LocalPlayer* p = &g->players[player];
+	int action = nvalues > 0 ? values[0] : 0;
+	const char* error;
+	int replay, t;
+
+	if (g->over)
+		return "The game is over";
+	if (player != g->current)
+		return "It is not your turn";
+	if (p->initial && action != DRAW_OBJECTIVES && action != CHOOSE_OBJECTIVES)
+		return "The first move must be to draw objectives";
+	if (g->step == 2 && action != CHOOSE_OBJECTIVES)
+		return "The objectives drawn have to be chosen";
+	if (g->step == 1 && action != DRAW_BLIND_CARD && action != DRAW_CARD)
+		return "A second card has to be drawn";
+
+	switch (action) {
+		case CLAIM_ROUTE: {
+			if (nvalues != 5)
+				return "Invalid move";
+			int color = values[3], locos = values[4];
+			error = checkClaim(g, player, values[1], values[2], color, locos, &t);
+			if (error)
+				return error;
+			int len = g->map->tracks[t][2];
+			p->cards[LOCOMOTIVE] -= locos;
+			if (color != LOCOMOTIVE)
+				p->cards[color] -= len - locos;
+			p->nbCards -= len;
+			for (int i = 0; i < len; i++)
+				g->discard[g->nbDiscard++] = i < locos ? LOCOMOTIVE : color;
+			p->wagons -= len;
+			p->score += routePoints[len];
+			g->owner[t] = player;
+			snprintf(result->move, MAX_ANSWER, "1 %d %d %d %d", values[1], values[2], color, locos);
+			endTurn(g, player, result);
+			break;
+		}
+
+		case DRAW_BLIND_CARD: {
+			CardColor card = drawDeck(g);
+			if (card == NONE)
+				return "There is no card left in the deck";
+			p->cards[card]++;
+			p->nbCards++;
+			replay = g->step == 0 && canDrawSecond(g);     /* the turn ends if no card is left */
+			snprintf(result->answer, MAX_ANSWER, "%d %d", replay, card);
+			strcpy(result->move, "2");
+			snprintf(result->msg, MAX_ANSWER, "%d", replay);
+			if (replay)
+				g->step = 1;
+			else
+				endTurn(g, player, result);
+			break;
+		}
+
+		case DRAW_CARD: {
+			int card = nvalues == 2 ? values[1] : NONE;
+			int i = 0;
+			while (i < 5 && (card == NONE || g->faceUp[i] != (CardColor) card))
+				i++;
+			if (i == 5)
+				return "This card is not face up";
+			if (card == LOCOMOTIVE && g->step == 1)
+				return "A face up locomotive cannot be taken as a second card";
+			p->cards[card]++;
+			p->nbCards++;
+			g->faceUp[i] = NONE;
+			refillFaceUp(g);
+			replay = g->step == 0 && card != LOCOMOTIVE && canDrawSecond(g);
+			const CardColor* f = g->faceUp;
+			snprintf(result->answer, MAX_ANSWER, "%d %d %d %d %d %d", replay, f[0], f[1], f[2], f[3], f[4]);
+			snprintf(result->move, MAX_ANSWER, "3 %d", card);
+			snprintf(result->msg, MAX_ANSWER, "%d %d %d %d %d %d %d", replay, card, f[0], f[1], f[2], f[3], f[4]);
+			if (replay)
+				g->step = 1;
+			else
+				endTurn(g, player, result);
+			break;
+		}
+
+		case DRAW_OBJECTIVES: {
+			if (g->nbObjDeck == 0)
+				return "There is no objective left";
+			int len = 0;
+			g->nbDrawn = 0;
+			for (int i = 0; i < 3; i++) {
+				if (g->nbObjDeck > 0) {
+					int o = g->objDeck[--g->nbObjDeck];
+					const int* obj = g->map->objectives[o];
+					g->drawn[g->nbDrawn++] = o;
+					len = appendf(result->answer, MAX_ANSWER, len, "%d %d %d ", obj[0], obj[1], obj[2]);
+				}
+				else
+					len = appendf(result->answer, MAX_ANSWER, len, "0 0 0 ");
+			}
+			strcpy(result->move, "4");
+			g->step = 2;
+			break;
+		}
+
+		case CHOOSE_OBJECTIVES: {
+			if (g->step != 2)
+				return "No objective has been drawn";
+			if (nvalues != 4)
+				return "Invalid move";
+			int kept = 0;
+			for (int i = 0; i < 3; i++) {
+				if (values[1 + i] && i >= g->nbDrawn)
+					return "This objective has not been drawn";
+				kept += values[1 + i] != 0;
+			}
+			int need = p->initial ? 2 : 1;
+			if (kept < (need < g->nbDrawn ? need : g->nbDrawn))
+				return p->initial ? "At least 2 objectives have to be kept" : "At least 1 objective has to be kept";
+			for (int i = 0; i < g->nbDrawn; i++) {
+				if (values[1 + i])
+					p->objectives[p->nbObjectives++] = g->drawn[i];
+				else {
+					/* returned at the bottom of the deck */
+					memmove(g->objDeck + 1, g->objDeck, g->nbObjDeck * sizeof(int));
+					g->objDeck[0] = g->drawn[i];
+					g->nbObjDeck++;
+				}
+			}
+			g->nbDrawn = 0;
+			p->initial = false;
+			snprintf(result->move, MAX_ANSWER, "5 %d %d %d", values[1] != 0, values[2] != 0, values[3] != 0);
+			endTurn(g, player, result);
+			break;
+		}
+
+		default:
+			return "Unknown move";
+	}
+	return NULL;
+}
+
+
+/* -------------------------------------
+ * Play a move (it is checked, and applied if it is legal; an illegal move loses the game)
+ *
+ * Parameters:
+ * - g: the game
+ * - player: player who plays
+ * - values: the move (action and its values, as sent with PLAY_MOVE)
+ * - nvalues: number of values
+ * - result: filled with the result of the move (answer to the player, and what the opponent sees)
+ */
+void playLocalMove(LocalGame* g, int player, const int* values, int nvalues, LocalMove* result) {
+	result->state = NORMAL_MOVE;
+	result->answer[0] = result->move[0] = result->msg[0] = '\0';
+
+	const char* error = applyMove(g, player, values, nvalues, result);
+	if (error)
+		illegalLocalMove(g, player, error, result);
+}
+
+
+
+/* Collect the ways the player can claim a route (track, color, locomotives)
+ * Returns the number of possibilities */
+static int claimOptions(const LocalGame* g, int player, int (*options)[3]) {
+	const LocalPlayer* p = &g->players[player];
+	int n = 0;
+	for (int t = 0; t < g->map->nbTracks && n < MAX_CLAIMS - 10; t++) {
+		const int* tr = g->map->tracks[t];
+		int len = tr[2];
+		if (g->owner[t] >= 0 || len > p->wagons)
+			continue;
+		for (int k = 3; k <= 4; k++) {
+			int tc = tr[k];
+			if (tc == NONE)
+				continue;
+			for (int c = PURPLE; c <= GREEN; c++) {
+				if ((tc != LOCOMOTIVE && c != tc) || p->cards[c] == 0 || p->cards[c] + p->cards[LOCOMOTIVE] < len)
+					continue;
+				options[n][0] = t;
+				options[n][1] = c;
+				options[n][2] = p->cards[c] >= len ? 0 : len - p->cards[c];
+				n++;
+			}
+			if (p->cards[LOCOMOTIVE] >= len) {
+				options[n][0] = t;
+				options[n][1] = LOCOMOTIVE;
+				options[n][2] = len;
+				n++;
+			}
+		}
+	}
+	return n;
+}
+
+
+/* Returns the index of a face up card that can be taken (not a locomotive if `noLoco`), chosen at random, or -1 */
+static int randomFaceUp(LocalGame* g, bool noLoco) {
+	int idx[5], n = 0;
+	for (int i = 0; i < 5; i++)
+		if (g->faceUp[i] != NONE && !(noLoco && g->faceUp[i] == LOCOMOTIVE))
+			idx[n++] = i;
+	return n ? idx[randInt(g, n)] : -1;
+}
+
+
+/* -------------------------------------
+ * Choose the move of a training bot
+ *
+ * Parameters:
+ * - g: the game
+ * - bot: the bot
+ * - player: the player played by the bot
+ * - values: filled with the move (as sent with PLAY_MOVE, at most 5 values)
+ *
+ * Returns the number of values
+ */
+int chooseBotMove(LocalGame* g, BotType bot, int player, int* values) {
+	LocalPlayer* p = &g->players[player];
+	bool deck = g->nbDeck + g->nbDiscard > 0;
+	int options[MAX_CLAIMS][3];
+	int f;
+
+	/* choose the objectives drawn (at least 2 the first time, 1 after) */
+	if (g->step == 2) {
+		int need = p->initial ? 2 : 1;
+		int kept = 0;
+		values[0] = CHOOSE_OBJECTIVES;
+		for (int i = 0; i < 3; i++) {
+			values[1 + i] = i < g->nbDrawn && (bot == BOT_DO_NOTHING ? i < need : randInt(g, 2));
+			kept += values[1 + i];
+		}
+		for (int i = 0; i < g->nbDrawn && kept < need; i++)
+			if (!values[1 + i]) {
+				values[1 + i] = 1;
+				kept++;
+			}
+		return 4;
+	}
+	if (p->initial) {
+		values[0] = DRAW_OBJECTIVES;
+		return 1;
+	}
+
+	/* second card */
+	if (g->step == 1) {
+		f = randomFaceUp(g, true);
+		if (f >= 0 && (!deck || (bot == BOT_PLAY_RANDOM && randInt(g, 2)))) {
+			values[0] = DRAW_CARD;
+			values[1] = g->faceUp[f];
+			return 2;
+		}
+		values[0] = DRAW_BLIND_CARD;
+		return 1;
+	}
+
+	/* beginning of a turn */
+	int n = claimOptions(g, player, options);
+	if (bot == BOT_PLAY_RANDOM) {
+		if (n > 0 && (randInt(g, 2) || !deck)) {
+			int* o = options[randInt(g, n)];
+			values[0] = CLAIM_ROUTE;
+			values[1] = g->map->tracks[o[0]][0];
+			values[2] = g->map->tracks[o[0]][1];
+			values[3] = o[1];
+			values[4] = o[2];
+			return 5;
+		}
+		if (g->nbObjDeck > 0 && randInt(g, 20) == 0) {
+			values[0] = DRAW_OBJECTIVES;
+			return 1;
+		}
+		f = randomFaceUp(g, false);
+		if (f >= 0 && (!deck || randInt(g, 2))) {
+			values[0] = DRAW_CARD;
+			values[1] = g->faceUp[f];
+			return 2;
+		}
+	}
+	if (deck) {
+		values[0] = DRAW_BLIND_CARD;
+		return 1;
+	}
+	f = randomFaceUp(g, false);
+	if (f >= 0) {
+		values[0] = DRAW_CARD;
+		values[1] = g->faceUp[f];
+		return 2;
+	}
+	if (g->nbObjDeck > 0) {
+		values[0] = DRAW_OBJECTIVES;
+		return 1;
+	}
+	if (n > 0) {
+		values[0] = CLAIM_ROUTE;
+		values[1] = g->map->tracks[options[0][0]][0];
+		values[2] = g->map->tracks[options[0][0]][1];
+		values[3] = options[0][1];
+		values[4] = options[0][2];
+		return 5;
+	}
+	/* nothing can be done */
+	values[0] = DRAW_BLIND_CARD;
+	return 1;
+}
+
+
+
+/* -------------------------------------
+ * Write the data of the game, as sent for GET_GAME_DATA: names of the cities (the spaces are replaced by '_'), the
+ * tracks (5 integers each), the face up cards and the 4 initial cards of the player 0
+ *
+ * Returns the length of the data
+ */
+int writeGameData(const LocalGame* g, char* buf, size_t size) {
+	const Map* map = g->map;
+	int len = 0;
+	for (int c = 0; c < map->nbCities; c++) {
+		int start = len;
+		len = appendf(buf, size, len, "%s ", map->cities[c]);
+		for (int i = start; i < len - 1; i++)
+			if (buf[i] == ' ')
+				buf[i] = '_';
+	}
+	for (int t = 0; t < map->nbTracks; t++) {
+		const int* tr = map->tracks[t];
+		len = appendf(buf, size, len, "%d %d %d %d %d ", tr[0], tr[1], tr[2], tr[3], tr[4]);
+	}
+	for (int i = 0; i < 5; i++)
+		len = appendf(buf, size, len, "%d ", g->faceUp[i]);
+	/* the cards of the player 0 (no move has been played yet) */
+	int n = 0;
+	for (int c = PURPLE; c <= LOCOMOTIVE; c++)
+		for (int k = 0; k < g->players[0].cards[c] && n < 4; k++, n++)
+			len = appendf(buf, size, len, n < 3 ? "%d " : "%d", c);
+	return len;
+}
+
+
+/* -------------------------------------
+ * Write the board (as sent for DISP_GAME)
+ *
+ * Returns the length of the text
+ */
+int writeBoard(const LocalGame* g, char* buf, size_t size) {
+	const Map* map = g->map;
+	int len = 0;
+
+	len = appendf(buf, size, len, "Map %s, seed %06x\n", map->name, g->seed);
+	len = appendf(buf, size, len, "Face up cards:");
+	for (int i = 0; i < 5; i++)
+		len = appendf(buf, size, len, " %s", colorNames[g->faceUp[i]]);
+	len = appendf(buf, size, len, "\nDeck: %d cards, discard: %d cards, objectives: %d\n", g->nbDeck, g->nbDiscard, g->nbObjDeck);
+
+	for (int i = 0; i < 2; i++) {
+		const LocalPlayer* p = &g->players[i];
+		len = appendf(buf, size, len, "%s %d%s: %d wagons, %d cards, %d objectives, %d points\n", i ? "Bot" : "Player", i,
+		              g->current == i ? " (to play)" : "", p->wagons, p->nbCards, p->nbObjectives, p->score);
+	}
+	/* our cards and objectives */
+	len = appendf(buf, size, len, "Your cards:");
+	for (int c = PURPLE; c <= LOCOMOTIVE; c++)
+		if (g->players[0].cards[c])
+			len = appendf(buf, size, len, " %d %s", g->players[0].cards[c], colorNames[c]);
+	len = appendf(buf, size, len, "\nYour objectives:");
+	for (int k = 0; k < g->players[0].nbObjectives; k++) {
+		const int* obj = map->objectives[g->players[0].objectives[k]];
+		len = appendf(buf, size, len, " %s-%s (%d)", map->cities[obj[0]], map->cities[obj[1]], obj[2]);
+	}
+	len = appendf(buf, size, len, "\nRoutes claimed:\n");
+	for (int t = 0; t < map->nbTracks; t++)
+		if (g->owner[t] >= 0) {
+			const int* tr = map->tracks[t];
+			len = appendf(buf, size, len, "  %s - %s (%d): %s\n", map->cities[tr[0]], map->cities[tr[1]], tr[2],
+			              g->owner[t] ? "bot" : "player");
+		}
+	return len;
+}
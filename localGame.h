@@ -0,0 +1,104 @@
+/*
+Local stand-in for the CGS server (Ticket to Ride)
+
+File: localGame.h
+	The game itself: maps, rules (see rules-EN.pdf) and the training bots
+	A game is played by 2 players: player 0 is the client, player 1 is the bot of the server.
+*/
+
+#ifndef __LOCAL_GAME_H__
+#define __LOCAL_GAME_H__
+
+#include <stdbool.h>
+#include "ticketToRide.h"
+
+
+#define NB_CARDS 110                /* 12 cards of each of the 8 colors, and 14 locomotives */
+#define MAX_MAP_CITIES 64
+#define MAX_MAP_TRACKS 128
+#define MAX_MAP_OBJECTIVES 64
+#define MAX_ANSWER 256              /* maximum size of the answers and messages of a move */
+
+
+/* a map */
+typedef struct {
+    const char* name;
+    int nbWagons;                   /* number of wagons of each player */
+    int nbCities;
+    const char* const* cities;      /* names of the cities */
+    int nbTracks;
+    const int (*tracks)[5];         /* tracks: city1, city2, length, color, color of the 2nd track (NONE if single) */
+    int nbObjectives;
+    const int (*objectives)[3];     /* objectives: city1, city2, score */
+} Map;
+
+
+/* the training bots */
+typedef enum {
+    BOT_DO_NOTHING,                 /* only takes its objectives, and then draws cards */
+    BOT_PLAY_RANDOM                 /* plays random (legal) moves, and claims routes when it can */
+} BotType;
+
+
+/* a player */
+typedef struct {
+    int wagons;                     /* wagons left */
+    int cards[10];                  /* number of cards of each color (index: CardColor) */
+    int nbCards;
+    int objectives[MAX_MAP_OBJECTIVES];     /* objectives kept (index in the map) */
+    int nbObjectives;
+    int score;                      /* points of the routes claimed */
+    bool initial;                   /* true while the player has not chosen his first objectives */
+} LocalPlayer;
+
+
+/* a game */
+typedef struct {
+    const Map* map;
+    unsigned int seed;              /* seed of the game */
+    unsigned int rng;               /* state of the random generator */
+    int owner[MAX_MAP_TRACKS];      /* player who has claimed the track, or -1 (a double track is closed by a claim) */
+    CardColor deck[NB_CARDS];       /* draw pile (the top is the last card) */
+    int nbDeck;
+    CardColor discard[NB_CARDS];    /* discard pile */
+    int nbDiscard;
+    CardColor faceUp[5];            /* face up cards (NONE if there is no card) */
+    int objDeck[MAX_MAP_OBJECTIVES];        /* objective deck (the top is the last one) */
+    int nbObjDeck;
+    LocalPlayer players[2];
+    int starter;                    /* player who has started */
+    int current;                    /* player who has to play */
+    int step;                       /* 0: beginning of a turn, 1: a 2nd card has to be drawn, 2: objectives have to be chosen */
+    int drawn[3];                   /* objectives drawn, to be chosen */
+    int nbDrawn;
+    int finalTurns;                 /* -1 until the end is triggered, then the number of turns left */
+    bool over;                      /* true when the game is over */
+    int winner;
+} LocalGame;
+
+
+/* result of a move */
+typedef struct {
+    MoveState state;                /* state, for the player who has played */
+    char answer[MAX_ANSWER];        /* answer to the player (answer of PLAY_MOVE) */
+    char move[MAX_ANSWER];          /* the move, as seen by the opponent (GET_MOVE) */
+    char msg[MAX_ANSWER];           /* message associated to the move, for the opponent (GET_MOVE) */
+} LocalMove;
+
+
+/* maps */
+extern const Map mapUSA;
+extern const Map mapSmall;
+
+
+/* prototypes */
+const Map* findMap(const char* name);
+void initLocalGame(LocalGame* g, const Map* map, unsigned int seed, int starter);
+void playLocalMove(LocalGame* g, int player, const int* values, int nvalues, LocalMove* result);
+void illegalLocalMove(LocalGame* g, int player, const char* why, LocalMove* result);
+int chooseBotMove(LocalGame* g, BotType bot, int player, int* values);
+int writeGameData(const LocalGame* g, char* buf, size_t size);
+int writeBoard(const LocalGame* g, char* buf, size_t size);
+
+
+#endif
@@ -0,0 +1,224 @@
+/*
+Local stand-in for the CGS server (Ticket to Ride)
+
+File: localMaps.c
+	Maps of the local server (see localGame.h)
+*/
+
+#include <string.h>
+#include <strings.h>
+
+#include "localGame.h"
+
+
+/* ---------------------------------
+ * USA (map of the board game, see mapUSA.pdf)
+ */
+
+static const char* const citiesUSA[] = {
+	"Vancouver", "Seattle", "Portland", "San Francisco", "Los Angeles", "Phoenix", "Las Vegas", "Salt Lake City",
+	"Calgary", "Helena", "Winnipeg", "Denver", "Santa Fe", "El Paso", "Houston", "Dallas", "Oklahoma City",
+	"Kansas City", "Omaha", "Duluth", "Sault St Marie", "Chicago", "Saint Louis", "Little Rock", "New Orleans",
+	"Atlanta", "Nashville", "Pittsburgh", "Toronto", "Montreal", "Boston", "New York", "Washington", "Raleigh",
+	"Charleston", "Miami"
+};
+
+enum {
+	VANCOUVER, SEATTLE, PORTLAND, SAN_FRANCISCO, LOS_ANGELES, PHOENIX, LAS_VEGAS, SALT_LAKE_CITY, CALGARY, HELENA,
+	WINNIPEG, DENVER, SANTA_FE, EL_PASO, HOUSTON, DALLAS, OKLAHOMA_CITY, KANSAS_CITY, OMAHA, DULUTH, SAULT_ST_MARIE,
+	CHICAGO, SAINT_LOUIS, LITTLE_ROCK, NEW_ORLEANS, ATLANTA, NASHVILLE, PITTSBURGH, TORONTO, MONTREAL, BOSTON,
+	NEW_YORK, WASHINGTON, RALEIGH, CHARLESTON, MIAMI
+};
+
+#define GRAY LOCOMOTIVE         /* gray tracks can be claimed with any color */
+
+static const int tracksUSA[][5] = {
+	{VANCOUVER, SEATTLE, 1, GRAY, GRAY},
+	{VANCOUVER, CALGARY, 3, GRAY, NONE},
+	{SEATTLE, CALGARY, 4, GRAY, NONE},
+	{SEATTLE, PORTLAND, 1, GRAY, GRAY},
+	{SEATTLE, HELENA, 6, YELLOW, NONE},
+	{PORTLAND, SAN_FRANCISCO, 5, GREEN, PURPLE},
+	{PORTLAND, SALT_LAKE_CITY, 6, BLUE, NONE},
+	{SAN_FRANCISCO, SALT_LAKE_CITY, 5, ORANGE, WHITE},
+	{SAN_FRANCISCO, LOS_ANGELES, 3, YELLOW, PURPLE},
+	{LOS_ANGELES, LAS_VEGAS, 2, GRAY, NONE},
+	{LOS_ANGELES, PHOENIX, 3, GRAY, NONE},
+	{LOS_ANGELES, EL_PASO, 6, BLACK, NONE},
+	{LAS_VEGAS, SALT_LAKE_CITY, 3, ORANGE, NONE},
+	{PHOENIX, DENVER, 5, WHITE, NONE},
+	{PHOENIX, SANTA_FE, 3, GRAY, NONE},
+	{PHOENIX, EL_PASO, 3, GRAY, NONE},
+	{CALGARY, HELENA, 4, GRAY, NONE},
+	{CALGARY, WINNIPEG, 6, WHITE, NONE},
+	{HELENA, WINNIPEG, 4, BLUE, NONE},
+	{HELENA, DULUTH, 6, ORANGE, NONE},
+	{HELENA, OMAHA, 5, RED, NONE},
+	{HELENA, DENVER, 4, GREEN, NONE},
+	{HELENA, SALT_LAKE_CITY, 3, PURPLE, NONE},
+	{SALT_LAKE_CITY, DENVER, 3, RED, YELLOW},
+	{DENVER, OMAHA, 4, PURPLE, NONE},
+	{DENVER, KANSAS_CITY, 4, BLACK, ORANGE},
+	{DENVER, OKLAHOMA_CITY, 4, RED, NONE},
+	{DENVER, SANTA_FE, 2, GRAY, NONE},
+	{SANTA_FE, EL_PASO, 2, GRAY, NONE},
+	{SANTA_FE, OKLAHOMA_CITY, 3, BLUE, NONE},
+	{EL_PASO, OKLAHOMA_CITY, 5, YELLOW, NONE},
+	{EL_PASO, DALLAS, 4, RED, NONE},
+	{EL_PASO, HOUSTON, 6, GREEN, NONE},
+	{WINNIPEG, DULUTH, 4, BLACK, NONE},
+	{WINNIPEG, SAULT_ST_MARIE, 6, GRAY, NONE},
+	{DULUTH, SAULT_ST_MARIE, 3, GRAY, NONE},
+	{DULUTH, TORONTO, 6, PURPLE, NONE},
+	{DULUTH, CHICAGO, 3, RED, NONE},
+	{DULUTH, OMAHA, 2, GRAY, GRAY},
+	{OMAHA, CHICAGO, 4, BLUE, NONE},
+	{OMAHA, KANSAS_CITY, 1, GRAY, GRAY},
+	{KANSAS_CITY, SAINT_LOUIS, 2, BLUE, PURPLE},
+	{KANSAS_CITY, OKLAHOMA_CITY, 2, GRAY, GRAY},
+	{OKLAHOMA_CITY, DALLAS, 2, GRAY, GRAY},
+	{OKLAHOMA_CITY, LITTLE_ROCK, 2, GRAY, NONE},
+	{DALLAS, LITTLE_ROCK, 2, GRAY, NONE},
+	{DALLAS, HOUSTON, 1, GRAY, GRAY},
+	{HOUSTON, NEW_ORLEANS, 2, GRAY, NONE},
+	{LITTLE_ROCK, SAINT_LOUIS, 2, GRAY, NONE},
+	{LITTLE_ROCK, NASHVILLE, 3, WHITE, NONE},
+	{LITTLE_ROCK, NEW_ORLEANS, 3, GREEN, NONE},
+	{NEW_ORLEANS, ATLANTA, 4, YELLOW, ORANGE},
+	{NEW_ORLEANS, MIAMI, 6, RED, NONE},
+	{SAINT_LOUIS, CHICAGO, 2, GREEN, WHITE},
+	{SAINT_LOUIS, PITTSBURGH, 5, GREEN, NONE},
+	{SAINT_LOUIS, NASHVILLE, 2, GRAY, NONE},
+	{CHICAGO, PITTSBURGH, 3, ORANGE, BLACK},
+	{CHICAGO, TORONTO, 4, WHITE, NONE},
+	{NASHVILLE, ATLANTA, 1, GRAY, NONE},
+	{NASHVILLE, RALEIGH, 3, BLACK, NONE},
+	{NASHVILLE, PITTSBURGH, 4, YELLOW, NONE},
+	{ATLANTA, RALEIGH, 2, GRAY, GRAY},
+	{ATLANTA, CHARLESTON, 2, GRAY, NONE},
+	{ATLANTA, MIAMI, 5, BLUE, NONE},
+	{CHARLESTON, RALEIGH, 2, GRAY, NONE},
+	{CHARLESTON, MIAMI, 4, PURPLE, NONE},
+	{RALEIGH, WASHINGTON, 2, GRAY, GRAY},
+	{RALEIGH, PITTSBURGH, 2, GRAY, NONE},
+	{WASHINGTON, PITTSBURGH, 2, GRAY, NONE},
+	{WASHINGTON, NEW_YORK, 2, ORANGE, BLACK},
+	{PITTSBURGH, NEW_YORK, 2, WHITE, GREEN},
+	{PITTSBURGH, TORONTO, 2, GRAY, NONE},
+	{TORONTO, SAULT_ST_MARIE, 2, GRAY, NONE},
+	{TORONTO, MONTREAL, 3, GRAY, NONE},
+	{SAULT_ST_MARIE, MONTREAL, 5, BLACK, NONE},
+	{MONTREAL, BOSTON, 2, GRAY, GRAY},
+	{MONTREAL, NEW_YORK, 3, BLUE, NONE},
+	{NEW_YORK, BOSTON, 2, YELLOW, RED}
+};
+
+static const int objectivesUSA[][3] = {
+	{DENVER, EL_PASO, 4},
+	{KANSAS_CITY, HOUSTON, 5},
+	{NEW_YORK, ATLANTA, 6},
+	{CHICAGO, NEW_ORLEANS, 7},
+	{CALGARY, SALT_LAKE_CITY, 7},
+	{HELENA, LOS_ANGELES, 8},
+	{DULUTH, HOUSTON, 8},
+	{SAULT_ST_MARIE, NASHVILLE, 8},
+	{MONTREAL, ATLANTA, 9},
+	{SAULT_ST_MARIE, OKLAHOMA_CITY, 9},
+	{SEATTLE, LOS_ANGELES, 9},
+	{CHICAGO, SANTA_FE, 9},
+	{DULUTH, EL_PASO, 10},
+	{TORONTO, MIAMI, 10},
+	{PORTLAND, PHOENIX, 11},
+	{DALLAS, NEW_YORK, 11},
+	{DENVER, PITTSBURGH, 11},
+	{WINNIPEG, LITTLE_ROCK, 11},
+	{WINNIPEG, HOUSTON, 12},
+	{BOSTON, MIAMI, 12},
+	{VANCOUVER, SANTA_FE, 13},
+	{CALGARY, PHOENIX, 13},
+	{MONTREAL, NEW_ORLEANS, 13},
+	{LOS_ANGELES, CHICAGO, 16},
+	{SAN_FRANCISCO, ATLANTA, 17},
+	{PORTLAND, NASHVILLE, 17},
+	{VANCOUVER, MONTREAL, 20},
+	{LOS_ANGELES, MIAMI, 20},
+	{LOS_ANGELES, NEW_YORK, 21},
+	{SEATTLE, NEW_YORK, 22}
+};
+
+const Map mapUSA = {
+	"USA", 45,
+	sizeof(citiesUSA) / sizeof(citiesUSA[0]), citiesUSA,
+	sizeof(tracksUSA) / sizeof(tracksUSA[0]), tracksUSA,
+	sizeof(objectivesUSA) / sizeof(objectivesUSA[0]), objectivesUSA
+};
+
+
+
+/* ---------------------------------
+ * small map (north-east of the USA map), for short games
+ */
+
+static const char* const citiesSmall[] = {
+	"Chicago", "Saint Louis", "Nashville", "Atlanta", "Raleigh", "Washington", "Pittsburgh", "Toronto", "Montreal",
+	"Boston", "New York"
+};
+
+enum {
+	S_CHICAGO, S_SAINT_LOUIS, S_NASHVILLE, S_ATLANTA, S_RALEIGH, S_WASHINGTON, S_PITTSBURGH, S_TORONTO, S_MONTREAL,
+	S_BOSTON, S_NEW_YORK
+};
+
+static const int tracksSmall[][5] = {
+	{S_SAINT_LOUIS, S_CHICAGO, 2, GREEN, WHITE},
+	{S_SAINT_LOUIS, S_PITTSBURGH, 5, GREEN, NONE},
+	{S_SAINT_LOUIS, S_NASHVILLE, 2, GRAY, NONE},
+	{S_CHICAGO, S_PITTSBURGH, 3, ORANGE, BLACK},
+	{S_CHICAGO, S_TORONTO, 4, WHITE, NONE},
+	{S_NASHVILLE, S_ATLANTA, 1, GRAY, NONE},
+	{S_NASHVILLE, S_RALEIGH, 3, BLACK, NONE},
+	{S_NASHVILLE, S_PITTSBURGH, 4, YELLOW, NONE},
+	{S_ATLANTA, S_RALEIGH, 2, GRAY, GRAY},
+	{S_RALEIGH, S_WASHINGTON, 2, GRAY, GRAY},
+	{S_RALEIGH, S_PITTSBURGH, 2, GRAY, NONE},
+	{S_WASHINGTON, S_PITTSBURGH, 2, GRAY, NONE},
+	{S_WASHINGTON, S_NEW_YORK, 2, ORANGE, BLACK},
+	{S_PITTSBURGH, S_NEW_YORK, 2, WHITE, GREEN},
+	{S_PITTSBURGH, S_TORONTO, 2, GRAY, NONE},
+	{S_TORONTO, S_MONTREAL, 3, GRAY, NONE},
+	{S_MONTREAL, S_BOSTON, 2, GRAY, GRAY},
+	{S_MONTREAL, S_NEW_YORK, 3, BLUE, NONE},
+	{S_NEW_YORK, S_BOSTON, 2, YELLOW, RED}
+};
+
+static const int objectivesSmall[][3] = {
+	{S_NEW_YORK, S_ATLANTA, 6},
+	{S_MONTREAL, S_ATLANTA, 9},
+	{S_CHICAGO, S_NEW_YORK, 5},
+	{S_SAINT_LOUIS, S_BOSTON, 9},
+	{S_TORONTO, S_NASHVILLE, 6},
+	{S_CHICAGO, S_RALEIGH, 5},
+	{S_SAINT_LOUIS, S_WASHINGTON, 7},
+	{S_BOSTON, S_NASHVILLE, 8},
+	{S_MONTREAL, S_CHICAGO, 7},
+	{S_ATLANTA, S_TORONTO, 6}
+};
+
+/* the tracks have 48 wagons, so each player has only 15 wagons (the game ends before the map is full) */
+const Map mapSmall = {
+	"small", 15,
+	sizeof(citiesSmall) / sizeof(citiesSmall[0]), citiesSmall,
+	sizeof(tracksSmall) / sizeof(tracksSmall[0]), tracksSmall,
+	sizeof(objectivesSmall) / sizeof(objectivesSmall[0]), objectivesSmall
+};
+
+
+
+/* Returns the map with that name (case is ignored), or NULL */
+const Map* findMap(const char* name) {
+	static const Map* maps[] = { &mapUSA, &mapSmall };
+	for (size_t i = 0; i < sizeof(maps) / sizeof(maps[0]); i++)
+		if (strcasecmp(maps[i]->name, name) == 0)
+			return maps[i];
+	return NULL;
+}
@@ -0,0 +1,424 @@
+/*
+Local stand-in for the CGS server (Ticket to Ride)
+
+File: localServer.c
+	Protocol of the server (see localServer.h): the commands, the in-process server and the TCP/Unix server
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "localServer.h"
+#include "clientAPI.h"
+
+
+#define HEAD_SIZE 6                 /* number of bytes to code the size of a message (header) */
+#define MAX_DATA 8192               /* maximum size of the game data and of the board */
+#define DEFAULT_TIMEOUT 10          /* default time given to the client to play (seconds) */
+
+
+/* Send a string to the client */
+static void replyStr(LocalReply reply, void* ctx, const char* msg) {
+	reply(ctx, msg, strlen(msg));
+}
+
+
+/* Seconds elapsed since `t` */
+static double elapsed(const struct timespec* t) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - t->tv_sec) + (now.tv_nsec - t->tv_nsec) * 1e-9;
+}
+
+
+/* Random seed of a game (on 24 bits, never 0), for the games without seed */
+static unsigned int randomSeed(void) {
+	static unsigned int counter = 0;
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	unsigned int x = (unsigned int) now.tv_nsec ^ (unsigned int) now.tv_sec ^ (__sync_fetch_and_add(&counter, 1) * 0x9E3779B9);
+	x ^= x >> 16;
+	x *= 0x45D9F3B;
+	x ^= x >> 16;
+	x &= 0xFFFFFF;
+	return x ? x : 1;
+}
+
+
+/* WAIT_GAME: parse the settings ("TRAINING BOT key=value ...") and start the game
+ * Returns NULL if the game is started (and every answer is sent), or the error message (to send instead of "OK") */
+static const char* waitGame(LocalSession* s, const char* settings, LocalReply reply, void* ctx) {
+	char type[32], botName[32], option[64];
+	const Map* map = &mapUSA;
+	unsigned long seed = 0;
+	int start = -1, timeout = DEFAULT_TIMEOUT;
+	int nbchar;
+	char* end;
+
+	if (sscanf(settings, "%31s %31s%n", type, botName, &nbchar) != 2 || strcmp(type, "TRAINING") != 0)
+		return "Only the training games (TRAINING bot) are available on the local server";
+	if (strcmp(botName, "DO_NOTHING") == 0)
+		s->bot = BOT_DO_NOTHING;
+	else if (strcmp(botName, "PLAY_RANDOM") == 0 || strcmp(botName, "NICE_BOT") == 0 || strcmp(botName, "RANDOM_PLAYER") == 0)
+		s->bot = BOT_PLAY_RANDOM;
+	else
+		return "Unknown training bot";
+
+	/* options (the unknown keys are ignored, the invalid values are errors) */
+	const char* p = settings + nbchar;
+	while (sscanf(p, "%63s%n", option, &nbchar) == 1) {
+		p += nbchar;
+		char* value = strchr(option, '=');
+		if (!value)
+			continue;
+		*value++ = '\0';
+		if (strcmp(option, "seed") == 0) {
+			seed = strtoul(value, &end, 10);
+			if (*end || !*value || seed > 0xFFFFFF)
+				return "Invalid value for the option 'seed'";
+		}
+		else if (strcmp(option, "start") == 0) {
+			if (strcmp(value, "0") && strcmp(value, "1"))
+				return "Invalid value for the option 'start' (should be '0' or '1')";
+			start = value[0] - '0';
+		}
+		else if (strcmp(option, "map") == 0) {
+			map = findMap(value);
+			if (!map)
+				return "Invalid value for the option 'map' (should be 'USA' or 'small')";
+		}
+		else if (strcmp(option, "timeout") == 0) {
+			timeout = (int) strtol(value, &end, 10);
+			if (*end || !*value || timeout <= 0)
+				return "Invalid value for the option 'timeout'";
+		}
+	}
+
+	/* the game (the same seed gives the same game, and the same starter if it is not given) */
+	if (!seed)
+		seed = randomSeed();
+	if (start < 0)
+		start = (seed >> 7) & 1;
+	initLocalGame(&s->game, map, seed, start);
+	s->playing = true;
+	s->timeout = timeout;
+
+	char name[64], sizes[32];
+	snprintf(name, sizeof(name), "%06lx-%s", seed, botName);
+	snprintf(sizes, sizeof(sizes), "%d %d", map->nbCities, map->nbTracks);
+	replyStr(reply, ctx, "OK");
+	replyStr(reply, ctx, name);
+	replyStr(reply, ctx, sizes);
+	return NULL;
+}
+
+
+/* Send the result of a move: answer (or move and message) and return code */
+static void replyCode(LocalReply reply, void* ctx, MoveState state) {
+	char code[8];
+	snprintf(code, sizeof(code), "%d", (int) state);
+	replyStr(reply, ctx, code);
+}
+
+
+
+/* -------------------------------------
+ * Initialize a session (a newly connected client)
+ *
+ * Parameters:
+ * - s: the session
+ */
+void initLocalSession(LocalSession* s) {
+	memset(s, 0, sizeof(LocalSession));
+	s->timeout = DEFAULT_TIMEOUT;
+}
+
+
+/* -------------------------------------
+ * Execute a command of the client, and send every answer (acknowledgment "OK" first, or an error message instead)
+ *
+ * Parameters:
+ * - s: session of the client
+ * - cmd: the command (NUL-terminated)
+ * - reply: function used to send a message to the client (each call is one message)
+ * - ctx: given to `reply`
+ */
+void localCommand(LocalSession* s, const char* cmd, LocalReply reply, void* ctx) {
+	char buf[MAX_DATA];
+	LocalMove result;
+	int values[5];
+	const char* error = NULL;
+
+	if (strncmp(cmd, "CLIENT_NAME ", 12) == 0) {
+		snprintf(s->name, sizeof(s->name), "%.*s", (int) sizeof(s->name) - 1, cmd + 12);
+		replyStr(reply, ctx, "OK");
+	}
+	else if (strncmp(cmd, "WAIT_GAME ", 10) == 0)
+		error = waitGame(s, cmd + 10, reply, ctx);
+	else if (strcmp(cmd, "GET_GAME_DATA") == 0) {
+		if (s->playing) {
+			int n = writeGameData(&s->game, buf, sizeof(buf));
+			replyStr(reply, ctx, "OK");
+			reply(ctx, buf, n);
+			replyStr(reply, ctx, s->game.starter ? "1" : "0");
+			clock_gettime(CLOCK_MONOTONIC, &s->turnStart);
+		}
+		else
+			error = "No game (WAIT_GAME first)";
+	}
+	else if (strcmp(cmd, "GET_MOVE") == 0) {
+		if (s->playing && !s->game.over) {
+			replyStr(reply, ctx, "OK");
+			if (s->game.current == 0) {
+				/* the client waits while it has to play: it loses */
+				illegalLocalMove(&s->game, 0, "GET_MOVE while it is your turn", &result);
+				replyStr(reply, ctx, result.move);
+				replyStr(reply, ctx, result.answer);
+				replyCode(reply, ctx, WINNING_MOVE);
+			}
+			else {
+				int n = chooseBotMove(&s->game, s->bot, 1, values);
+				playLocalMove(&s->game, 1, values, n, &result);
+				replyStr(reply, ctx, result.move);
+				replyStr(reply, ctx, result.msg);
+				replyCode(reply, ctx, result.state);
+			}
+			clock_gettime(CLOCK_MONOTONIC, &s->turnStart);
+		}
+		else
+			error = "No game in progress";
+	}
+	else if (strncmp(cmd, "PLAY_MOVE", 9) == 0) {
+		if (s->playing && !s->game.over) {
+			/* values of the move (a 6th value makes it invalid) */
+			int n = 0;
+			const char* p = cmd + 9;
+			char* end;
+			while (n < 5) {
+				long v = strtol(p, &end, 10);
+				if (end == p)
+					break;
+				values[n++] = (int) v;
+				p = end;
+			}
+			while (*p == ' ')
+				p++;
+			replyStr(reply, ctx, "OK");
+			if (*p)
+				illegalLocalMove(&s->game, 0, "Invalid move", &result);
+			else if (s->game.current == 0 && elapsed(&s->turnStart) > s->timeout)
+				illegalLocalMove(&s->game, 0, "Timeout", &result);
+			else
+				playLocalMove(&s->game, 0, values, n, &result);
+			replyStr(reply, ctx, result.answer);
+			replyCode(reply, ctx, result.state);
+			clock_gettime(CLOCK_MONOTONIC, &s->turnStart);
+		}
+		else
+			error = "No game in progress";
+	}
+	else if (strcmp(cmd, "DISP_GAME") == 0) {
+		if (s->playing) {
+			int n = writeBoard(&s->game, buf, sizeof(buf));
+			replyStr(reply, ctx, "OK");
+			reply(ctx, buf, n);
+		}
+		else
+			error = "No game (WAIT_GAME first)";
+	}
+	else if (strncmp(cmd, "SEND_COMMENT", 12) == 0)
+		replyStr(reply, ctx, "OK");
+	else
+		error = "Unknown command";
+
+	/* the error is sent instead of the acknowledgment */
+	if (error)
+		replyStr(reply, ctx, error);
+}
+
+
+
+/* in-process server (address "inproc:local") */
+
+static void* localConnect(InprocServer* server, Connection* cnx) {
+	(void) server;
+	(void) cnx;
+	LocalSession* s = malloc(sizeof(LocalSession));
+	if (s)
+		initLocalSession(s);
+	return s;
+}
+
+
+static void localInprocReply(void* ctx, const char* msg, size_t n) {
+	inprocReply(ctx, msg, n);
+}
+
+
+static void localInprocCommand(void* session, Connection* cnx, const char* cmd, size_t n) {
+	(void) n;
+	localCommand(session, cmd, localInprocReply, cnx);
+}
+
+
+InprocServer localServer = { NULL, localConnect, localInprocCommand, free };
+
+
+
+/* TCP / Unix server */
+
+/* a client connected by a socket
+ * all the messages answering a command are framed in `out`, and sent with one write */
+typedef struct {
+	int fd;
+	LocalSession session;
+	char* out;
+	size_t len;
+	size_t size;
+} SocketClient;
+
+
+/* Frame a message in the output buffer of the client (header: size in decimal on 6 characters, padded with spaces) */
+static void socketReply(void* ctx, const char* msg, size_t n) {
+	SocketClient* c = ctx;
+	if (c->len + HEAD_SIZE + n > c->size) {
+		size_t size = 2 * c->size + HEAD_SIZE + n;
+		char* p = realloc(c->out, size);
+		if (!p)
+			return;
+		c->out = p;
+		c->size = size;
+	}
+	char* head = c->out + c->len;
+	size_t v = n;
+	for (int i = HEAD_SIZE - 1; i >= 0; i--) {
+		head[i] = (i == HEAD_SIZE - 1 || v) ? (char) ('0' + v % 10) : ' ';
+		v /= 10;
+	}
+	memcpy(head + HEAD_SIZE, msg, n);
+	c->len += HEAD_SIZE + n;
+}
+
+
+/* Thread of a client: each read is a command (the client waits for the answer before sending the next one) */
+static void* socketClient(void* arg) {
+	SocketClient* c = arg;
+	char cmd[MAX_COMMAND + 256];
+	ssize_t r;
+
+	while ((r = read(c->fd, cmd, sizeof(cmd) - 1)) > 0) {
+		while (r > 0 && (cmd[r - 1] == '\n' || cmd[r - 1] == '\r'))
+			r--;
+		cmd[r] = '\0';
+		c->len = 0;
+		localCommand(&c->session, cmd, socketReply, c);
+		size_t sent = 0;
+		while (sent < c->len) {
+			ssize_t w = write(c->fd, c->out + sent, c->len - sent);
+			if (w < 0 && errno != EINTR)
+				break;
+			if (w > 0)
+				sent += w;
+		}
+		if (sent < c->len)
+			break;
+	}
+
+	close(c->fd);
+	free(c->out);
+	free(c);
+	return NULL;
+}
+
+
+/* -------------------------------------
+ * Run the server: listen on a TCP port or a Unix socket, and play with every client (one thread each)
+ * Only returns on error
+ *
+ * Parameters:
+ * - address: "unix:PATH" for a Unix socket, otherwise the local address to listen on (NULL for any address)
+ * - port: TCP port
+ *
+ * Returns -1 (and displays the error)
+ */
+int runLocalServer(const char* address, unsigned int port) {
+	int fd, one = 1;
+	bool tcp = !address || strncmp(address, "unix:", 5) != 0;
+
+	if (!tcp) {
+		struct sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (strlen(address + 5) >= sizeof(addr.sun_path)) {
+			fprintf(stderr, "[%s] The path of the Unix socket is too long\n", __FUNCTION__);
+			return -1;
+		}
+		strcpy(addr.sun_path, address + 5);
+		unlink(addr.sun_path);
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0 || bind(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+			perror("runLocalServer: socket");
+			return -1;
+		}
+	}
+	else {
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(port);
+		addr.sin_addr.s_addr = htonl(INADDR_ANY);
+		if (address && inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+			fprintf(stderr, "[%s] Invalid address '%s'\n", __FUNCTION__, address);
+			return -1;
+		}
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd >= 0)
+			setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		if (fd < 0 || bind(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+			perror("runLocalServer: socket");
+			return -1;
+		}
+	}
+	if (listen(fd, 128) < 0) {
+		perror("runLocalServer: listen");
+		return -1;
+	}
+
+	for (;;) {
+		int cfd = accept(fd, NULL, NULL);
+		if (cfd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			perror("runLocalServer: accept");
+			close(fd);
+			return -1;
+		}
+		if (tcp)
+			setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		SocketClient* c = calloc(1, sizeof(SocketClient));
+		pthread_t thread;
+		if (!c) {
+			close(cfd);
+			continue;
+		}
+		c->fd = cfd;
+		initLocalSession(&c->session);
+		if (pthread_create(&thread, NULL, socketClient, c) != 0) {
+			close(cfd);
+			free(c);
+			continue;
+		}
+		pthread_detach(thread);
+	}
+}
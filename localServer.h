@@ -0,0 +1,52 @@
+/*
+Local stand-in for the CGS server (Ticket to Ride)
+
+File: localServer.h
+	Protocol of the server: the commands of the client (CLIENT_NAME, WAIT_GAME, GET_GAME_DATA, GET_MOVE, PLAY_MOVE,
+	DISP_GAME, SEND_COMMENT) are answered exactly as the CGS server does, for training games against the bots of
+	localGame.h. The server can be reached:
+	- in the same program, by the address "inproc:local" (see transport.h, after `registerInprocServer("local", &localServer)`)
+	- by TCP or by a Unix socket, with `runLocalServer` (see serverMain.c)
+
+	WAIT_GAME only accepts "TRAINING BOT key=value ...", with the bots DO_NOTHING and PLAY_RANDOM (NICE_BOT and
+	RANDOM_PLAYER are played by PLAY_RANDOM), and the options:
+	- 'seed': seed of the game (0 or no seed for a random one)
+	- 'start': '0' if the client begins, '1' if the bot begins (random by default)
+	- 'map': 'USA' (default) or 'small'
+	- 'timeout': time given to the client to play a move, in seconds (10 by default)
+*/
+
+#ifndef __LOCAL_SERVER_H__
+#define __LOCAL_SERVER_H__
+
+#include <time.h>
+#include "localGame.h"
+#include "transport.h"
+
+
+/* a session (a connected client) */
+typedef struct {
+    char name[21];                  /* name of the client */
+    bool playing;                   /* true when a game has been given by WAIT_GAME */
+    LocalGame game;
+    BotType bot;
+    int timeout;                    /* seconds given to the client to play */
+    struct timespec turnStart;      /* when the client has got the turn */
+} LocalSession;
+
+
+/* function used to send a message (a frame) to the client */
+typedef void (*LocalReply)(void* ctx, const char* msg, size_t n);
+
+
+/* the server, to be registered as an in-process server */
+extern InprocServer localServer;
+
+
+/* prototypes */
+void initLocalSession(LocalSession* s);
+void localCommand(LocalSession* s, const char* cmd, LocalReply reply, void* ctx);
+int runLocalServer(const char* address, unsigned int port);
+
+
+#endif
@@ -0,0 +1,234 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: logger.c
+	Per-thread lock-free rings of records, written by a background thread (see logger.h)
+*/
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "logger.h"
+
+
+#define LOG_RING_SIZE 65536         /* size of the ring of each thread (a power of 2) */
+#define LOG_RECORD_MAX 1024         /* maximum size of a record (the longer ones are truncated) */
+#define LOG_PERIOD_NS 1000000       /* period of the writer (ns) */
+
+
+/* ring of the records of a thread (single producer: the thread, single consumer: the writer) */
+typedef struct LogRing_ {
+    _Alignas(64) atomic_size_t head;    /* next byte to write to the output (consumer) */
+    _Alignas(64) atomic_size_t tail;    /* end of the records published (producer) */
+    size_t end;                         /* end of the records formatted (producer only; published at the end of a line) */
+    atomic_uint dropped;                /* number of records dropped (the ring was full) */
+    atomic_bool closed;                 /* the thread has exited: the ring is freed once written */
+    struct LogRing_* next;
+    char data[LOG_RING_SIZE];
+} LogRing;
+
+
+int LOG_LEVEL = LOG_INFO;
+
+static FILE* output = NULL;                 /* NULL for stdout */
+static LogRing* rings = NULL;               /* rings of every thread */
+static pthread_mutex_t ringsLock = PTHREAD_MUTEX_INITIALIZER;   /* protects the list, and serializes the consumers */
+static pthread_once_t initOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t ringKey;               /* to close the ring of a thread when it exits */
+static _Thread_local LogRing* myRing = NULL;
+
+
+/* Publish the records formatted by the thread */
+static void publish(LogRing* ring) {
+	atomic_store_explicit(&ring->tail, ring->end, memory_order_release);
+}
+
+
+/* Write to the output what the rings have (the caller holds ringsLock)
+ * The rings of the threads that have exited are freed */
+static void drain(void) {
+	FILE* f = output ? output : stdout;
+	bool written = false;
+
+	for (LogRing** p = &rings; *p;) {
+		LogRing* ring = *p;
+		size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+		size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+		unsigned int dropped = atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+
+		if (head != tail) {
+			size_t from = head % LOG_RING_SIZE, n = tail - head;
+			size_t first = n < LOG_RING_SIZE - from ? n : LOG_RING_SIZE - from;
+			fwrite(ring->data + from, 1, first, f);
+			fwrite(ring->data, 1, n - first, f);
+			atomic_store_explicit(&ring->head, tail, memory_order_release);
+			written = true;
+		}
+		if (dropped) {
+			fprintf(f, "[logger] %u records dropped\n", dropped);
+			written = true;
+		}
+		if (atomic_load_explicit(&ring->closed, memory_order_acquire) && ring->end == tail) {
+			*p = ring->next;
+			free(ring);
+		}
+		else
+			p = &ring->next;
+	}
+	if (written)
+		fflush(f);
+}
+
+
+/* Background writer */
+static void* writerMain(void* arg) {
+	(void) arg;
+	struct timespec period = { 0, LOG_PERIOD_NS };
+	for(;;) {
+		pthread_mutex_lock(&ringsLock);
+		drain();
+		pthread_mutex_unlock(&ringsLock);
+		nanosleep(&period, NULL);
+	}
+	return NULL;
+}
+
+
+/* A thread exits: its last records are published, and its ring is freed by the writer */
+static void closeRing(void* arg) {
+	LogRing* ring = arg;
+	publish(ring);
+	atomic_store_explicit(&ring->closed, true, memory_order_release);
+}
+
+
+/* Start the writer (once) */
+static void initLogger(void) {
+	pthread_t writer;
+	pthread_key_create(&ringKey, closeRing);
+	if (pthread_create(&writer, NULL, writerMain, NULL) == 0)
+		pthread_detach(writer);
+	atexit(logFlush);
+}
+
+
+/* Get the ring of the thread (created at its first record)
+ * Returns NULL if it cannot be allocated */
+static LogRing* getRing(void) {
+	if (myRing)
+		return myRing;
+	pthread_once(&initOnce, initLogger);
+
+	LogRing* ring = calloc(1, sizeof(LogRing));
+	if (!ring)
+		return NULL;
+	pthread_mutex_lock(&ringsLock);
+	ring->next = rings;
+	rings = ring;
+	pthread_mutex_unlock(&ringsLock);
+	pthread_setspecific(ringKey, ring);
+	myRing = ring;
+	return ring;
+}
+
+
+/* Append bytes to the ring of the thread (the record is dropped if it does not fit) */
+static void append(const char* data, size_t n) {
+	LogRing* ring = getRing();
+	if (!ring)
+		return;
+
+	size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	if (n > LOG_RING_SIZE - (ring->end - head)) {
+		atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+		return;
+	}
+	size_t from = ring->end % LOG_RING_SIZE;
+	size_t first = n < LOG_RING_SIZE - from ? n : LOG_RING_SIZE - from;
+	memcpy(ring->data + from, data, first);
+	memcpy(ring->data, data + first, n - first);
+	ring->end += n;
+
+	/* the lines are published whole (so that the lines of the threads are not mixed), or when the ring fills up */
+	if (memchr(data, '\n', n) || ring->end - atomic_load_explicit(&ring->tail, memory_order_relaxed) > LOG_RING_SIZE / 2)
+		publish(ring);
+}
+
+
+
+/* -------------------------------------
+ * Write a record (use the macro LOG, which filters the records by their level)
+ *
+ * Parameters:
+ * - format: (string) printf-like format
+ * - ...: its arguments
+ */
+void logWrite(const char* format, ...) {
+	char record[LOG_RECORD_MAX];
+	va_list args;
+	va_start(args, format);
+	int n = vsnprintf(record, sizeof(record), format, args);
+	va_end(args);
+	if (n > 0)
+		append(record, (size_t) n < sizeof(record) ? (size_t) n : sizeof(record) - 1);
+}
+
+
+/* -------------------------------------
+ * Write raw bytes (a text received from the server, for example), whatever the level
+ * They are published at once, even if they do not end a line (escape sequences of a terminal, for example)
+ *
+ * Parameters:
+ * - data: the bytes
+ * - n: their number
+ */
+void logBytes(const char* data, size_t n) {
+	while (n > 0) {
+		size_t k = n < LOG_RECORD_MAX ? n : LOG_RECORD_MAX;
+		append(data, k);
+		data += k;
+		n -= k;
+	}
+	if (myRing)
+		publish(myRing);
+}
+
+
+/* -------------------------------------
+ * Set the output of the logger (stdout by default)
+ *
+ * Parameters:
+ * - f: (FILE*) the output (NULL for stdout)
+ */
+void logSetOutput(FILE* f) {
+	pthread_mutex_lock(&ringsLock);
+	drain();
+	output = f;
+	pthread_mutex_unlock(&ringsLock);
+}
+
+
+/* -------------------------------------
+ * Create the ring of the calling thread now (otherwise it is allocated at the first record of the thread): to call
+ * before a part of the code that must not allocate anything (see forbidHeap in arena.h)
+ */
+void logInitThread(void) {
+	getRing();
+}
+
+
+/* -------------------------------------
+ * Write at once the records of every thread (called at exit; useful before writing directly to the output)
+ */
+void logFlush(void) {
+	if (myRing)
+		publish(myRing);
+	pthread_mutex_lock(&ringsLock);
+	drain();
+	pthread_mutex_unlock(&ringsLock);
+}
@@ -0,0 +1,61 @@
+/*
+Client for the TicketToRide game with CGS
+
+File: logger.h
+	Asynchronous logger, whose records are filtered at compile time
+
+	A record is written by `LOG(level, format, ...)` (printf-like). If its level is above LOG_MAX_LEVEL, the record is
+	removed by the compiler (nothing is formatted, not even the arguments are evaluated); otherwise, it is written only
+	if its level is not above `LOG_LEVEL` (run time), which costs a single comparison.
+
+	The records are formatted by the thread that logs them, in a lock-free ring of its own, and a background thread
+	writes them (by big blocks) to the output: the threads that log never wait for the I/O. A record that does not fit
+	in the ring (the writer is late) is dropped, and counted. The records of a thread are written when they end a line.
+
+	Headless mode (`LOG_LEVEL = LOG_HEADLESS`): only the errors are written, so a game gives no output per turn; built
+	with -DLOG_MAX_LEVEL=LOG_HEADLESS, the other records are not even compiled.
+*/
+
+#ifndef __LOGGER_H__
+#define __LOGGER_H__
+
+#include <stdio.h>
+
+
+/* levels of the records (the same as the levels of dispDebug, see clientAPI.h) */
+typedef enum {
+    LOG_ERROR = 0,          // errors, and the messages always displayed
+    LOG_INFO,               // progress of the game
+    LOG_DEBUG,              // details (decisions of the bot, etc.)
+    LOG_TRACE               // intern details (messages exchanged with the server, etc.)
+} LogLevel;
+
+#define LOG_HEADLESS LOG_ERROR      /* level of the headless mode: no output during the games */
+
+
+/* the records above this level are removed at compile time */
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL LOG_TRACE
+#endif
+
+
+/* level of the records written (run time), LOG_INFO by default */
+extern int LOG_LEVEL;
+
+
+/* true if the records of this level are written (to skip a whole display, for example) */
+#define LOG_ENABLED(level) ((level) <= LOG_MAX_LEVEL && (level) <= LOG_LEVEL)
+
+/* write a record (printf-like) */
+#define LOG(level, ...) do { if (LOG_ENABLED(level)) logWrite(__VA_ARGS__); } while (0)
+
+
+/* prototypes */
+void logWrite(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void logBytes(const char* data, size_t n);
+void logSetOutput(FILE* f);
+void logFlush(void);
+void logInitThread(void);
+
+
+#endif
@@ -1,137 +1,717 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "ticketToRide.h"
 #include "clientAPI.h"
+#include "localServer.h"
+#include "boardView.h"
+#include "ioThread.h"
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
 
 #define SERVER_ADDRESS "82.29.170.160"
 #define PORT 15001
-#define MAX_CITIES 35
 #define INFINITY 1000000  // Valeur très grande simulant l'infini
-
-int cheminVersObjectif[MAX_CITIES];
+#define MAX_ROUTES 256     // nombre maximal de routes (voies) d'une carte, pour les bitsets de la Position
+#define MOTS_ROUTES (MAX_ROUTES / 64)
+#define MAX_COUPS 2048     // nombre maximal de coups gardés dans l'historique d'une partie
+#define INTERVALLE_REPRISE 16   // une copie de la position (point de reprise) tous les 16 coups de l'historique
+#define MAX_CHEMIN 128     // nombre maximal de villes du chemin vers l'objectif gardées dans une sauvegarde
+#ifndef SEUIL_TAS         // (benchDijkstra.c le remplace par une variable, pour mesurer les deux méthodes)
+#define SEUIL_TAS 16       // au-delà de ce nombre de villes, dijkstra range les villes à traiter dans un tas
+#endif
+#define INACCESSIBLE 255   // distance entre deux villes non reliées dans la table des distances (ou ville suivante absente)
+#define NB_CARTES_WAGON 110     // cartes wagon du jeu : 12 de chaque couleur, et 14 locomotives
+#define MAX_OBJECTIFS 20   // nombre maximal d'objectifs gardés par un joueur
+
+// affichages, par le logger (logger.h) : rien n'est affiché en mode sans affichage (niveau LOG_HEADLESS), et rien
+// n'est compilé au-dessus de LOG_MAX_LEVEL
+#define afficher(...) LOG(LOG_INFO, __VA_ARGS__)
+#define afficherDebug(...) LOG(LOG_DEBUG, __VA_ARGS__)
+#define afficherErreur(...) LOG(LOG_ERROR, __VA_ARGS__)
+#define afficherVille(ville) afficher("%s", getCityName(&contexte, ville))
+
+int* cheminVersObjectif;  // chemin vers l'objectif (nbVilles cases, alloué avec le graphe)
 int cheminLen = 0;
 
 
 
+// tableaux de nbVilles cases, alloués avec le graphe (réutilisés à chaque appel de dijkstra)
 typedef struct {
-    int dist[MAX_CITIES];     // La distance minimale pour atteindre chaque ville
-    int prev[MAX_CITIES];     // Pour chaque ville : la ville précédente dans le chemin optimal
-    bool visited[MAX_CITIES]; // Villes déjà traitées (pas utile à toi après calcul)
+    int* dist;      // La distance minimale pour atteindre chaque ville
+    int* prev;      // Pour chaque ville : la ville précédente dans le chemin optimal
+    int* cle;       // Villes à traiter (pas utile à toi après calcul) : leur distance (INFINITY pour les autres), ou
+                    // leur place dans le tas (-1 si elles n'y sont pas)
+    int* tas;       // Tas binaire des villes à traiter, ordonné par distance (pour les grandes cartes)
 } DijkstraResult;
 
 
-DijkstraResult dijkstra(int from, int nbCities);
+DijkstraResult resultatDijkstra;   // tableaux de dijkstra (voir construireGraphe)
 
-// Structure d'une route entre deux villes
+// Structure d'une route entre deux villes (une par voie : une route double donne deux routes jumelles)
 typedef struct {
     int from;
     int to;
     int length;
     CardColor color;
-    bool taken;
+    int jumelle;    // indice de l'autre voie de la route double (-1 si la route est simple)
 } Route;
 
+// voisin d'une ville, par une route
+typedef struct {
+    int ville;
+    int route;      // indice dans graphe.routes
+} Arete;
+
+// Graphe des routes, au format CSR : les arêtes de la ville v sont aretes[debut[v]] .. aretes[debut[v + 1] - 1]
+// (sa taille vient des données de la partie, et il tient dans le cache L1 : environ 4 Ko pour la carte USA)
+typedef struct {
+    int nbVilles;
+    int nbRoutes;
+    Route* routes;      // nbRoutes routes, contiguës
+    int* debut;         // nbVilles + 1 cases
+    Arete* aretes;      // 2 * nbRoutes arêtes (une par sens)
+} Graphe;
+
+
+// main d'un joueur (les cartes de l'adversaire ne sont pas connues, seulement leur nombre)
+typedef struct {
+    uint8_t cartes[10];
+    uint8_t nbCartes;
+    uint8_t nbWagons;
+} Main;
+
+// État du plateau qui change pendant la partie, en quelques mots machine (88 octets, sans trou) : une position se
+// copie par une affectation, se compare avec memcmp et se hache en quelques instructions (voir hacherPosition)
+typedef struct {
+    uint64_t prises[2][MOTS_ROUTES];    // routes prises par chaque joueur (bit k : graphe.routes[k])
+    Main mains[2];
+} Position;
+_Static_assert(sizeof(Position) == 2 * MOTS_ROUTES * sizeof(uint64_t) + 2 * sizeof(Main), "Position sans trou");
+
+const DijkstraResult* dijkstra(const Graphe* g, const Position* pos, int from);
+
+// Table des plus courts chemins entre toutes les villes, par les routes libres (sur octets : 2 x 1,3 Ko pour la carte
+// USA, dans le cache L1). Calculée au début de la partie, puis mise à jour à chaque route prise (voir majDistances).
+// Elle n'est pas utilisée (n = 0) si la carte a plus de 255 villes, ou une distance qui ne tient pas sur un octet.
+typedef struct {
+    int n;                  // nombre de villes (0 si la table n'est pas utilisée)
+    uint8_t* dist;          // dist[i * n + j] : distance de i à j (INACCESSIBLE s'il n'y a pas de chemin)
+    uint8_t* suivante;      // suivante[i * n + j] : ville après i sur un plus court chemin de i à j (INACCESSIBLE pour j)
+} TableDistances;
+
+ResultCode initDistances(TableDistances* t);
+void calculerDistances();
+void majDistances(int k);
+
+// Plan du bot : le chemin vers l'objectif (cheminVersObjectif, de l'arrivée à la ville où il en est) et les voies dont
+// il dépend. Une route prise n'invalide le plan que s'il y est abonné : les autres coups de l'adversaire ne lui coûtent
+// qu'un test de bit (voir notifierPlan).
+typedef struct {
+    uint64_t abonnement[MOTS_ROUTES];   // voies entre deux villes consécutives du chemin (bit k : graphe.routes[k])
+    bool invalide;                      // une de ces voies a été prise par l'adversaire : le chemin est à recalculer
+} Plan;
+
+void abonnerPlan();
+void notifierPlan(int joueur, int k);
+
+// Coup joué (le nôtre ou celui de l'adversaire), tel qu'il est appliqué à la position : 8 octets
+typedef struct {
+    uint8_t joueur;
+    uint8_t action;         // CLAIM_ROUTE, DRAW_BLIND_CARD, ...
+    uint8_t couleur;        // carte tirée, ou couleur des cartes utilisées pour la route (NONE si inconnue)
+    uint8_t nbLocos;        // locomotives utilisées pour la route
+    uint16_t route;         // route prise (indice dans graphe.routes, AUCUNE_ROUTE si elle n'est pas connue)
+    uint8_t choix;          // objectifs gardés (bits 0 à 2)
+    uint8_t rejoue;         // le joueur doit rejouer après ce coup
+} Evenement;
+
+#define AUCUNE_ROUTE 0xFFFF
+
+// Historique de la partie : tous les coups appliqués, et un point de reprise tous les INTERVALLE_REPRISE coups, pour
+// retrouver la position après n'importe quel coup en rejouant au plus INTERVALLE_REPRISE - 1 coups (voir positionApres)
+typedef struct {
+    Evenement* coups;       // MAX_COUPS coups (dans l'arène de la partie)
+    int nbCoups;
+    Position* reprises;     // reprises[k] : position après k * INTERVALLE_REPRISE coups (reprises[0] : position initiale)
+} Historique;
 
 typedef struct {
-    int nbWagons;
-    int nbCartes;
     int nbObjectifs;
-    int cartes[10];
-    Objective objectifs[20];
+    Objective objectifs[MAX_OBJECTIFS];
 } Joueur;
 
 typedef struct {
     int joueurActif;
     int monId;
     bool phaseInitialeTerminee;
+    bool terminee;              // un coup a fini la partie (voir finDePartie)
     CardColor cartesVisibles[5];
     Joueur joueurs[2];
-    Route* routes[100][100]; // carte [ville1][ville2]
+    Position position;
+    Historique historique;
+    Graphe graphe;
     int toursJoues;
 } Partie;
 
 
+// Sauvegarde de la partie (l'état de la partie et du plan), écrite après chaque tour dans un fichier, pour reprendre
+// la partie si le programme s'arrête (voir sauverPartie et reprendrePartie). Taille fixe, sans pointeur : elle s'écrit
+// et se relit en un seul appel système.
+#define MAGIQUE_SAUVEGARDE 0x53525454u      // "TTRS"
+#define VERSION_SAUVEGARDE 2
+
+typedef struct {
+    uint32_t magique;
+    uint32_t version;
+    uint32_t taille;            // sizeof(Sauvegarde)
+    uint32_t nbCoups;           // coups de l'historique
+    uint64_t numero;            // numéro de la sauvegarde (la plus récente des deux copies du fichier est reprise)
+    uint64_t controle;          // somme de contrôle de ce qui suit (voir controleSauvegarde)
+    char nomPartie[64];         // la partie n'est reprise que si le serveur rend la même (nom, graine, joueur qui
+    int32_t graine;             // commence et carte)
+    int32_t depart;
+    uint64_t controleCarte;     // somme de contrôle des routes de la carte (voir controleCarte)
+    int32_t nbVilles;
+    int32_t nbRoutes;
+    int32_t terminee;           // la partie est finie : la sauvegarde n'est plus reprise
+    int32_t joueurActif;
+    int32_t monId;
+    int32_t phaseInitialeTerminee;
+    int32_t toursJoues;
+    Joueur joueurs[2];
+    Position initiale;          // position au début de la partie (les autres se retrouvent avec l'historique)
+    Position position;
+    int32_t cheminLen;          // plan : chemin vers l'objectif (0 s'il est trop long pour la sauvegarde)
+    int32_t chemin[MAX_CHEMIN];
+    Evenement coups[MAX_COUPS];
+} Sauvegarde;
+
+
 Partie partie;
+GameContext contexte; // contexte de la partie pour l'API (connexion, carte, ...)
+TableDistances distances;  // plus courts chemins entre toutes les villes (voir calculerDistances)
+Plan plan;                 // voies dont dépend le chemin vers l'objectif
+MoveScratch brouillon; // réponses du serveur aux coups, réutilisé à chaque coup (pas d'allocation pendant la partie)
+BoardView plateau;     // plateau suivi localement, affiché sans demander au serveur (DISP_GAME)
+const char* adresseServeur = SERVER_ADDRESS;    // "inproc:local" pour jouer contre le serveur local (localServer.h)
+unsigned int portServeur = PORT;
+const char* parametres = "TRAINING NICE_BOT";
+int fichierSauvegarde = -1;     // fichier des sauvegardes de la partie (-1 : pas de sauvegarde)
+Sauvegarde sauvegarde;          // dernière sauvegarde écrite (hors de la pile : environ 17 Ko)
+bool avecFilReseau = false;     // les coups passent par un fil réseau (voir ioThread.h et envoyerCoup)
+IoThread filReseau;
+bool coupAdverseDemande = false;    // le GET_MOVE du prochain coup de l'adversaire est déjà dans la file du fil réseau
 
-void safeFree(char** ptr) {
-    if (*ptr) {
-        free(*ptr);
-        *ptr = NULL;
+ResultCode Connexion(const char* nomBot) {
+    ResultCode res = connectToCGS(&contexte, adresseServeur, portServeur, nomBot);
+    if (res == ALL_GOOD)
+        afficher("Connexion reussie !\n");
+    else
+        afficherErreur("Erreur connexion : 0x%x\n", res);
+    return res;
+}
+
+
+// Construit le graphe des routes à partir des données de la partie (une route par voie, les routes doubles en ont
+// deux). Tout est alloué en un seul bloc de l'arène de la partie (libéré avec elle), avec les tableaux de dijkstra et
+// le chemin vers l'objectif.
+ResultCode construireGraphe(Graphe* g, const GameData* gameData) {
+    int nbVilles = gameData->nbCities;
+    int nbRoutes = 0;
+    for (int i = 0; i < gameData->nbTracks; i++)
+        nbRoutes += (gameData->trackData[i * 5 + 4] != NONE) ? 2 : 1;
+    if (nbRoutes > MAX_ROUTES)
+        return PARAM_ERROR;
+
+    size_t tailleRoutes = nbRoutes * sizeof(Route);
+    size_t tailleAretes = 2 * nbRoutes * sizeof(Arete);
+    size_t tailleEntiers = (nbVilles + 1 + 5 * nbVilles) * sizeof(int);   // debut, dist, prev, cle, tas, cheminVersObjectif
+    char* bloc = arenaAlloc(&contexte.arena, tailleRoutes + tailleAretes + tailleEntiers);
+    if (!bloc)
+        return MEMORY_ALLOCATION_ERROR;
+
+    g->nbVilles = nbVilles;
+    g->nbRoutes = nbRoutes;
+    g->routes = (Route*) bloc;
+    g->aretes = (Arete*) (bloc + tailleRoutes);
+    g->debut = (int*) (bloc + tailleRoutes + tailleAretes);
+    resultatDijkstra.dist = g->debut + nbVilles + 1;
+    resultatDijkstra.prev = resultatDijkstra.dist + nbVilles;
+    resultatDijkstra.cle = resultatDijkstra.prev + nbVilles;
+    resultatDijkstra.tas = resultatDijkstra.cle + nbVilles;
+    cheminVersObjectif = resultatDijkstra.tas + nbVilles;
+
+    // les routes (les deux voies d'une route double sont jumelles)
+    int k = 0;
+    for (int i = 0; i < gameData->nbTracks; i++) {
+        const int* t = gameData->trackData + i * 5;
+        for (int voie = 0; voie < 2; voie++) {
+            if (voie == 1 && t[4] == NONE)
+                break;
+            g->routes[k] = (Route) { .from = t[0], .to = t[1], .length = t[2], .color = (CardColor) t[3 + voie],
+                                     .jumelle = -1 };
+            if (voie == 1) {
+                g->routes[k].jumelle = k - 1;
+                g->routes[k - 1].jumelle = k;
+            }
+            k++;
+        }
+    }
+
+    // les arêtes, rangées par ville (comptage, puis placement)
+    for (int v = 0; v <= nbVilles; v++)
+        g->debut[v] = 0;
+    for (int r = 0; r < nbRoutes; r++) {
+        g->debut[g->routes[r].from + 1]++;
+        g->debut[g->routes[r].to + 1]++;
+    }
+    for (int v = 0; v < nbVilles; v++)
+        g->debut[v + 1] += g->debut[v];
+    int* suivante = resultatDijkstra.prev;      // position de la prochaine arête de chaque ville (temporaire)
+    for (int v = 0; v < nbVilles; v++)
+        suivante[v] = g->debut[v];
+    for (int r = 0; r < nbRoutes; r++) {
+        g->aretes[suivante[g->routes[r].from]++] = (Arete) { .ville = g->routes[r].to, .route = r };
+        g->aretes[suivante[g->routes[r].to]++] = (Arete) { .ville = g->routes[r].from, .route = r };
     }
+    return ALL_GOOD;
 }
 
-ResultCode Connexion(const char* nomBot) {
-    ResultCode res = connectToCGS(SERVER_ADDRESS, PORT, nomBot);
-    printf(res == ALL_GOOD ? "Connexion reussie !\n" : "Erreur connexion : 0x%x\n", res);
-    return res;
+
+#define BIT_ROUTE(k) ((uint64_t) 1 << ((k) & 63))
+
+// Vrai si la route k n'est prise par personne (à deux joueurs, l'autre voie d'une route double la ferme aussi)
+static inline bool routeLibre(const Position* pos, int k) {
+    uint64_t prises = pos->prises[0][k >> 6] | pos->prises[1][k >> 6];
+    int jumelle = partie.graphe.routes[k].jumelle;
+    if (jumelle >= 0 && ((pos->prises[0][jumelle >> 6] | pos->prises[1][jumelle >> 6]) & BIT_ROUTE(jumelle)))
+        return false;
+    return !(prises & BIT_ROUTE(k));
+}
+
+
+// Le joueur prend la route k
+static inline void prendreRoute(Position* pos, int joueur, int k) {
+    pos->prises[joueur][k >> 6] |= BIT_ROUTE(k);
+}
+
+
+// Hachage d'une position (pour une table de transposition, par exemple)
+uint64_t hacherPosition(const Position* pos) {
+    uint64_t h = 0;
+    for (size_t i = 0; i < sizeof(Position); i += sizeof(uint64_t)) {
+        uint64_t mot;
+        memcpy(&mot, (const char*) pos + i, sizeof(mot));
+        h = (h ^ mot) * 0x9E3779B97F4A7C15ull;
+    }
+    return h ^ (h >> 29);
+}
+
+
+static inline bool positionsEgales(const Position* a, const Position* b) {
+    return memcmp(a, b, sizeof(Position)) == 0;
+}
+
+
+// Route libre entre deux villes, qui peut être prise avec cette couleur (la route de cette couleur d'abord, puis une
+// route grise) ; une locomotive peut prendre n'importe quelle voie. Renvoie -1 s'il n'y en a pas.
+int trouverRoute(int from, int to, CardColor couleur) {
+    Graphe* g = &partie.graphe;
+    int trouvee = -1;
+    for (int a = g->debut[from]; a < g->debut[from + 1]; a++) {
+        Route* r = &g->routes[g->aretes[a].route];
+        if (g->aretes[a].ville != to || !routeLibre(&partie.position, g->aretes[a].route))
+            continue;
+        if (r->color == couleur)
+            return g->aretes[a].route;
+        if (r->color == LOCOMOTIVE || couleur == LOCOMOTIVE)
+            trouvee = g->aretes[a].route;
+    }
+    return trouvee;
+}
+
+
+// Route libre entre deux villes pour laquelle on a le plus de cartes (NULL s'il n'y en a pas)
+Route* meilleureRoute(int from, int to) {
+    Graphe* g = &partie.graphe;
+    Main* moi = &partie.position.mains[partie.monId];
+    Route* meilleure = NULL;
+    for (int a = g->debut[from]; a < g->debut[from + 1]; a++) {
+        Route* r = &g->routes[g->aretes[a].route];
+        if (g->aretes[a].ville == to && routeLibre(&partie.position, g->aretes[a].route) &&
+            (!meilleure || moi->cartes[r->color] > moi->cartes[meilleure->color]))
+            meilleure = r;
+    }
+    return meilleure;
+}
+
+
+// Applique un coup à une position (les cartes de l'adversaire ne sont pas connues : seulement leur nombre change)
+void appliquerCoup(Position* pos, const Evenement* e) {
+    Main* m = &pos->mains[e->joueur];
+    bool moi = (e->joueur == partie.monId);
+
+    switch (e->action) {
+        case CLAIM_ROUTE: {
+            if (e->route == AUCUNE_ROUTE)
+                break;
+            uint8_t longueur = partie.graphe.routes[e->route].length;
+            m->nbWagons = (m->nbWagons > longueur) ? m->nbWagons - longueur : 0;
+            m->nbCartes = (m->nbCartes > longueur) ? m->nbCartes - longueur : 0;
+            if (moi) {
+                m->cartes[e->couleur] -= longueur - e->nbLocos;
+                m->cartes[LOCOMOTIVE] -= e->nbLocos;
+            }
+            prendreRoute(pos, e->joueur, e->route);
+            break;
+        }
+
+        case DRAW_BLIND_CARD:
+        case DRAW_CARD:
+            if (!moi)
+                m->nbCartes++;
+            else if (e->couleur < 10) {     // une carte invalide n'est pas comptée
+                m->cartes[e->couleur]++;
+                m->nbCartes++;
+            }
+            break;
+
+        default:                            // les objectifs ne changent pas la position
+            break;
+    }
+}
+
+
+// Commence l'historique de la partie, à partir de la position initiale
+ResultCode initHistorique(Historique* h) {
+    h->coups = arenaAlloc(&contexte.arena, MAX_COUPS * sizeof(Evenement));
+    h->reprises = arenaAlloc(&contexte.arena, (MAX_COUPS / INTERVALLE_REPRISE + 1) * sizeof(Position));
+    if (!h->coups || !h->reprises)
+        return MEMORY_ALLOCATION_ERROR;
+    h->nbCoups = 0;
+    h->reprises[0] = partie.position;
+    return ALL_GOOD;
+}
+
+
+// Enregistre un coup réussi (le nôtre ou celui de l'adversaire) dans l'historique, et l'applique à la position de la
+// partie : c'est le seul endroit où la position change pendant la partie. Renvoie le coup enregistré.
+Evenement enregistrerCoup(int joueur, const MoveData* move, const MoveResult* result) {
+    Evenement e = { .joueur = joueur, .action = move->action, .couleur = NONE, .route = AUCUNE_ROUTE,
+                    .rejoue = result->replay };
+
+    switch (move->action) {
+        case CLAIM_ROUTE: {
+            int indice = trouverRoute(move->claimRoute.from, move->claimRoute.to, move->claimRoute.color);
+            e.couleur = move->claimRoute.color;
+            e.nbLocos = move->claimRoute.nbLocomotives;
+            if (indice >= 0)
+                e.route = indice;
+            break;
+        }
+        case DRAW_BLIND_CARD:
+            e.couleur = result->card;
+            break;
+        case DRAW_CARD:
+            e.couleur = move->drawCard;
+            break;
+        case CHOOSE_OBJECTIVES:
+            for (int i = 0; i < 3; i++)
+                e.choix |= move->chooseObjectives[i] << i;
+            break;
+        default:
+            break;
+    }
+
+    appliquerCoup(&partie.position, &e);
+    if (e.action == CLAIM_ROUTE && e.route != AUCUNE_ROUTE) {
+        majDistances(e.route);
+        notifierPlan(joueur, e.route);
+    }
+
+    Historique* h = &partie.historique;
+    if (h->nbCoups < MAX_COUPS) {
+        h->coups[h->nbCoups++] = e;
+        if (h->nbCoups % INTERVALLE_REPRISE == 0)
+            h->reprises[h->nbCoups / INTERVALLE_REPRISE] = partie.position;
+    }
+    return e;
+}
+
+
+// Le coup a-t-il fini la partie ? (son état n'est pas NORMAL_MOVE : gagnée ou perdue, à la fin normale de la partie ou
+// sur un coup illégal) Alors la boucle de jeu s'arrête. Un coup perdant n'est pas enregistré (il peut être illégal : le
+// serveur ne l'a pas joué), notre coup gagnant l'est (dans l'historique et sur le plateau affiché) ; le dernier coup de
+// l'adversaire n'est pas lu par getMoveView.
+bool finDePartie(int joueur, const MoveData* move, const MoveResult* result) {
+    if (result->state == NORMAL_MOVE)
+        return false;
+
+    if (joueur == partie.monId && result->state == WINNING_MOVE) {
+        enregistrerCoup(joueur, move, result);
+        boardViewMove(&plateau, 0, move, result);
+    }
+    partie.terminee = true;
+    afficher("\n Partie %s : %s\n", (result->state == WINNING_MOVE) == (joueur == partie.monId) ? "gagnée" : "perdue",
+             result->message ? result->message : "");
+    return true;
+}
+
+
+// Position de la partie après les n premiers coups de l'historique (0 : position initiale), retrouvée à partir du
+// point de reprise précédent : pour revoir un tour passé, ou annuler des coups pendant une recherche
+void positionApres(int n, Position* pos) {
+    const Historique* h = &partie.historique;
+    if (n > h->nbCoups)
+        n = h->nbCoups;
+    *pos = h->reprises[n / INTERVALLE_REPRISE];
+    for (int k = n - n % INTERVALLE_REPRISE; k < n; k++)
+        appliquerCoup(pos, &h->coups[k]);
+}
+
+
+// Somme de contrôle d'une sauvegarde : tout ce qui suit le champ `controle`, jusqu'au dernier coup de l'historique
+uint64_t controleSauvegarde(const Sauvegarde* s) {
+    const unsigned char* debut = (const unsigned char*) &s->controle + sizeof(s->controle);
+    const unsigned char* fin = (const unsigned char*) &s->coups[s->nbCoups];
+    uint64_t h = 0x9E3779B97F4A7C15ULL, mot;
+    for (; debut + sizeof(mot) <= fin; debut += sizeof(mot)) {
+        memcpy(&mot, debut, sizeof(mot));
+        h = (h ^ mot) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
+
+// Somme de contrôle des routes de la carte (pour ne reprendre une sauvegarde que sur la même carte)
+uint64_t controleCarte(const GameData* gameData) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < 5 * gameData->nbTracks; i++) {
+        h = (h ^ (uint32_t) gameData->trackData[i]) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
+
+// Ouvre (ou crée) le fichier des sauvegardes de la partie ; il est vidé si la partie n'est pas reprise
+ResultCode ouvrirSauvegarde(const char* fichier, bool reprise) {
+    fichierSauvegarde = open(fichier, O_RDWR | O_CREAT | (reprise ? 0 : O_TRUNC), 0644);
+    if (fichierSauvegarde < 0) {
+        afficherErreur("Impossible d'ouvrir le fichier de sauvegarde %s\n", fichier);
+        return PARAM_ERROR;
+    }
+    return ALL_GOOD;
+}
+
+
+// Sauvegarde la partie (à la fin de chaque tour, et à la fin de la partie pour la marquer terminée) : un seul pwrite de taille fixe, sans allocation. Le fichier a deux
+// emplacements, écrits à tour de rôle : si le programme s'arrête pendant une écriture, l'autre sauvegarde reste valide.
+// (pas de fsync : la sauvegarde survit à l'arrêt du programme, pas à celui de la machine)
+void sauverPartie(const GameData* gameData) {
+    if (fichierSauvegarde < 0)
+        return;
+
+    Sauvegarde* s = &sauvegarde;
+    const Historique* h = &partie.historique;
+    if (s->magique != MAGIQUE_SAUVEGARDE) {       // première sauvegarde de la partie (le reste est à zéro)
+        s->magique = MAGIQUE_SAUVEGARDE;
+        s->version = VERSION_SAUVEGARDE;
+        s->taille = sizeof(Sauvegarde);
+        strncpy(s->nomPartie, gameData->gameName, sizeof(s->nomPartie) - 1);
+        s->graine = gameData->gameSeed;
+        s->depart = gameData->starter;
+        s->controleCarte = controleCarte(gameData);
+        s->nbVilles = partie.graphe.nbVilles;
+        s->nbRoutes = partie.graphe.nbRoutes;
+        s->initiale = h->reprises[0];
+    }
+    s->numero++;
+    s->terminee = partie.terminee;
+    s->joueurActif = partie.joueurActif;
+    s->monId = partie.monId;
+    s->phaseInitialeTerminee = partie.phaseInitialeTerminee;
+    s->toursJoues = partie.toursJoues;
+    memcpy(s->joueurs, partie.joueurs, sizeof(s->joueurs));
+    s->position = partie.position;
+    s->cheminLen = (cheminLen <= MAX_CHEMIN) ? cheminLen : 0;
+    memcpy(s->chemin, cheminVersObjectif, s->cheminLen * sizeof(int));
+    memcpy(s->coups + s->nbCoups, h->coups + s->nbCoups, (h->nbCoups - s->nbCoups) * sizeof(Evenement));
+    s->nbCoups = h->nbCoups;
+    s->controle = controleSauvegarde(s);
+
+    if (pwrite(fichierSauvegarde, s, sizeof(Sauvegarde), (s->numero % 2) * sizeof(Sauvegarde)) != sizeof(Sauvegarde))
+        afficherErreur("Erreur d'écriture de la sauvegarde\n");
+}
+
+
+// Les villes et les joueurs d'une sauvegarde existent-ils, et l'historique redonne-t-il la position sauvegardée ? (les
+// routes prises doivent exister) Une sauvegarde abîmée ne doit pas faire lire hors des tableaux de la partie.
+bool sauvegardeValide(const Sauvegarde* s) {
+    if (s->monId < 0 || s->monId > 1 || s->joueurActif < 0 || s->joueurActif > 1
+        || s->cheminLen < 0 || s->cheminLen > s->nbVilles || s->cheminLen > MAX_CHEMIN)
+        return false;
+    for (int i = 0; i < s->cheminLen; i++)
+        if (s->chemin[i] < 0 || s->chemin[i] >= s->nbVilles)
+            return false;
+    for (int p = 0; p < 2; p++) {
+        const Joueur* j = &s->joueurs[p];
+        if (j->nbObjectifs < 0 || j->nbObjectifs > MAX_OBJECTIFS)
+            return false;
+        for (int i = 0; i < j->nbObjectifs; i++)
+            if (j->objectifs[i].from >= (unsigned int) s->nbVilles || j->objectifs[i].to >= (unsigned int) s->nbVilles)
+                return false;
+    }
+
+    Position pos = s->initiale;
+    for (uint32_t k = 0; k < s->nbCoups; k++) {
+        const Evenement* e = &s->coups[k];
+        if (e->joueur > 1 || (e->action == CLAIM_ROUTE && e->route != AUCUNE_ROUTE && e->route >= s->nbRoutes))
+            return false;
+        appliquerCoup(&pos, e);
+    }
+    return positionsEgales(&pos, &s->position);
+}
+
+
+// Reprend la partie sauvegardée, si le serveur a rendu la même partie (même nom, même graine, même joueur qui commence
+// et même carte) et qu'elle n'est pas terminée : l'état de la partie, l'historique (les points de reprise sont
+// recalculés), le plan et le plateau affiché. Les cartes visibles ne sont pas sauvegardées : ce sont celles que le
+// serveur a données avec les données de la partie (contexte.faceUp), mises à jour ensuite par chaque coup.
+// Renvoie true si la partie a été reprise.
+bool reprendrePartie(const GameData* gameData) {
+    Sauvegarde* s = &sauvegarde;
+    static Sauvegarde autre;
+    int valides = 0;
+
+    // la plus récente des deux sauvegardes valides
+    for (int k = 0; k < 2; k++) {
+        Sauvegarde* lue = valides ? &autre : s;
+        if (pread(fichierSauvegarde, lue, sizeof(Sauvegarde), k * sizeof(Sauvegarde)) != sizeof(Sauvegarde)
+            || lue->magique != MAGIQUE_SAUVEGARDE || lue->version != VERSION_SAUVEGARDE
+            || lue->taille != sizeof(Sauvegarde) || lue->nbCoups > MAX_COUPS || lue->controle != controleSauvegarde(lue))
+            continue;
+        if (valides && autre.numero > s->numero)
+            *s = autre;
+        valides++;
+    }
+    if (!valides || strncmp(s->nomPartie, gameData->gameName, sizeof(s->nomPartie) - 1) != 0
+        || s->graine != gameData->gameSeed || s->depart != gameData->starter
+        || s->controleCarte != controleCarte(gameData)
+        || s->nbVilles != partie.graphe.nbVilles || s->nbRoutes != partie.graphe.nbRoutes
+        || s->terminee || !sauvegardeValide(s)) {
+        if (valides && s->terminee)
+            afficherErreur("La sauvegarde est celle d'une partie terminée : elle n'est pas reprise\n");
+        else if (valides)
+            afficherErreur("La sauvegarde est celle d'une autre partie, ou elle est incohérente : elle n'est pas reprise\n");
+        memset(s, 0, sizeof(Sauvegarde));
+        if (ftruncate(fichierSauvegarde, 0) != 0) {     // les sauvegardes de cette partie la remplacent
+            afficherErreur("Impossible de vider le fichier de sauvegarde : la partie n'est pas sauvegardée\n");
+            close(fichierSauvegarde);
+            fichierSauvegarde = -1;
+        }
+        return false;
+    }
+
+    partie.joueurActif = s->joueurActif;
+    partie.monId = s->monId;
+    partie.phaseInitialeTerminee = s->phaseInitialeTerminee;
+    partie.toursJoues = s->toursJoues;
+    memcpy(partie.joueurs, s->joueurs, sizeof(partie.joueurs));
+    cheminLen = s->cheminLen;
+    memcpy(cheminVersObjectif, s->chemin, cheminLen * sizeof(int));
+
+    // l'historique est rejoué depuis la position initiale (les points de reprise et le plateau sont recalculés)
+    Historique* h = &partie.historique;
+    partie.position = h->reprises[0] = s->initiale;
+    h->nbCoups = 0;
+    for (uint32_t k = 0; k < s->nbCoups; k++) {
+        const Evenement* e = &s->coups[k];
+        appliquerCoup(&partie.position, e);
+        h->coups[h->nbCoups++] = *e;
+        if (h->nbCoups % INTERVALLE_REPRISE == 0)
+            h->reprises[h->nbCoups / INTERVALLE_REPRISE] = partie.position;
+
+        // et le plateau affiché (les objectifs sont copiés ensuite)
+        MoveData move = { .action = e->action };
+        MoveResult result = { .state = NORMAL_MOVE };
+        if (e->action == CLAIM_ROUTE && e->route != AUCUNE_ROUTE)
+            move.claimRoute = (ClaimRouteMove) { partie.graphe.routes[e->route].from, partie.graphe.routes[e->route].to,
+                                                 e->couleur, e->nbLocos };
+        else if (e->action == DRAW_BLIND_CARD)
+            result.card = e->couleur;
+        else if (e->action == DRAW_CARD)
+            move.drawCard = e->couleur;
+        else if (e->action == CHOOSE_OBJECTIVES)
+            for (int i = 0; i < 3; i++)
+                move.chooseObjectives[i] = (e->choix >> i) & 1;
+        if (e->action != CLAIM_ROUTE || e->route != AUCUNE_ROUTE)
+            boardViewMove(&plateau, e->joueur == partie.monId ? 0 : 1, &move, &result);
+    }
+    Joueur* moi = &partie.joueurs[partie.monId];
+    for (int i = 0; i < moi->nbObjectifs && i < BOARD_MAX_OBJECTIVES; i++)
+        plateau.objectives[i] = moi->objectifs[i];
+
+    calculerDistances();
+    abonnerPlan();
+    afficher(" Partie reprise au coup %d (sauvegarde %llu)\n", h->nbCoups, (unsigned long long) s->numero);
+    return true;
 }
 
 
 ResultCode SendParameters(GameData* gameData) {
-    const char* settings = "TRAINING NICE_BOT";
-    ResultCode res = sendGameSettings(settings, gameData);
+    ResultCode res = sendGameSettings(&contexte, parametres, gameData);
 
     if (res == ALL_GOOD) {
-        printf(" Partie : %s | Villes : %d | Routes : %d | Seed : %d\n",
+        afficher(" Partie : %s | Villes : %d | Routes : %d | Seed : %d\n",
                gameData->gameName, gameData->nbCities, gameData->nbTracks, gameData->gameSeed);
 
         partie.monId = 0;
         partie.joueurActif = (gameData->starter == 0) ? 0 : 1;
         partie.phaseInitialeTerminee = false;
 
+        partie.position = (Position) {0};
         for (int p = 0; p < 2; p++) {
-            partie.joueurs[p].nbWagons = 45;
-            partie.joueurs[p].nbCartes = 0;
+            partie.position.mains[p].nbWagons = 45;
             partie.joueurs[p].nbObjectifs = 0;
-            for (int c = 0; c < 10; c++) {
-                partie.joueurs[p].cartes[c] = 0;
-            }
         }
+        partie.position.mains[1 - partie.monId].nbCartes = 4;     // les nôtres sont comptées ci-dessous
 
-        for (int i = 0; i < MAX_CITIES; i++) {
-            for (int j = 0; j < MAX_CITIES; j++) {
-                partie.routes[i][j] = NULL;
-            }
-        }
-
-        for (int i = 0; i < gameData->nbTracks; i++) {
-            int from   = gameData->trackData[i * 5 + 0];
-            int to     = gameData->trackData[i * 5 + 1];
-            int length = gameData->trackData[i * 5 + 2];
-            CardColor color1 = (CardColor)gameData->trackData[i * 5 + 3];
-
-            if (color1 != NONE) {
-                Route* r1 = malloc(sizeof(Route));
-                r1->from = from;
-                r1->to = to;
-                r1->length = length;
-                r1->color = color1;
-                r1->taken = false;
-                partie.routes[from][to] = r1;
-                partie.routes[to][from] = r1;
-            }
-
-            
+        if (construireGraphe(&partie.graphe, gameData) != ALL_GOOD) {
+            afficherErreur("Erreur allocation du graphe des routes\n");
+            return MEMORY_ALLOCATION_ERROR;
         }
 
-        printf("Cartes initiales reçues :\n");
+        afficher("Cartes initiales reçues :\n");
         for (int i = 0; i < 4; i++) {
             CardColor couleur = gameData->cards[i];
-            printf("  Carte %d: couleur %d\n", i + 1, couleur);
+            afficher("  Carte %d: couleur %d\n", i + 1, couleur);
             if (couleur >= 0 && couleur < 10) {
-                partie.joueurs[partie.monId].cartes[couleur]++;
-                partie.joueurs[partie.monId].nbCartes++;
+                partie.position.mains[partie.monId].cartes[couleur]++;
+                partie.position.mains[partie.monId].nbCartes++;
             }
         }
-        printf("\n");
+        afficher("\n");
+
+        if (initHistorique(&partie.historique) != ALL_GOOD) {
+            afficherErreur("Erreur allocation de l'historique\n");
+            return MEMORY_ALLOCATION_ERROR;
+        }
+        if (initDistances(&distances) != ALL_GOOD) {
+            afficherErreur("Erreur allocation de la table des distances\n");
+            return MEMORY_ALLOCATION_ERROR;
+        }
+
+        res = initBoardView(&plateau, &contexte, gameData);
+        if (res != ALL_GOOD)
+            afficherErreur("Erreur initialisation du plateau : 0x%x\n", res);
 
-        free(gameData->gameName);
-        free(gameData->trackData);
     } else {
-        printf("Erreur lors de l'envoi des paramètres : 0x%x\n", res);
+        afficherErreur("Erreur lors de l'envoi des paramètres : 0x%x\n", res);
     }
 
     return res;
@@ -139,35 +719,81 @@ ResultCode SendParameters(GameData* gameData) {
 
 
 void afficherCartesEnMain() {
-    Joueur* moi = &partie.joueurs[partie.monId];
-    printf("\n\n=== Mes cartes en main (%d cartes) ===\n\n", moi->nbCartes);
+    if (!LOG_ENABLED(LOG_INFO))
+        return;
+    Main* moi = &partie.position.mains[partie.monId];
+    Joueur* joueur = &partie.joueurs[partie.monId];
+    afficher("\n\n=== Mes cartes en main (%d cartes) ===\n\n", moi->nbCartes);
     const char* couleurs[] = {"NONE", "PURPLE", "WHITE", "BLUE", "YELLOW", "ORANGE", "BLACK", "RED", "GREEN", "LOCOMOTIVE"};
     
     for (int i = 0; i < 10; i++) {
         if (moi->cartes[i] > 0) {
-            printf("  %s : %d\n", couleurs[i], moi->cartes[i]);
+            afficher("  %s : %d\n", couleurs[i], moi->cartes[i]);
         }
     }
-    printf("\n\nWagons restants : %d\n\n", moi->nbWagons);
+    afficher("\n\nWagons restants : %d\n\n", moi->nbWagons);
     
-    printf("\n\n=== Mes objectifs (%d) ===\n\n", moi->nbObjectifs);
-    for (int i = 0; i < moi->nbObjectifs; i++) {
-        printf("  ");
-        printCity(moi->objectifs[i].from);
-        printf(" -> ");
-        printCity(moi->objectifs[i].to);
-        printf(" (%d points)\n", moi->objectifs[i].score);
+    afficher("\n\n=== Mes objectifs (%d) ===\n\n", joueur->nbObjectifs);
+    for (int i = 0; i < joueur->nbObjectifs; i++) {
+        afficher("  ");
+        afficherVille(joueur->objectifs[i].from);
+        afficher(" -> ");
+        afficherVille(joueur->objectifs[i].to);
+        afficher(" (%d points)\n", joueur->objectifs[i].score);
     }
 }
 
 
+// Attend la réponse du fil réseau à la commande la plus ancienne, et la recopie dans le coup et son résultat (le
+// message du serveur est recopié dans le brouillon : l'événement est rendu au fil réseau)
+ResultCode lireEvenement(MoveData* move, MoveResult* result) {
+    const IoEvent* ev = ioWaitEvent(&filReseau);
+    ResultCode res = ev->code;
+    *move = ev->move;
+    *result = ev->result;
+    if (ev->result.message) {
+        strcpy(brouillon.text, ev->result.message);
+        result->message = brouillon.text;
+    }
+    ioDoneEvent(&filReseau);
+    return res;
+}
+
+
+// Envoie notre coup (voir sendMoveView), par le fil réseau s'il est utilisé. Une route prise ou des objectifs choisis
+// finissent notre tour : la demande du coup de l'adversaire est mise dans la file aussitôt, derrière notre coup (le
+// fil réseau ne l'envoie pas si notre coup a fini la partie).
+ResultCode envoyerCoup(MoveData* move, MoveResult* result) {
+    if (!avecFilReseau)
+        return sendMoveView(&contexte, &brouillon, move, result);
+    ioSendMove(&filReseau, move);
+    if (move->action == CLAIM_ROUTE || move->action == CHOOSE_OBJECTIVES) {
+        ioGetMove(&filReseau);
+        coupAdverseDemande = true;
+    }
+    return lireEvenement(move, result);
+}
+
+
+// Lit le coup de l'adversaire (voir getMoveView), par le fil réseau s'il est utilisé
+ResultCode lireCoup(MoveData* move, MoveResult* result) {
+    if (!avecFilReseau)
+        return getMoveView(&contexte, &brouillon, move, result);
+    if (!coupAdverseDemande)
+        ioGetMove(&filReseau);
+    coupAdverseDemande = false;
+    return lireEvenement(move, result);
+}
+
+
 ResultCode ClaimRoute(int from, int to, CardColor couleur, int nbLocos) {
-    Route* route = partie.routes[from][to];
-    Joueur* moi = &partie.joueurs[partie.monId];
+    int indice = trouverRoute(from, to, couleur);
+    Route* route = (indice >= 0) ? &partie.graphe.routes[indice] : NULL;
+    Main* moi = &partie.position.mains[partie.monId];
 
     //  Vérification route existante
-    if (!route || route->taken) {
-        printf(" Route inexistante ou déjà prise : %d → %d\n", from, to);
+    if (!route) {
+        afficher(" Route inexistante ou déjà prise : %d → %d\n", from, to);
         return 99;
     }
 
@@ -179,29 +805,29 @@ ResultCode ClaimRoute(int from, int to, CardColor couleur, int nbLocos) {
 
     //  Vérifications avant envoi au serveur
     if (wagons < longueur) {
-        printf(" Pas assez de wagons : %d requis, %d disponibles\n", longueur, moi->nbWagons);
+        afficher(" Pas assez de wagons : %d requis, %d disponibles\n", longueur, moi->nbWagons);
         return 99;
     }
 
     if (cartesTotales < longueur) {
-        printf(" Pas assez de cartes (couleur + locos) : %d requis, %d disponibles\n", longueur, cartesTotales);
+        afficher(" Pas assez de cartes (couleur + locos) : %d requis, %d disponibles\n", longueur, cartesTotales);
         return 99;
     }
 
     int cartesClassiques = longueur - nbLocos;
     
     if (cartesCouleur < cartesClassiques) {
-        printf(" Pas assez de cartes %d pour compenser %d classiques\n", cartesCouleur, cartesClassiques);
+        afficher(" Pas assez de cartes %d pour compenser %d classiques\n", cartesCouleur, cartesClassiques);
         return 99;
     }
 
     if (cartesLocos < nbLocos) {
-        printf(" Pas assez de locomotives : %d requis, %d disponibles\n", nbLocos, cartesLocos);
+        afficher(" Pas assez de locomotives : %d requis, %d disponibles\n", nbLocos, cartesLocos);
         return 99;
     }
 
     if (moi->nbCartes < longueur) {
-        printf(" Pas assez de cartes totales (bug possible si >50)\n");
+        afficher(" Pas assez de cartes totales (bug possible si >50)\n");
         return 99;
     }
 
@@ -213,34 +839,27 @@ ResultCode ClaimRoute(int from, int to, CardColor couleur, int nbLocos) {
     move.claimRoute.nbLocomotives = nbLocos;
 
     MoveResult result = {0};
-    ResultCode res = sendMove(&move, &result);
+    ResultCode res = envoyerCoup(&move, &result);
 
     if (res != ALL_GOOD) {
-        printf(" Échec prise de route (serveur) : code 0x%x\n", res);
+        afficherErreur(" Échec prise de route (serveur) : code 0x%x\n", res);
         if (result.message) {
-            printf(" Message du serveur : %s\n", result.message);
+            afficher(" Message du serveur : %s\n", result.message);
         }
-        safeFree(&result.message);
-        safeFree(&result.opponentMessage);
         return res;
     }
 
-    //  Réponse serveur positive → mise à jour locale
-    moi->cartes[couleur] -= cartesClassiques;
-    moi->cartes[LOCOMOTIVE] -= nbLocos;
-    moi->nbCartes -= longueur;
-    moi->nbWagons -= longueur;
-
-    route->taken = true;
-    partie.routes[to][from]->taken = true;
+    //  Réponse serveur positive → mise à jour locale (par l'historique)
+    if (finDePartie(partie.monId, &move, &result))
+        return res;
+    enregistrerCoup(partie.monId, &move, &result);
+    boardViewMove(&plateau, 0, &move, &result);
 
-    printf(" Route prise : ");
-    printCity(from); printf(" → "); printCity(to); printf("\n");
+    afficher(" Route prise : ");
+    afficherVille(from); afficher(" → "); afficherVille(to); afficher("\n");
 
     partie.joueurActif = 1 - partie.joueurActif;
 
-    safeFree(&result.message);
-    safeFree(&result.opponentMessage);
     return res;
 }
 
@@ -249,31 +868,33 @@ ResultCode DrawObjectives(Objective* buffer) {
     MoveData move = { .action = DRAW_OBJECTIVES };
     MoveResult result = {0};
 
-    ResultCode res = sendMove(&move, &result);
+    ResultCode res = envoyerCoup(&move, &result);
     if (res != ALL_GOOD) {
-        printf("Erreur DRAW_OBJECTIVES : 0x%x\n", res);
+        afficherErreur("Erreur DRAW_OBJECTIVES : 0x%x\n", res);
         return res;
     }
+    if (finDePartie(partie.monId, &move, &result))
+        return ALL_GOOD;
+    enregistrerCoup(partie.monId, &move, &result);
+    boardViewMove(&plateau, 0, &move, &result);
 
-    printf("Objectifs reçus :\n");
+    afficher("Objectifs reçus :\n");
     for (int i = 0; i < 3; i++) {
         buffer[i] = result.objectives[i];
-        printf("  Objectif %d : ", i + 1);
-        printCity(buffer[i].from);
-        printf(" -> ");
-        printCity(buffer[i].to);
-        printf(" (%d points)\n", buffer[i].score);
+        afficher("  Objectif %d : ", i + 1);
+        afficherVille(buffer[i].from);
+        afficher(" -> ");
+        afficherVille(buffer[i].to);
+        afficher(" (%d points)\n", buffer[i].score);
     }
 
     // Vérifier si on doit rejouer
     if (result.replay) {
-        printf("\n\n-> On doit (CHOOSE_OBJECTIVES)\n\n");
+        afficher("\n\n-> On doit (CHOOSE_OBJECTIVES)\n\n");
     }
 
     //  PAS de changement de joueur actif ici !
 
-    safeFree(&result.message);
-    safeFree(&result.opponentMessage);
     return ALL_GOOD;
 }
 
@@ -285,35 +906,40 @@ ResultCode ChooseObjectives(Objective* objectifsReçus, bool* choix) {
     move.chooseObjectives[2] = choix[2];
 
     MoveResult result = {0};
-    ResultCode res = sendMove(&move, &result);
+    ResultCode res = envoyerCoup(&move, &result);
     if (res != ALL_GOOD) {
-        printf("Erreur CHOOSE_OBJECTIVES : 0x%x\n", res);
+        afficherErreur("Erreur CHOOSE_OBJECTIVES : 0x%x\n", res);
         return res;
     }
+    if (finDePartie(partie.monId, &move, &result))
+        return ALL_GOOD;
+    enregistrerCoup(partie.monId, &move, &result);
+    boardViewMove(&plateau, 0, &move, &result);
 
     Joueur* moi = &partie.joueurs[partie.monId];
     
     int indexChoisi = moi->nbObjectifs;  // Ajouter APRÈS les existants
     
-    printf("Objectifs choisis :\n");
+    afficher("Objectifs choisis :\n");
     for (int i = 0; i < 3; i++) {
-        if (choix[i]) {
+        if (choix[i] && indexChoisi >= MAX_OBJECTIFS) {
+            afficherErreur("Plus de place pour l'objectif %d : il n'est pas suivi\n", i + 1);
+        }
+        else if (choix[i]) {
             moi->objectifs[indexChoisi] = objectifsReçus[i];
-            printf("  ");
-            printCity(moi->objectifs[indexChoisi].from);
-            printf(" -> ");
-            printCity(moi->objectifs[indexChoisi].to);
-            printf(" (%d points)\n", moi->objectifs[indexChoisi].score);
+            afficher("  ");
+            afficherVille(moi->objectifs[indexChoisi].from);
+            afficher(" -> ");
+            afficherVille(moi->objectifs[indexChoisi].to);
+            afficher(" (%d points)\n", moi->objectifs[indexChoisi].score);
             indexChoisi++;
             moi->nbObjectifs++;
         }
     }
 
     partie.joueurActif = 1 - partie.joueurActif;
-    printf("[CHANGEMENT] Fin de nos objectifs, joueur actif: %d\n", partie.joueurActif);
+    afficher("[CHANGEMENT] Fin de nos objectifs, joueur actif: %d\n", partie.joueurActif);
 
-    safeFree(&result.message);
-    safeFree(&result.opponentMessage);
     return ALL_GOOD;
 }
 
@@ -322,71 +948,65 @@ ResultCode GetMove() {
     MoveData move = {0};
     MoveResult result = {0};
 
-    ResultCode res = getMove(&move, &result);
+    ResultCode res = lireCoup(&move, &result);
     if (res != ALL_GOOD) {
-        printf("Erreur getMove : 0x%x\n", res);
+        afficherErreur("Erreur getMove : 0x%x\n", res);
         return res;
     }
+    if (finDePartie(1 - partie.monId, &move, &result))
+        return ALL_GOOD;
+    Evenement coup = enregistrerCoup(1 - partie.monId, &move, &result);
+    boardViewMove(&plateau, 1, &move, &result);
 
-    printf(" \n\nAdversaire a joué : \n\n");
+    afficher(" \n\nAdversaire a joué : \n\n");
 
     switch (move.action) {
         case DRAW_OBJECTIVES:
-            printf("DRAW_OBJECTIVES\n");
+            afficher("DRAW_OBJECTIVES\n");
             break;
 
         case CHOOSE_OBJECTIVES:
-            printf("CHOOSE_OBJECTIVES (");
+            afficher("CHOOSE_OBJECTIVES (");
             for (int i = 0; i < 3; i++) {
                 if (move.chooseObjectives[i]) {
-                    printf("obj%d ", i + 1);
+                    afficher("obj%d ", i + 1);
                 }
             }
-            printf(")\n");
+            afficher(")\n");
 
             // CHANGEMENT JOUEUR ACTIF : après choix d'objectifs
             partie.joueurActif = 1 - partie.joueurActif;
-            printf(" [CHANGEMENT] Fin objectifs adversaire, joueur actif: %d\n", partie.joueurActif);
+            afficher(" [CHANGEMENT] Fin objectifs adversaire, joueur actif: %d\n", partie.joueurActif);
             break;
 
         case DRAW_BLIND_CARD:
-            printf("\nDRAW_BLIND_CARD\n");
+            afficher("\nDRAW_BLIND_CARD\n");
             if (result.replay) {
-                printf(" (peut rejouer)");
+                afficher(" (peut rejouer)");
             }
-            printf("\n");
-            partie.joueurs[1 - partie.monId].nbCartes++;
+            afficher("\n");
             break;
 
         case DRAW_CARD:
-            printf("DRAW_CARD (couleur %d)", move.drawCard);
+            afficher("DRAW_CARD (couleur %d)", move.drawCard);
             if (result.replay) {
-                printf(" (peut rejouer)");
+                afficher(" (peut rejouer)");
             }
-            printf("\n");
-            partie.joueurs[1 - partie.monId].nbCartes++;
+            afficher("\n");
             break;
 
         case CLAIM_ROUTE:
-            printf("CLAIM_ROUTE de ");
-            printCity(move.claimRoute.from);
-            printf(" à ");
-            printCity(move.claimRoute.to);
-            printf(" (couleur %d, %d locomotives)\n",
+            afficher("CLAIM_ROUTE de ");
+            afficherVille(move.claimRoute.from);
+            afficher(" à ");
+            afficherVille(move.claimRoute.to);
+            afficher(" (couleur %d, %d locomotives)\n",
                    move.claimRoute.color, move.claimRoute.nbLocomotives);
 
-            // Mettre à jour les wagons de l'adversaire
-            if (partie.routes[move.claimRoute.from][move.claimRoute.to]) {
-                int longueur = partie.routes[move.claimRoute.from][move.claimRoute.to]->length;
-                partie.joueurs[1 - partie.monId].nbWagons -= longueur;
-                if (partie.joueurs[1 - partie.monId].nbWagons < 0)
-                    partie.joueurs[1 - partie.monId].nbWagons = 0; // éviter négatif
-                printf(" Adversaire a utilisé %d wagons, il lui en reste : %d\n",
-                       longueur, partie.joueurs[1 - partie.monId].nbWagons);
-
-                // Marquer la route comme prise
-                partie.routes[move.claimRoute.from][move.claimRoute.to]->taken = true;
-                partie.routes[move.claimRoute.to][move.claimRoute.from]->taken = true;
+            // Wagons de l'adversaire (la route est marquée prise par l'historique)
+            if (coup.route != AUCUNE_ROUTE) {
+                afficher(" Adversaire a utilisé %d wagons, il lui en reste : %d\n",
+                       partie.graphe.routes[coup.route].length, partie.position.mains[1 - partie.monId].nbWagons);
             }
             break;
     }
@@ -394,23 +1014,21 @@ ResultCode GetMove() {
     // Gestion du joueur actif selon la phase et rejouabilité
     if (!result.replay && partie.phaseInitialeTerminee && move.action != CHOOSE_OBJECTIVES) {
         partie.joueurActif = 1 - partie.joueurActif;
-        printf(" [CHANGEMENT] Fin tour adversaire, joueur actif: %d\n\n", partie.joueurActif);
+        afficher(" [CHANGEMENT] Fin tour adversaire, joueur actif: %d\n\n", partie.joueurActif);
     } else if (!result.replay && !partie.phaseInitialeTerminee && move.action != CHOOSE_OBJECTIVES) {
-        printf("-> Fin action adversaire (phase initiale)\n");
+        afficher("-> Fin action adversaire (phase initiale)\n");
     } else if (move.action != CHOOSE_OBJECTIVES) {
-        printf("-> L'adversaire doit rejouer\n");
+        afficher("-> L'adversaire doit rejouer\n");
     }
 
     // Affichage des éventuels messages serveur/adversaire
     if (result.opponentMessage) {
-        printf(" Message de l'adversaire : %s\n", result.opponentMessage);
+        afficher(" Message de l'adversaire : %s\n", result.opponentMessage);
     }
     if (result.message) {
-        printf(" Message du serveur : %s\n", result.message);
+        afficher(" Message du serveur : %s\n", result.message);
     }
 
-    safeFree(&result.message);
-    safeFree(&result.opponentMessage);
     return ALL_GOOD;
 }
 
@@ -422,372 +1040,699 @@ ResultCode DrawCard(CardColor couleur) {
     move.action = DRAW_CARD;
     move.drawCard = couleur;
 
-    printf("[Action] Tirer carte visible de couleur : %d\n", couleur);
+    afficher("[Action] Tirer carte visible de couleur : %d\n", couleur);
 
-    ResultCode res = sendMove(&move, &result);
+    ResultCode res = envoyerCoup(&move, &result);
     if (res != ALL_GOOD) {
-        printf(" Erreur lors de l’envoi de DRAW_CARD : code %d\n", res);
+        afficherErreur(" Erreur lors de l’envoi de DRAW_CARD : code %d\n", res);
         return res;
     }
-
-    if (result.state == DRAW_CARD) {
-        partie.joueurs[partie.monId].cartes[result.card]++;
-        partie.joueurs[partie.monId].nbCartes++;
-        printf("[Résultat] Carte reçue : couleur %d\n", result.card);
-    } else {
-        printf(" Résultat inattendu après DRAW_CARD : %d\n", result.state);
-    }
-
-    if (result.message) free(result.message);
-    if (result.opponentMessage) free(result.opponentMessage);
+    if (finDePartie(partie.monId, &move, &result))
+        return res;
+    enregistrerCoup(partie.monId, &move, &result);
+    boardViewMove(&plateau, 0, &move, &result);
+    afficher("[Résultat] Carte reçue : couleur %d\n", couleur);
 
     return res;
 }
 
 
 
-// Fonction pour jouer deux cartes de la pioche
-ResultCode DrawTwoBlindCards() {
-    printf(" \nAction : Tirer 2 cartes de la pioche\n");
-    
-    // Première carte
-    MoveData move1 = { .action = DRAW_BLIND_CARD };
-    MoveResult result1 = {0};
-    
-    ResultCode res = sendMove(&move1, &result1);
-    if (res != ALL_GOOD) {
-        printf("Erreur DRAW_BLIND_CARD 1 : 0x%x\n", res);
-        return res;
-    }
-    
-    printf("\nCarte piochée 1 : couleur %d\n\n", result1.card);
-    
-    // Ajouter la carte à notre main avec vérification
-    Joueur* moi = &partie.joueurs[partie.monId];
-    if (result1.card >= 0 && result1.card < 10) {
-        moi->cartes[result1.card]++;
-        moi->nbCartes++;
-    } else {
-        printf("Attention: carte invalide reçue (%d)\n", result1.card);
+// Nombre de cartes wagon de la pioche et de la défausse (le serveur mélange la défausse quand la pioche est vide) :
+// toutes les cartes, moins celles des deux mains et les cartes visibles
+int cartesEnPioche() {
+    int n = NB_CARTES_WAGON - partie.position.mains[0].nbCartes - partie.position.mains[1].nbCartes;
+    for (int i = 0; i < 5; i++)
+        n -= (contexte.faceUp[i] != NONE);
+    return n;
+}
+
+
+// Choisit la carte à tirer : dans la pioche s'il en reste, sinon une carte visible (pas une locomotive pour la seconde
+// carte du tour). Renvoie false s'il n'y a plus de carte à tirer.
+bool choisirCarte(bool seconde, MoveData* move) {
+    if (cartesEnPioche() > 0) {
+        move->action = DRAW_BLIND_CARD;
+        return true;
     }
-    
-    safeFree(&result1.message);
-    safeFree(&result1.opponentMessage);
-    
-    // Deuxième carte (si on peut rejouer)
-    if (result1.replay) {
-        MoveData move2 = { .action = DRAW_BLIND_CARD };
-        MoveResult result2 = {0};
-        
-        res = sendMove(&move2, &result2);
+    for (int i = 0; i < 5; i++)
+        if (contexte.faceUp[i] != NONE && !(seconde && contexte.faceUp[i] == LOCOMOTIVE)) {
+            move->action = DRAW_CARD;
+            move->drawCard = contexte.faceUp[i];
+            return true;
+        }
+    return false;
+}
+
+
+// Fonction pour tirer deux cartes : de la pioche, ou visibles quand elle est vide
+// Renvoie OTHER_ERROR, sans avoir joué, s'il n'y a plus de carte à tirer.
+ResultCode DrawTwoCards() {
+    afficher(" \nAction : Tirer 2 cartes\n");
+
+    for (int i = 1; i <= 2; i++) {
+        MoveData move = {0};
+        MoveResult result = {0};
+        if (!choisirCarte(i == 2, &move)) {
+            afficher("Plus de carte à tirer\n");
+            if (i == 1)
+                return OTHER_ERROR;
+            break;
+        }
+
+        ResultCode res = envoyerCoup(&move, &result);
         if (res != ALL_GOOD) {
-            printf("Erreur DRAW_BLIND_CARD 2 : 0x%x\n", res);
+            afficherErreur("Erreur tirage de la carte %d : 0x%x\n", i, res);
             return res;
         }
-        
-        printf("Carte piochée 2 : couleur %d\n", result2.card);
-        
-        // Ajouter la carte à notre main avec vérification
-        if (result2.card >= 0 && result2.card < 10) {
-            moi->cartes[result2.card]++;
-            moi->nbCartes++;
-        } else {
-            printf("Attention: carte invalide reçue (%d)\n", result2.card);
+
+        CardColor carte = (move.action == DRAW_CARD) ? move.drawCard : result.card;
+        afficher("\nCarte %s %d : couleur %d\n\n", (move.action == DRAW_CARD) ? "visible" : "piochée", i, carte);
+
+        // Ajouter la carte à notre main (par l'historique, qui ne compte pas une carte invalide)
+        if (finDePartie(partie.monId, &move, &result))
+            return ALL_GOOD;
+        enregistrerCoup(partie.monId, &move, &result);
+        boardViewMove(&plateau, 0, &move, &result);
+        if (carte < 0 || carte >= 10) {
+            afficher("Attention: carte invalide reçue (%d)\n", carte);
         }
-        
-        safeFree(&result2.message);
-        safeFree(&result2.opponentMessage);
+
+        // Deuxième carte (si on peut rejouer)
+        if (!result.replay)
+            break;
     }
-    
+
     //  CHANGEMENT JOUEUR ACTIF #4: Après notre tour de cartes
     partie.joueurActif = 1 - partie.joueurActif;
-    printf(" [CHANGEMENT] Fin de notre tour cartes, joueur actif: %d\n", partie.joueurActif);
-    
+    afficher(" [CHANGEMENT] Fin de notre tour cartes, joueur actif: %d\n", partie.joueurActif);
+
     return ALL_GOOD;
 }
 
 
 // Version alternative avec stratégie intelligente
 void gererPhaseInitiale() {
-    printf("\n=== PHASE INITIALE : OBJECTIFS ===\n");
-    printf(" Mon ID: %d, Joueur actif: %d\n\n", partie.monId, partie.joueurActif);
+    afficher("\n=== PHASE INITIALE : OBJECTIFS ===\n");
+    afficher(" Mon ID: %d, Joueur actif: %d\n\n", partie.monId, partie.joueurActif);
     
     Objective objectifs[3];
 
     // Si c'est notre tour
     if (partie.monId == partie.joueurActif) {
-        printf(" Nous commençons la partie\n");
+        afficher(" Nous commençons la partie\n");
 
         // Notre phase d'objectifs
-        printf("\n--- Notre phase d'objectifs ---\n");
-        if (DrawObjectives(objectifs) != ALL_GOOD) return;
+        afficher("\n--- Notre phase d'objectifs ---\n");
+        if (DrawObjectives(objectifs) != ALL_GOOD || partie.terminee) return;
         
         bool choix[3] = {true, true, true};  // Choisir les 2 premiers
-        if (ChooseObjectives(objectifs, choix) != ALL_GOOD) return;
+        if (ChooseObjectives(objectifs, choix) != ALL_GOOD || partie.terminee) return;
 
-        printf("\n--- Phase d'objectifs de l'adversaire ---\n");
-        if (GetMove() != ALL_GOOD) return; // DRAW_OBJECTIVES
-        if (GetMove() != ALL_GOOD) return; // CHOOSE_OBJECTIVES
+        afficher("\n--- Phase d'objectifs de l'adversaire ---\n");
+        if (GetMove() != ALL_GOOD || partie.terminee) return; // DRAW_OBJECTIVES
+        if (GetMove() != ALL_GOOD || partie.terminee) return; // CHOOSE_OBJECTIVES
     }
     else {
-        printf(" L'adversaire commence la partie\n");
+        afficher(" L'adversaire commence la partie\n");
 
-        printf("\n--- Phase d'objectifs de l'adversaire ---\n");
-        if (GetMove() != ALL_GOOD) return; // DRAW_OBJECTIVES
-        if (GetMove() != ALL_GOOD) return; // CHOOSE_OBJECTIVES
+        afficher("\n--- Phase d'objectifs de l'adversaire ---\n");
+        if (GetMove() != ALL_GOOD || partie.terminee) return; // DRAW_OBJECTIVES
+        if (GetMove() != ALL_GOOD || partie.terminee) return; // CHOOSE_OBJECTIVES
 
-        printf("\n--- Notre phase d'objectifs ---\n");
-        if (DrawObjectives(objectifs) != ALL_GOOD) return;
+        afficher("\n--- Notre phase d'objectifs ---\n");
+        if (DrawObjectives(objectifs) != ALL_GOOD || partie.terminee) return;
         
         bool choix[3] = {true, true, true};  // Choisir les 2 premiers
-        if (ChooseObjectives(objectifs, choix) != ALL_GOOD) return;
+        if (ChooseObjectives(objectifs, choix) != ALL_GOOD || partie.terminee) return;
     }
 
     partie.phaseInitialeTerminee = true;
-    printf("\nPhase initiale terminée ! Début du jeu normal.\n");
+    afficher("\nPhase initiale terminée ! Début du jeu normal.\n");
     afficherCartesEnMain();
 }
 
 
 void boucleTestDijkstra(int from, int to) {
-    printf("\n=== TEST DE DIJKSTRA ===\n");
-    printf("Source : ");
-    printCity(from);
-    printf(" | Destination : ");
-    printCity(to);
-    printf("\n");
+    if (!LOG_ENABLED(LOG_INFO))
+        return;
+    afficher("\n=== TEST DE DIJKSTRA ===\n");
+    afficher("Source : ");
+    afficherVille(from);
+    afficher(" | Destination : ");
+    afficherVille(to);
+    afficher("\n");
 
-    DijkstraResult result = dijkstra(from, MAX_CITIES);
+    const DijkstraResult* result = dijkstra(&partie.graphe, &partie.position, from);
 
     // Afficher tableau dist[]
-    printf("\n--- Tableau des distances minimales ---\n");
-    for (int i = 0; i < MAX_CITIES; i++) {
-        printCity(i);
-        printf(" : %d\n", result.dist[i]);
+    afficher("\n--- Tableau des distances minimales ---\n");
+    for (int i = 0; i < partie.graphe.nbVilles; i++) {
+        afficherVille(i);
+        afficher(" : %d\n", result->dist[i]);
     }
 
     // Afficher tableau prev[]
-    printf("\n--- Tableau des prédécesseurs ---\n");
-    for (int i = 0; i < MAX_CITIES; i++) {
-        printCity(i);
-        printf(" ← ");
-        if (result.prev[i] == -1) {
-            printf("N/A\n");
+    afficher("\n--- Tableau des prédécesseurs ---\n");
+    for (int i = 0; i < partie.graphe.nbVilles; i++) {
+        afficherVille(i);
+        afficher(" ← ");
+        if (result->prev[i] == -1) {
+            afficher("N/A\n");
         } else {
-            printCity(result.prev[i]);
-            printf("\n");
+            afficherVille(result->prev[i]);
+            afficher("\n");
         }
     }
 
     // Afficher le chemin optimal reconstitué
-    printf("\n--- Chemin optimal ---\n");
-    if (result.dist[to] == INFINITY) {
-        printf("Aucun chemin disponible.\n");
+    afficher("\n--- Chemin optimal ---\n");
+    if (result->dist[to] == INFINITY) {
+        afficher("Aucun chemin disponible.\n");
         return;
     }
 
-    int path[MAX_CITIES];
+    int path[partie.graphe.nbVilles];
     int len = 0;
     int current = to;
     while (current != -1) {
         path[len++] = current;
-        current = result.prev[current];
+        current = result->prev[current];
     }
 
-    printf("Chemin : ");
+    afficher("Chemin : ");
     for (int i = len - 1; i >= 0; i--) {
-        printCity(path[i]);
-        if (i > 0) printf(" -> ");
+        afficherVille(path[i]);
+        if (i > 0) afficher(" -> ");
     }
-    printf(" (longueur totale : %d)\n", result.dist[to]);
+    afficher(" (longueur totale : %d)\n", result->dist[to]);
 }
 
 
 
-DijkstraResult dijkstra(int from, int nbCities) {
-    DijkstraResult result;
-    
-    for (int i = 0; i < nbCities; i++) {
-        result.dist[i] = INFINITY;
-        result.prev[i] = -1;
-        result.visited[i] = false;
-    }
-    result.dist[from] = 0;
-
-    for (int count = 0; count < nbCities; count++) {
-        int minDist = INFINITY;
-        int u = -1;
-
-        // Trouver le sommet u avec la plus petite distance non visitée
-        for (int i = 0; i < nbCities; i++) {
-            if (!result.visited[i] && result.dist[i] < minDist) {
-                minDist = result.dist[i];
-                u = i;
+// La ville tas[i] remonte vers la racine du tas, tant que sa distance est plus petite que celle de son parent
+static void monterTas(DijkstraResult* d, int i) {
+    int v = d->tas[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (d->dist[d->tas[parent]] <= d->dist[v])
+            break;
+        d->tas[i] = d->tas[parent];
+        d->cle[d->tas[i]] = i;
+        i = parent;
+    }
+    d->tas[i] = v;
+    d->cle[v] = i;
+}
+
+
+// La ville tas[i] descend dans le tas (de n villes), tant qu'un de ses enfants a une distance plus petite
+static void descendreTas(DijkstraResult* d, int i, int n) {
+    int v = d->tas[i];
+    for (;;) {
+        int enfant = 2 * i + 1;
+        if (enfant >= n)
+            break;
+        if (enfant + 1 < n && d->dist[d->tas[enfant + 1]] < d->dist[d->tas[enfant]])
+            enfant++;
+        if (d->dist[d->tas[enfant]] >= d->dist[v])
+            break;
+        d->tas[i] = d->tas[enfant];
+        d->cle[d->tas[i]] = i;
+        i = enfant;
+    }
+    d->tas[i] = v;
+    d->cle[v] = i;
+}
+
+
+// Relâche les routes libres de la ville u (toutes les routes si pos est NULL) : les villes dont la distance baisse
+// sont mises à jour dans `cle`, ou entrent (remontent) dans le tas
+static inline void relacher(const Graphe* g, const Position* pos, DijkstraResult* d, int u, bool tas, int* nbTas) {
+    for (int a = g->debut[u]; a < g->debut[u + 1]; a++) {
+        int v = g->aretes[a].ville;
+        int k = g->aretes[a].route;
+        if (pos && !routeLibre(pos, k))
+            continue;
+        int alt = d->dist[u] + g->routes[k].length;
+        if (alt < d->dist[v]) {     // v n'est pas encore traitée (les distances des villes traitées sont <= dist[u])
+            d->dist[v] = alt;
+            d->prev[v] = u;
+            if (!tas)
+                d->cle[v] = alt;
+            else if (d->cle[v] < 0) {
+                d->tas[*nbTas] = v;
+                monterTas(d, (*nbTas)++);
             }
+            else
+                monterTas(d, d->cle[v]);
         }
+    }
+}
 
-        if (u == -1) break;  // Tous les sommets accessibles ont été visités
-        result.visited[u] = true;
 
-        // Mettre à jour les distances de ses voisins
-        for (int v = 0; v < nbCities; v++) {
-            Route* r = partie.routes[u][v];
-            if (r && !r->taken) {
-                int alt = result.dist[u] + r->length;
-                if (alt < result.dist[v]) {
-                    result.dist[v] = alt;
-                    result.prev[v] = u;
-                }
+// Traite les villes du tas (nbTas villes), de la plus proche à la plus lointaine
+static void viderTas(const Graphe* g, const Position* pos, DijkstraResult* d, int nbTas) {
+    while (nbTas > 0) {
+        int u = d->tas[0];
+        d->cle[u] = -1;     // traitée : sa distance ne baissera plus
+        if (--nbTas > 0) {
+            d->tas[0] = d->tas[nbTas];
+            descendreTas(d, 0, nbTas);
+        }
+        relacher(g, pos, d, u, true, &nbTas);
+    }
+}
+
+
+// Plus courts chemins depuis la ville `from`, par les routes libres de la position `pos` (par toutes les routes si
+// pos est NULL). Sur une petite carte, la prochaine ville à traiter est cherchée dans le tableau `cle` (une boucle sans
+// branchement, vectorisée par le compilateur en -O3) ; au-delà de SEUIL_TAS villes, elle est prise dans un tas binaire, en
+// O(nbRoutes log nbVilles). Les résultats sont dans les tableaux de resultatDijkstra (valables jusqu'à l'appel suivant).
+const DijkstraResult* dijkstra(const Graphe* g, const Position* pos, int from) {
+    DijkstraResult* d = &resultatDijkstra;
+    int n = g->nbVilles;
+    bool tas = (n > SEUIL_TAS);
+
+    for (int i = 0; i < n; i++) {
+        d->dist[i] = INFINITY;
+        d->prev[i] = -1;
+        d->cle[i] = tas ? -1 : INFINITY;
+    }
+    d->dist[from] = 0;
+
+    if (!tas) {
+        d->cle[from] = 0;
+        for (;;) {
+            // la ville non traitée la plus proche (les villes traitées ou non atteintes ont la clé INFINITY)
+            int min = INFINITY;
+            for (int i = 0; i < n; i++)
+                min = (d->cle[i] < min) ? d->cle[i] : min;
+            if (min == INFINITY)
+                break;      // Toutes les villes accessibles ont été traitées
+            int u = 0;
+            while (d->cle[u] != min)
+                u++;
+            d->cle[u] = INFINITY;
+            relacher(g, pos, d, u, false, NULL);
+        }
+    }
+    else {
+        d->tas[0] = from;
+        d->cle[from] = 0;
+        viderTas(g, pos, d, 1);
+    }
+    return d;
+}
+
+
+// Calcule la ligne et la colonne de la ville s dans la table : distances depuis s (et vers s, les routes vont dans
+// les deux sens), et ville suivante vers s (la précédente dans l'arbre des plus courts chemins depuis s)
+// Renvoie false si une distance ne tient pas sur un octet.
+static bool calculerLigne(TableDistances* t, int s) {
+    const DijkstraResult* d = dijkstra(&partie.graphe, &partie.position, s);
+    int n = t->n;
+    for (int i = 0; i < n; i++) {
+        int dist = d->dist[i];
+        if (dist == INFINITY)
+            dist = INACCESSIBLE;
+        else if (dist >= INACCESSIBLE)
+            return false;
+        t->dist[s * n + i] = t->dist[i * n + s] = dist;
+        t->suivante[i * n + s] = (d->prev[i] < 0) ? INACCESSIBLE : d->prev[i];
+    }
+    return true;
+}
+
+
+// Calcule toute la table des distances (au début de la partie, ou quand elle est reprise)
+void calculerDistances() {
+    TableDistances* t = &distances;
+    t->n = (t->dist && partie.graphe.nbVilles < INACCESSIBLE) ? partie.graphe.nbVilles : 0;
+    for (int s = 0; s < t->n; s++)
+        if (!calculerLigne(t, s)) {
+            t->n = 0;
+            return;
+        }
+}
+
+
+// Alloue la table des distances (dans l'arène de la partie) et la calcule
+ResultCode initDistances(TableDistances* t) {
+    int n = partie.graphe.nbVilles;
+    t->n = 0;
+    if (n >= INACCESSIBLE)
+        return ALL_GOOD;        // trop de villes : dijkstra est appelé à chaque fois
+    t->dist = arenaAlloc(&contexte.arena, 2 * n * n);
+    if (!t->dist)
+        return MEMORY_ALLOCATION_ERROR;
+    t->suivante = t->dist + n * n;
+    calculerDistances();
+    return ALL_GOOD;
+}
+
+
+// Répare la ligne de la ville s quand l'arête de b à son parent (dans l'arbre des plus courts chemins depuis s) a
+// disparu : seules les villes du sous-arbre de b (dont le chemin vers s passe par b) changent. Elles repartent de
+// leurs voisines hors du sous-arbre, puis un dijkstra limité à elles recalcule leurs distances.
+// Renvoie false si une distance ne tient pas sur un octet.
+static bool reparerLigne(TableDistances* t, int s, int b) {
+    const Graphe* g = &partie.graphe;
+    DijkstraResult* d = &resultatDijkstra;
+    int n = t->n;
+    uint8_t touchee[n];         // 1 : dans le sous-arbre de b, 0 : non, 2 : pas encore connu
+    int pile[n];
+
+    memset(touchee, 2, n);
+    touchee[s] = 0;
+    touchee[b] = 1;
+    for (int v = 0; v < n; v++) {
+        // remonte l'arbre jusqu'à une ville connue ; toutes celles du chemin sont dans le même cas qu'elle
+        int nb = 0, u = v;
+        while (touchee[u] == 2 && t->suivante[u * n + s] != INACCESSIBLE) {
+            pile[nb++] = u;
+            u = t->suivante[u * n + s];
+        }
+        uint8_t etat = (touchee[u] == 2) ? 0 : touchee[u];     // ville non atteinte : elle le reste
+        while (nb > 0)
+            touchee[pile[--nb]] = etat;
+        touchee[u] = etat;
+    }
+
+    // les villes hors du sous-arbre gardent leur distance ; celles du sous-arbre entrent dans le tas par leurs voisines
+    for (int v = 0; v < n; v++) {
+        int dist = t->dist[s * n + v];
+        d->dist[v] = (touchee[v] || dist == INACCESSIBLE) ? INFINITY : dist;
+        d->prev[v] = -1;
+        d->cle[v] = -1;
+    }
+    int nbTas = 0;
+    for (int v = 0; v < n; v++) {
+        if (!touchee[v])
+            continue;
+        for (int a = g->debut[v]; a < g->debut[v + 1]; a++) {
+            int u = g->aretes[a].ville;
+            int alt = d->dist[u] + g->routes[g->aretes[a].route].length;
+            if (!touchee[u] && d->dist[u] != INFINITY && routeLibre(&partie.position, g->aretes[a].route) && alt < d->dist[v]) {
+                d->dist[v] = alt;
+                d->prev[v] = u;
             }
         }
+        if (d->dist[v] != INFINITY) {
+            d->tas[nbTas] = v;
+            monterTas(d, nbTas++);
+        }
     }
+    viderTas(g, &partie.position, d, nbTas);
+
+    for (int v = 0; v < n; v++) {
+        if (!touchee[v])
+            continue;
+        int dist = d->dist[v];
+        if (dist == INFINITY)
+            dist = INACCESSIBLE;
+        else if (dist >= INACCESSIBLE)
+            return false;
+        t->dist[s * n + v] = t->dist[v * n + s] = dist;
+        t->suivante[v * n + s] = (d->prev[v] < 0) ? INACCESSIBLE : d->prev[v];
+    }
+    return true;
+}
 
-    return result;
+
+// Met à jour la table des distances quand la route k (de a à b) est prise : les distances ne peuvent que grandir, et
+// seulement depuis les villes s dont l'arbre des plus courts chemins (la colonne s de `suivante`) passe de a à b, et
+// seulement pour les villes au-delà de cette arête (voir reparerLigne). Les autres arbres restent des arbres de plus
+// courts chemins : ils ne changent pas.
+void majDistances(int k) {
+    TableDistances* t = &distances;
+    int n = t->n;
+    if (n == 0)
+        return;
+
+    const Route* r = &partie.graphe.routes[k];
+    for (int s = 0; s < n; s++) {
+        int b = (t->suivante[r->to * n + s] == r->from) ? r->to
+              : (t->suivante[r->from * n + s] == r->to) ? r->from : -1;
+        if (b >= 0 && !reparerLigne(t, s, b)) {
+            t->n = 0;
+            return;
+        }
+    }
+}
+
+
+// Plus court chemin de `from` à `to` par les routes libres, rangé de `to` (chemin[0]) à `from`
+// (lu dans la table des distances, ou calculé par dijkstra si elle n'est pas utilisée)
+// Renvoie son nombre de villes (0 s'il n'y a pas de chemin).
+int plusCourtChemin(int from, int to, int* chemin) {
+    const TableDistances* t = &distances;
+    int len = 0;
+
+    if (t->n) {
+        if (t->dist[to * t->n + from] == INACCESSIBLE)
+            return 0;
+        for (int v = to; v != INACCESSIBLE; v = t->suivante[v * t->n + from])
+            chemin[len++] = v;
+        return len;
+    }
+
+    const DijkstraResult* result = dijkstra(&partie.graphe, &partie.position, from);
+    if (result->dist[to] == INFINITY)
+        return 0;
+    for (int v = to; v != -1; v = result->prev[v])
+        chemin[len++] = v;
+    return len;
+}
+
+
+
+// Abonne le plan aux voies de son chemin ; il est invalide si une étape du chemin n'a plus de voie libre
+void abonnerPlan() {
+    const Graphe* g = &partie.graphe;
+    memset(plan.abonnement, 0, sizeof(plan.abonnement));
+    plan.invalide = false;
+    for (int i = cheminLen - 1; i > 0; i--) {
+        int u = cheminVersObjectif[i], v = cheminVersObjectif[i - 1];
+        bool libre = false;
+        for (int a = g->debut[u]; a < g->debut[u + 1]; a++)
+            if (g->aretes[a].ville == v) {
+                int k = g->aretes[a].route;
+                plan.abonnement[k >> 6] |= BIT_ROUTE(k);
+                libre |= routeLibre(&partie.position, k);
+            }
+        if (!libre)
+            plan.invalide = true;
+    }
+}
+
+
+// La route k vient d'être prise par le joueur : le plan est invalide si l'adversaire l'a prise et qu'il y est abonné
+// (nos routes le font avancer, voir jouerTourVersObjectif)
+void notifierPlan(int joueur, int k) {
+    if (joueur != partie.monId && (plan.abonnement[k >> 6] & BIT_ROUTE(k)))
+        plan.invalide = true;
 }
 
-int ObjMAX(Joueur* joueur) {
+
+// Le plan est-il jouable ? Chaque étape du chemin a une route libre, et il reste assez de wagons pour toutes les
+// prendre (sinon, on n'a pas de plan : le bot pioche, voir jouerTourVersObjectif)
+bool planJouable() {
+    if (cheminLen <= 1 || plan.invalide)
+        return false;
+    int wagons = 0;
+    for (int i = cheminLen - 1; i > 0; i--) {
+        Route* r = meilleureRoute(cheminVersObjectif[i], cheminVersObjectif[i - 1]);
+        if (!r)
+            return false;
+        wagons += r->length;
+    }
+    return wagons <= partie.position.mains[partie.monId].nbWagons;
+}
+
+
+// Recalcule le plan invalide : le plus court chemin par les routes libres, de la ville où il en est à son arrivée
+// (cheminVersObjectif[0]), lu dans la table des distances. Plus de plan s'il n'est plus jouable.
+void replanifier() {
+    int depuis = cheminVersObjectif[cheminLen - 1];
+    afficher(" Une route du chemin a été prise : nouveau chemin depuis ");
+    afficherVille(depuis);
+    afficher("\n");
+    cheminLen = plusCourtChemin(depuis, cheminVersObjectif[0], cheminVersObjectif);
+    abonnerPlan();
+    if (!planJouable()) {
+        afficher(" Plus de chemin jouable vers cet objectif\n");
+        cheminLen = 0;
+    }
+}
+
+
+// Objectif qui rapporte le plus de points, parmi ceux qui ne sont pas écartés (bit i de `ecartes` : objectif i)
+// Renvoie -1 s'il n'y en a pas.
+int ObjMAX(Joueur* joueur, uint32_t ecartes) {
     if (joueur->nbObjectifs <= 0) {
-        printf("Aucun objectif en main.\n");
+        afficher("Aucun objectif en main.\n");
         return -1;
     }
 
-    int maxPoints = joueur->objectifs[0].score;  // On initialise avec le premier score réel
-    int indexMax = 0;
+    int maxPoints = -1;
+    int indexMax = -1;
 
-    printf("\n[DEBUG] Liste des objectifs du joueur :\n");
+    afficherDebug("\n[DEBUG] Liste des objectifs du joueur :\n");
 
     for (int i = 0; i < joueur->nbObjectifs; i++) {
         int score = joueur->objectifs[i].score;
         int from = joueur->objectifs[i].from;
         int to = joueur->objectifs[i].to;
 
-        printf("  Objectif[%d] : ", i);
-        printCity(from);
-        printf(" -> ");
-        printCity(to);
-        printf(" | Score : %d\n", score);
+        afficherDebug("  Objectif[%d] : %s -> %s | Score : %d\n", i,
+                      getCityName(&contexte, from), getCityName(&contexte, to), score);
 
-        if (score > maxPoints) {
+        if (!(ecartes & (1u << i)) && score > maxPoints) {
             maxPoints = score;
             indexMax = i;
         }
     }
 
-    printf("[DEBUG] Objectif avec le plus haut score : index %d (score %d)\n", indexMax, maxPoints);
+    afficherDebug("[DEBUG] Objectif avec le plus haut score : index %d (score %d)\n", indexMax, maxPoints);
     return indexMax;
 }
 
 
+// Planifie le chemin vers l'objectif qui rapporte le plus de points, parmi ceux dont le chemin est jouable (voir
+// planJouable). Sans objectif jouable, il n'y a pas de plan (cheminLen = 0) : le bot pioche.
 void CheminObjMAX() {
     Joueur* moi = &partie.joueurs[partie.monId];
-    int indexObjectif = ObjMAX(moi);
+    uint32_t ecartes = 0;
+    int indexObjectif;
+
+    for (;;) {
+        indexObjectif = ObjMAX(moi, ecartes);
+        if (indexObjectif == -1) {
+            afficher("Aucun objectif jouable.\n");
+            cheminLen = 0;
+            return;
+        }
 
-    if (indexObjectif == -1 || moi->nbObjectifs == 0) {
-        printf("Aucun objectif trouvé.\n");
-        cheminLen = 0;
-        return;
+        int from = moi->objectifs[indexObjectif].from;
+        int to = moi->objectifs[indexObjectif].to;
+        cheminLen = plusCourtChemin(from, to, cheminVersObjectif);
+        abonnerPlan();
+        if (planJouable())
+            break;
+        ecartes |= 1u << indexObjectif;     // pas de chemin, ou pas assez de wagons : l'objectif suivant
     }
 
-    int from = moi->objectifs[indexObjectif].from;
-    int to = moi->objectifs[indexObjectif].to;
+    const Objective* objectif = &moi->objectifs[indexObjectif];
+    afficher("\n=== PLANIFICATION : Objectif à haut score ===\n");
+    afficher("Objectif sélectionné : ");
+    afficherVille(objectif->from);
+    afficher(" -> ");
+    afficherVille(objectif->to);
+    afficher(" (%d points)\n", objectif->score);
 
-    printf("\n=== PLANIFICATION : Objectif à haut score ===\n");
-    printf("Objectif sélectionné : ");
-    printCity(from);
-    printf(" -> ");
-    printCity(to);
-    printf(" (%d points)\n", moi->objectifs[indexObjectif].score);
+    afficher("Chemin : ");
+    for (int i = cheminLen - 1; i >= 0; i--) {
+        afficherVille(cheminVersObjectif[i]);
+        if (i > 0) afficher(" -> ");
+    }
+    afficher("\n");
+}
 
-    DijkstraResult result = dijkstra(from, MAX_CITIES);
 
-    if (result.dist[to] == INFINITY) {
-        printf("Aucun chemin disponible.\n");
-        cheminLen = 0;
-        return;
-    }
 
-    int current = to;
-    cheminLen = 0;
-    while (current != -1) {
-        cheminVersObjectif[cheminLen++] = current;
-        current = result.prev[current];
+// Prend la première route libre que l'on peut payer avec les cartes de sa couleur (parcourt seulement les routes
+// qui existent ; une route grise, de couleur LOCOMOTIVE, se paie en locomotives). Renvoie true si une route a été prise.
+bool prendreRouteLibre() {
+    Main* moi = &partie.position.mains[partie.monId];
+    for (int k = 0; k < partie.graphe.nbRoutes; k++) {
+        Route* r = &partie.graphe.routes[k];
+        if (routeLibre(&partie.position, k) && moi->nbWagons >= r->length && moi->cartes[r->color] >= r->length) {
+            int nbLocos = (r->color == LOCOMOTIVE) ? r->length : 0;
+            if (ClaimRoute(r->from, r->to, r->color, nbLocos) == ALL_GOOD) {
+                afficher(" Route libre prise (%d → %d)\n", r->from, r->to);
+                return true;
+            }
+        }
     }
+    return false;
+}
 
-    printf("Chemin : ");
-    for (int i = cheminLen - 1; i >= 0; i--) {
-        printCity(cheminVersObjectif[i]);
-        if (i > 0) printf(" -> ");
-    }
-    printf("\n");
+
+// Tire des objectifs, et les garde tous (seulement ceux qui ont été tirés, quand il en reste moins de 3)
+ResultCode piocherObjectifs() {
+    Objective nouveaux[3];
+    ResultCode res = DrawObjectives(nouveaux);
+    if (res != ALL_GOOD || partie.terminee)
+        return res;
+
+    bool choix[3];
+    for (int i = 0; i < 3; i++)
+        choix[i] = (nouveaux[i].score > 0);
+    return ChooseObjectives(nouveaux, choix);
 }
 
 
+// Coup de repli, quand le plan ne donne pas de route à prendre : on ne passe jamais son tour (le serveur attend notre
+// coup). On tire deux cartes ; s'il n'en reste plus, on prend une route libre, ou on tire des objectifs s'il reste de la
+// place pour les trois. Sinon aucun coup n'est joué (la boucle de jeu s'arrête, voir boucleDeJeuPrincipale).
+void jouerCoupDeRepli() {
+    if (DrawTwoCards() == ALL_GOOD || partie.terminee)
+        return;
+    if (prendreRouteLibre())
+        return;
+    if (partie.joueurs[partie.monId].nbObjectifs + 3 > MAX_OBJECTIFS) {
+        afficherErreur(" Plus de carte, de route jouable ni de place pour des objectifs : aucun coup possible\n");
+        return;
+    }
+    afficher(" Plus de carte ni de route jouable : on tire des objectifs\n");
+    piocherObjectifs();
+}
+
 
 void jouerTourVersObjectif() {
-    Joueur* moi = &partie.joueurs[partie.monId];
+    Main* moi = &partie.position.mains[partie.monId];
+
+    // Étape 0 : l'adversaire a pris une route du chemin (voir notifierPlan) → nouveau chemin depuis où on en est
+    if (plan.invalide && cheminLen > 1)
+        replanifier();
 
     // Étape 1 : Générer un chemin si inexistant
     if (cheminLen == 0) {
-        if (moi->nbObjectifs > 0) {
+        if (partie.joueurs[partie.monId].nbObjectifs > 0) {
             CheminObjMAX();  // Version améliorée
         } else {
-            // Plus d'objectifs, on en pioche de nouveaux
-            Objective nouveaux[3];
-            if (DrawObjectives(nouveaux) != ALL_GOOD) return;
-
-            bool choix[3] = {true, true, true};  // On les garde tous
-            if (ChooseObjectives(nouveaux, choix) != ALL_GOOD) return;
-
-            CheminObjMAX();  // Replanification
+            // Plus d'objectifs, on en pioche de nouveaux (c'est notre coup du tour)
+            piocherObjectifs();
+            if (!partie.terminee)
+                CheminObjMAX();  // Replanification
+            return;
         }
     }
 
     // Étape 2 : Si toujours pas de chemin valide
     if (cheminLen <= 1) {
-        printf(" Aucun chemin disponible pour prise de route.\n");
+        afficher(" Aucun chemin disponible pour prise de route.\n");
 
         if (moi->nbCartes > 22) {  // Seuil encore plus agressif
-            printf(" Trop de cartes (%d), recherche d'une route jouable au lieu de piocher.\n", moi->nbCartes);
-            bool aJoue = false;
-
-            for (int i = 0; i < MAX_CITIES && !aJoue; i++) {
-                for (int j = 0; j < MAX_CITIES && !aJoue; j++) {
-                    Route* r = partie.routes[i][j];
-                    if (r && !r->taken && moi->nbWagons >= r->length &&
-                        (moi->cartes[r->color]) >= r->length) {
-                        int locos = (moi->cartes[r->color] >= r->length) ? 0 : r->length - moi->cartes[r->color];
-                        if (ClaimRoute(i, j, r->color, locos) == ALL_GOOD) {
-                            printf(" Route libre prise (%d → %d)\n", i, j);
-                            aJoue = true;
-                        }
-                    }
-                }
-            }
-
-            if (!aJoue) {
-                printf(" Aucune route jouable malgré trop de cartes. On passe le tour.\n");
+            afficher(" Trop de cartes (%d), recherche d'une route jouable au lieu de piocher.\n", moi->nbCartes);
+            if (prendreRouteLibre())
                 return;
-            }
-            return;
+            afficher(" Aucune route jouable malgré trop de cartes. On pioche.\n");
         }
 
-        // Pioche selon les besoins
-        if (moi->nbCartes < 38) {  // Pioche plus activement
-            DrawTwoBlindCards();
-        } else {
-            printf(" Assez de cartes, on passe ce tour.\n");
-        }
+        jouerCoupDeRepli();
         return;
     }
 
     // Étape 3 : Tentative de prise de la prochaine route du chemin
     int from = cheminVersObjectif[cheminLen - 1];
     int to   = cheminVersObjectif[cheminLen - 2];
-    Route* route = partie.routes[from][to];
+    Route* route = meilleureRoute(from, to);
 
-    // Route déjà prise → on réduit le chemin et recommence
-    if (!route || route->taken) {
-        printf(" Route (%d -> %d) inexistante ou déjà prise.\n", from, to);
+    // Route déjà prise (par nous : celles de l'adversaire invalident le plan) → on réduit le chemin et recommence
+    if (!route) {
+        afficher(" Route (%d -> %d) inexistante ou déjà prise.\n", from, to);
         cheminLen--;
         jouerTourVersObjectif();
         return;
@@ -800,84 +1745,57 @@ void jouerTourVersObjectif() {
     int totalCartes = nbCouleur + nbLocos;
 
     if (moi->nbWagons < longueur) {
-        printf(" Pas assez de wagons pour [%d -> %d]\n", from, to);
-        cheminLen--;
+        afficher(" Pas assez de wagons pour [%d -> %d] : plus de plan\n", from, to);
+        cheminLen = 0;
+        jouerCoupDeRepli();
         return;
     }
 
     // Gestion route LOCOMOTIVE
     if (couleur == LOCOMOTIVE) {
         if (nbLocos < longueur) {
-            printf(" Pas assez de LOCOMOTIVES [%d -> %d].\n", from, to);
+            afficher(" Pas assez de LOCOMOTIVES [%d -> %d].\n", from, to);
 
             if (moi->nbCartes > 35) {  // Plus agressif
-                printf(" Trop de cartes (%d), tentative de route alternative.\n", moi->nbCartes);
-                bool aJoue = false;
-                for (int i = 0; i < MAX_CITIES && !aJoue; i++) {
-                    for (int j = 0; j < MAX_CITIES && !aJoue; j++) {
-                        Route* r = partie.routes[i][j];
-                        if (r && !r->taken && moi->nbWagons >= r->length &&
-                            (moi->cartes[r->color]) >= r->length) {
-                            int locos = (moi->cartes[r->color] >= r->length) ? 0 : r->length - moi->cartes[r->color];
-                            if (ClaimRoute(i, j, r->color, locos) == ALL_GOOD) {
-                                printf(" Route libre prise (%d → %d)\n", i, j);
-                                aJoue = true;
-                            }
-                        }
-                    }
-                }
-
-                if (!aJoue) {
-                    printf(" Aucune route jouable. Fin de tour.\n");
+                afficher(" Trop de cartes (%d), tentative de route alternative.\n", moi->nbCartes);
+                if (!prendreRouteLibre()) {
+                    afficher(" Aucune route jouable. On pioche.\n");
+                    jouerCoupDeRepli();
                 }
                 return;
             }
 
-            DrawTwoBlindCards();
+            jouerCoupDeRepli();
             return;
         }
 
         if (ClaimRoute(from, to, couleur, longueur) != ALL_GOOD) {
-            printf(" Échec prise de route LOCOMOTIVE [%d -> %d]\n", from, to);
-            DrawTwoBlindCards();
+            afficher(" Échec prise de route LOCOMOTIVE [%d -> %d]\n", from, to);
+            jouerCoupDeRepli();
             return;
         }
     } else {
         // Gestion route normale
         if (totalCartes < longueur) {
-            printf(" Pas assez de cartes pour [%d -> %d].\n", from, to);
+            afficher(" Pas assez de cartes pour [%d -> %d].\n", from, to);
 
             if (moi->nbCartes > 35) {  // Plus agressif
-                printf(" Trop de cartes (%d), tentative de route alternative.\n", moi->nbCartes);
-                bool aJoue = false;
-                for (int i = 0; i < MAX_CITIES && !aJoue; i++) {
-                    for (int j = 0; j < MAX_CITIES && !aJoue; j++) {
-                        Route* r = partie.routes[i][j];
-                        if (r && !r->taken && moi->nbWagons >= r->length &&
-                            (moi->cartes[r->color]) >= r->length) {
-                            int locos = (moi->cartes[r->color] >= r->length) ? 0 : r->length - moi->cartes[r->color];
-                            if (ClaimRoute(i, j, r->color, locos) == ALL_GOOD) {
-                                printf(" Route libre prise (%d → %d)\n", i, j);
-                                aJoue = true;
-                            }
-                        }
-                    }
-                }
-
-                if (!aJoue) {
-                    printf(" Aucune route jouable. Fin de tour.\n");
+                afficher(" Trop de cartes (%d), tentative de route alternative.\n", moi->nbCartes);
+                if (!prendreRouteLibre()) {
+                    afficher(" Aucune route jouable. On pioche.\n");
+                    jouerCoupDeRepli();
                 }
                 return;
             }
 
-            DrawTwoBlindCards();
+            jouerCoupDeRepli();
             return;
         }
 
         int locosAUtiliser = (nbCouleur >= longueur) ? 0 : longueur - nbCouleur;
         if (ClaimRoute(from, to, couleur, locosAUtiliser) != ALL_GOOD) {
-            printf(" Échec prise de route [%d -> %d].\n", from, to);
-            DrawTwoBlindCards();
+            afficher(" Échec prise de route [%d -> %d].\n", from, to);
+            jouerCoupDeRepli();
             return;
         }
     }
@@ -886,102 +1804,157 @@ void jouerTourVersObjectif() {
     cheminLen--;
 
     if (cheminLen <= 1) {
-        printf(" Étape d'objectif terminée ! Recherche du prochain objectif optimal...\n");
+        afficher(" Étape d'objectif terminée ! Recherche du prochain objectif optimal...\n");
         CheminObjMAX();  // Cherche le PROCHAIN objectif optimal
     }
 }
 
 
 void afficherRoutes() {
-    printf("\n=== ROUTES DISPONIBLES SUR LE PLATEAU ===\n");
-
-    for (int i = 0; i < MAX_CITIES; i++) {
-        for (int j = 0; j < MAX_CITIES; j++) {
-            Route* r = partie.routes[i][j];
-            if (r && i < j) { // éviter les doublons
-                printf("[ID %2d] ", r->from);
-                printCity(r->from);
-                printf(" -> ");
-                printf("[ID %2d] ", r->to);
-                printCity(r->to);
-                printf(" | Longueur: %d | Couleur: %d | Prise: %s\n",
-                       r->length,
-                       r->color,
-                       r->taken ? "OUI" : "NON");
-            }
-        }
+    if (!LOG_ENABLED(LOG_INFO))
+        return;
+    afficher("\n=== ROUTES DISPONIBLES SUR LE PLATEAU ===\n");
+
+    for (int k = 0; k < partie.graphe.nbRoutes; k++) {
+        Route* r = &partie.graphe.routes[k];
+        afficher("[ID %2d] ", r->from);
+        afficherVille(r->from);
+        afficher(" -> ");
+        afficher("[ID %2d] ", r->to);
+        afficherVille(r->to);
+        afficher(" | Longueur: %d | Couleur: %d | Prise: %s%s\n",
+               r->length,
+               r->color,
+               routeLibre(&partie.position, k) ? "NON" : "OUI",
+               r->jumelle >= 0 ? " (route double)" : "");
     }
 
-    printf("=== FIN DE L'AFFICHAGE ===\n");
+    afficher("=== FIN DE L'AFFICHAGE ===\n");
 }
 
 
-void boucleDeJeuPrincipale() {
-    while (true) {
+// Joue la partie jusqu'à sa fin (voir finDePartie). Renvoie ALL_GOOD, ou l'erreur qui l'a interrompue.
+ResultCode boucleDeJeuPrincipale(const GameData* gameData) {
+    while (!partie.terminee) {
         if (partie.joueurActif == partie.monId) {
+            int nbCoups = partie.historique.nbCoups;
             jouerTourVersObjectif();
+            if (partie.historique.nbCoups == nbCoups && !partie.terminee) {
+                afficherErreur(" Aucun coup joué pendant notre tour.\n");
+                return OTHER_ERROR;
+            }
             afficherCartesEnMain();
         } else {
-            if (GetMove() != ALL_GOOD) {
-                printf(" Erreur pendant le tour de l'adversaire.\n");
-                break;
+            ResultCode res = GetMove();
+            if (res != ALL_GOOD) {
+                afficherErreur(" Erreur pendant le tour de l'adversaire.\n");
+                return res;
             }
         }
+        sauverPartie(gameData);     // (marquée terminée si le coup a fini la partie)
+        if (partie.terminee)
+            break;
 
         // afficher un avertissement si les wagons sont faibles
-        Joueur* moi = &partie.joueurs[partie.monId];
-        Joueur* adv = &partie.joueurs[1 - partie.monId];
+        Main* moi = &partie.position.mains[partie.monId];
+        Main* adv = &partie.position.mains[1 - partie.monId];
         if (moi->nbWagons <= 2 || adv->nbWagons <= 2) {
-            printf(" Un des joueurs a 2 wagons ou moins. Fin proche !\n");
+            afficher(" Un des joueurs a 2 wagons ou moins. Fin proche !\n");
         }
 
     }
+    return ALL_GOOD;
 }
 
 
 
-int main() {
+// usage: ./main [adresse [port [parametres [enregistrement [niveau [sauvegarde [reprise [filReseau]]]]]]]]
+// ex: ./main inproc:local 0 "TRAINING PLAY_RANDOM seed=42 map=USA" partie.log
+//     ./main replay:partie.log      (rejoue la partie enregistrée, sans serveur)
+//     ./main inproc:local 0 "TRAINING PLAY_RANDOM" - 0      (sans enregistrement, sans affichage pendant la partie)
+//     ./main 82.29.170.160 15001 "TOURNAMENT x" - 1 partie.sav      (sauvegarde la partie après chaque tour)
+//     ./main 82.29.170.160 15001 "TOURNAMENT x" - 1 partie.sav 1    (après un arrêt : se reconnecte, et reprend la
+//                                                                    partie sauvegardée si le serveur rend la même)
+//     ./main inproc:local 0 "TRAINING PLAY_RANDOM" - 1 - 0 1      (les coups passent par un fil réseau, voir ioThread.h)
+int main(int argc, char** argv) {
     GameData gameData = {0}; // Initialiser à zéro
 
-    printf("===  TICKET TO RIDE - DÉMARRAGE ===\n");
+    if (argc > 1)
+        adresseServeur = argv[1];
+    if (argc > 2)
+        portServeur = atoi(argv[2]);
+    if (argc > 3)
+        parametres = argv[3];
+    if (argc > 4 && strcmp(argv[4], "-") != 0)
+        recordSessions(argv[4]);                   // enregistre les échanges avec le serveur
+    if (argc > 5)
+        LOG_LEVEL = atoi(argv[5]);                 // niveau d'affichage (0 : LOG_HEADLESS, aucun affichage par tour)
+    bool reprise = (argc > 7 && atoi(argv[7]) != 0);
+    avecFilReseau = (argc > 8 && atoi(argv[8]) != 0);
+    if (argc > 6 && strcmp(argv[6], "-") != 0 && ouvrirSauvegarde(argv[6], reprise) != ALL_GOOD)
+        return EXIT_FAILURE;
+    registerInprocServer("local", &localServer);   // serveur local, dans le même programme
+    reportLatencies(stdout);                       // affiche les latences des commandes à la fin de la partie
+
+    afficher("===  TICKET TO RIDE - DÉMARRAGE ===\n");
     
-    printf("\n=== Étape 1: Connexion ===\n");
+    afficher("\n=== Étape 1: Connexion ===\n");
     if (Connexion("Karim") != ALL_GOOD)
         return EXIT_FAILURE;
 
-    printf("\n=== Étape 2: Paramètres ===\n");
+    afficher("\n=== Étape 2: Paramètres ===\n");
     if (SendParameters(&gameData) != ALL_GOOD)
         return EXIT_FAILURE;
 
-    printf("\n=== Étape 3: Affichage plateau ===\n");
-    printBoard();
+    afficher("\n=== Étape 3: Affichage plateau ===\n");
+    if (LOG_ENABLED(LOG_INFO))
+        renderBoard(&plateau, isatty(STDOUT_FILENO) ? BOARD_COLOR : 0);
 
 
-    // Phase initiale : objectifs + première action normale pour chaque joueur
-    gererPhaseInitiale();
+    // Reprise d'une partie sauvegardée (sinon, la sauvegarde précédente est écrasée)
+    if (reprise && fichierSauvegarde >= 0 && !reprendrePartie(&gameData))
+        afficher(" Pas de sauvegarde de cette partie : nouvelle partie\n");
 
-    //Boucle de jeu principale
-    if (partie.phaseInitialeTerminee) {
-        boucleDeJeuPrincipale();
+    // Le fil réseau (s'il est utilisé) a la connexion jusqu'à la fin de la partie
+    if (avecFilReseau && startIoThread(&filReseau, &contexte) != ALL_GOOD) {
+        afficherErreur("Impossible de lancer le fil réseau\n");
+        avecFilReseau = false;
     }
 
+    // Phase initiale : objectifs + première action normale pour chaque joueur
+    if (!partie.phaseInitialeTerminee) {
+        gererPhaseInitiale();
+        sauverPartie(&gameData);
+    }
 
+    //Boucle de jeu principale (aucune allocation sur le tas pendant la partie : vérifié avec -DARENA_CHECK_HEAP, voir
+    // arena.h ; l'anneau du logger est créé avant)
+    ResultCode res = ALL_GOOD;
+    if (partie.phaseInitialeTerminee && !partie.terminee) {
+        logInitThread();
+        forbidHeap();
+        res = boucleDeJeuPrincipale(&gameData);
+        allowHeap();
+    }
+    if (avecFilReseau)
+        stopIoThread(&filReseau);      // les commandes encore en file (après la fin de la partie) ne sont pas envoyées
 
-    printf("On a plus de 50 CARTES ! ");
-    printf("J'ai %d cartes ! ",partie.joueurs[0].nbCartes);
-
-    printf("\n===  FIN DE PARTIE ===\n");
+    // Fin de la partie (ou erreur) : quitGame ferme la connexion, et affiche les latences des commandes
+    afficher("\n===  FIN DE PARTIE ===\n");
+    afficher("J'ai %d cartes ! ", partie.position.mains[partie.monId].nbCartes);
     
     afficherCartesEnMain();
     
-    printf("\n\n L'adversaire lui reste : %d\n\n ",partie.joueurs[1].nbWagons);
+    afficher("\n\n L'adversaire lui reste : %d\n\n ",partie.position.mains[1 - partie.monId].nbWagons);
     
 
     //afficherRoutes();
-    //printBoard();
+    if (LOG_ENABLED(LOG_INFO))
+        renderBoard(&plateau, isatty(STDOUT_FILENO) ? BOARD_COLOR : 0);
+    freeBoardView(&plateau);
 
-    quitGame();
-    return EXIT_SUCCESS;
+    quitGame(&contexte);
+    return (res == ALL_GOOD && partie.terminee) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 ///tout fonctionne sauf la boucle principale et le drawVISIBLEcard !! 
@@ -0,0 +1,134 @@
+/*
+Recording of the sessions with the server
+
+File: recorder.c
+	Write the commands and messages exchanged with the server to a log file (see recorder.h)
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "recorder.h"
+
+
+/* path of the logs of the next connections ("" if the sessions are not recorded) */
+static char recordPath[256] = "";
+static unsigned int nbRecords = 0;         /* number of logs opened (replaces the "%d" of the path) */
+
+
+/* Monotonic time, in nanoseconds */
+uint64_t monotonicNs(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t) t.tv_sec * 1000000000u + t.tv_nsec;
+}
+
+
+/* Write an unsigned integer as a varint */
+static void writeVarint(FILE* f, uint64_t v) {
+	char buf[10];
+	int n = 0;
+	while (v >= 0x80) {
+		buf[n++] = (char) (v | 0x80);
+		v >>= 7;
+	}
+	buf[n++] = (char) v;
+	fwrite(buf, 1, n, f);
+}
+
+
+/* Write the header of a record */
+static void recordHeader(Recorder* rec, char type, size_t size) {
+	uint64_t now = monotonicNs();
+	fputc(type, rec->file);
+	writeVarint(rec->file, now - rec->last);
+	writeVarint(rec->file, size);
+	rec->last = now;
+}
+
+
+
+/* -------------------------------------
+ * Record the sessions of the connections opened from now on
+ *
+ * Parameters:
+ * - path: path of the log file; a "%d" in it is replaced by the number of the connection (so that each one has its
+ *         own log). NULL stops the recording
+ *
+ * Returns false if the path is too long
+ */
+bool recordSessions(const char* path) {
+	if (!path) {
+		recordPath[0] = '\0';
+		return true;
+	}
+	if (strlen(path) >= sizeof(recordPath))
+		return false;
+	strcpy(recordPath, path);
+	return true;
+}
+
+
+/* -------------------------------------
+ * Open the log of a new connection (if the sessions are recorded)
+ *
+ * Returns the recorder, or NULL if the sessions are not recorded (or if the log cannot be opened)
+ */
+Recorder* openSessionRecorder(void) {
+	char path[sizeof(recordPath) + 16];
+	if (!recordPath[0])
+		return NULL;
+
+	/* replace the "%d" (only the first one) */
+	const char* d = strstr(recordPath, "%d");
+	if (d)
+		snprintf(path, sizeof(path), "%.*s%u%s", (int) (d - recordPath), recordPath, nbRecords++, d + 2);
+	else
+		strcpy(path, recordPath);
+
+	Recorder* rec = malloc(sizeof(Recorder));
+	if (!rec)
+		return NULL;
+	rec->file = fopen(path, "wb");
+	if (!rec->file) {
+		free(rec);
+		return NULL;
+	}
+	fwrite(RECORD_MAGIC, 1, RECORD_MAGIC_SIZE, rec->file);
+	rec->last = monotonicNs();
+	return rec;
+}
+
+
+/* Close the log */
+void closeRecorder(Recorder* rec) {
+	if (!rec)
+		return;
+	fclose(rec->file);
+	free(rec);
+}
+
+
+/* Record a command sent (given by pieces) */
+void recordCommand(Recorder* rec, const struct iovec* iov, int niov) {
+	size_t size = 0;
+	for (int i = 0; i < niov; i++)
+		size += iov[i].iov_len;
+	recordHeader(rec, RECORD_COMMAND, size);
+	for (int i = 0; i < niov; i++)
+		fwrite(iov[i].iov_base, 1, iov[i].iov_len, rec->file);
+}
+
+
+/* Record the beginning of a message received, of `size` bytes
+ * (its bytes are given then by `recordBytes`, possibly by chunks) */
+void recordFrame(Recorder* rec, size_t size) {
+	recordHeader(rec, RECORD_FRAME, size);
+}
+
+
+/* Record the bytes of the message being received */
+void recordBytes(Recorder* rec, const char* data, size_t n) {
+	fwrite(data, 1, n, rec->file);
+}
@@ -0,0 +1,47 @@
+#ifndef __RECORDER_H__
+#define __RECORDER_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+
+
+/* Recording of the sessions with the server
+ * When it is enabled (`recordSessions`), every command sent and every message received by a connection is written,
+ * with its (monotonic) time, to a log file. The log can then be played back to the client, without any server, by
+ * the replay transport (addresses "replay:PATH" and "replay-paced:PATH", see transport.h).
+ *
+ * Format of the log: the magic string "CGSREC1\n", then the records
+ *  - type: 1 byte, 'C' for a command sent, 'F' for a message (frame) received
+ *  - time: nanoseconds elapsed since the previous record (since the opening for the 1st one), as a varint
+ *  - size: size of the data, as a varint
+ *  - data
+ * (a varint is an unsigned integer coded on 7 bits per byte, low bits first, with the high bit set on every byte but
+ * the last one)
+ */
+
+#define RECORD_MAGIC "CGSREC1\n"
+#define RECORD_MAGIC_SIZE 8
+#define RECORD_COMMAND 'C'
+#define RECORD_FRAME 'F'
+
+
+/* a recorder (one per connection) */
+typedef struct {
+    FILE* file;
+    uint64_t last;                  /* time of the last record (ns) */
+} Recorder;
+
+
+/* prototypes */
+bool recordSessions(const char* path);
+Recorder* openSessionRecorder(void);
+void closeRecorder(Recorder* rec);
+void recordCommand(Recorder* rec, const struct iovec* iov, int niov);
+void recordFrame(Recorder* rec, size_t size);
+void recordBytes(Recorder* rec, const char* data, size_t n);
+uint64_t monotonicNs(void);
+
+
+#endif
@@ -0,0 +1,224 @@
+/*
+Transports used by the client API to exchange the bytes with the server
+
+File: replayTransport.c
+	Replay transport (see transport.h): a session recorded by the recorder (see recorder.h) is played back to the
+	client, without any server. For each command of the client, the next recorded command is checked and the messages
+	recorded after it are given back (framed as by the CGS server).
+	- "replay:PATH": the messages are given as fast as possible
+	- "replay-paced:PATH": each message is given at the time it was received, relative to its command (the time
+	  taken by the server is reproduced, not the time taken by the client)
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "clientAPI.h"
+
+
+#define HEAD_SIZE 6                 /* number of bytes to code the size of the message (header) */
+
+
+/* a record of the log */
+typedef struct {
+    char type;
+    uint64_t time;                  /* recorded time (ns since the opening of the log) */
+    const char* data;
+    size_t size;
+    size_t next;                    /* position of the following record */
+} Record;
+
+
+/* session played back */
+typedef struct {
+    char* log;                      /* the whole log */
+    size_t size;
+    size_t pos;                     /* position of the next record */
+    uint64_t time;                  /* recorded time of the last record taken */
+    bool paced;
+    uint64_t commandTime;           /* recorded time of the last command */
+    uint64_t commandNow;            /* time when the client has sent it */
+    char head[HEAD_SIZE];           /* header of the message being given */
+    const char* frame;              /* the message being given (NULL if none) */
+    size_t frameSize;
+    size_t given;                   /* bytes of the message (header included) already given */
+    int divergences;                /* number of commands different from the recorded ones */
+} Replay;
+
+
+/* Read a varint at position `*pos` (`*pos` is updated)
+ * Returns false if the log is truncated */
+static bool readVarint(const Replay* r, size_t* pos, uint64_t* v) {
+	*v = 0;
+	for (int shift = 0; *pos < r->size && shift < 64; shift += 7) {
+		unsigned char b = r->log[(*pos)++];
+		*v |= (uint64_t) (b & 0x7F) << shift;
+		if (!(b & 0x80))
+			return true;
+	}
+	return false;
+}
+
+
+/* Get the next record (without taking it)
+ * Returns false at the end of the log (or if it is truncated) */
+static bool peekRecord(const Replay* r, Record* rec) {
+	size_t pos = r->pos;
+	uint64_t delta, size;
+	if (pos >= r->size)
+		return false;
+	rec->type = r->log[pos++];
+	if (!readVarint(r, &pos, &delta) || !readVarint(r, &pos, &size) || size > r->size - pos)
+		return false;
+	rec->time = r->time + delta;
+	rec->data = r->log + pos;
+	rec->size = size;
+	rec->next = pos + size;
+	return true;
+}
+
+
+/* Take the record given by peekRecord */
+static void takeRecord(Replay* r, const Record* rec) {
+	r->pos = rec->next;
+	r->time = rec->time;
+}
+
+
+/* Load the log and check its magic string
+ * Returns false if it cannot be read */
+static bool loadLog(Replay* r, const char* path) {
+	FILE* f = fopen(path, "rb");
+	if (!f)
+		return false;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	r->log = size > 0 ? malloc(size) : NULL;
+	bool ok = r->log && fread(r->log, 1, size, f) == (size_t) size;
+	fclose(f);
+	if (!ok || size < RECORD_MAGIC_SIZE || memcmp(r->log, RECORD_MAGIC, RECORD_MAGIC_SIZE) != 0)
+		return false;
+	r->size = size;
+	r->pos = RECORD_MAGIC_SIZE;
+	return true;
+}
+
+
+/* Wait until the monotonic time `t` (ns) */
+static void waitUntil(uint64_t t) {
+	struct timespec ts = { (time_t) (t / 1000000000u), (long) (t % 1000000000u) };
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+		;
+}
+
+
+
+/* replay transport */
+
+static void replayConnect(Connection* cnx, const char* fct, const char* serverName, unsigned int port, bool nonBlocking) {
+	(void) port;
+	if (nonBlocking)
+		dispError(cnx, fct, "A recorded session (%s) cannot be replayed by a non-blocking connection", serverName);
+
+	Replay* r = calloc(1, sizeof(Replay));
+	if (!r)
+		dispError(cnx, fct, "Cannot allocate the replay");
+	r->paced = strncmp(serverName, "replay-paced:", 13) == 0;
+	const char* path = strchr(serverName, ':') + 1;
+	if (!loadLog(r, path))
+		dispError(cnx, fct, "Cannot read the recorded session '%s'", path);
+	cnx->transportData = r;
+}
+
+
+static ssize_t replayRead(Connection* cnx, char* buf, size_t n) {
+	Replay* r = cnx->transportData;
+	size_t total = 0;
+	Record rec;
+
+	/* give the messages recorded after the last command (not the next command's ones) */
+	while (total < n) {
+		if (!r->frame) {
+			if (!peekRecord(r, &rec) || rec.type != RECORD_FRAME)
+				break;
+			if (r->paced) {
+				uint64_t due = r->commandNow + (rec.time - r->commandTime);
+				if (total > 0 && monotonicNs() < due)
+					break;
+				waitUntil(due);
+			}
+			takeRecord(r, &rec);
+			r->frame = rec.data;
+			r->frameSize = rec.size;
+			r->given = 0;
+			size_t v = rec.size;
+			for (int i = HEAD_SIZE - 1; i >= 0; i--) {
+				r->head[i] = (i == HEAD_SIZE - 1 || v) ? (char) ('0' + v % 10) : ' ';
+				v /= 10;
+			}
+		}
+		/* header, then data */
+		size_t k;
+		if (r->given < HEAD_SIZE) {
+			k = HEAD_SIZE - r->given < n - total ? HEAD_SIZE - r->given : n - total;
+			memcpy(buf + total, r->head + r->given, k);
+		}
+		else {
+			size_t left = r->frameSize - (r->given - HEAD_SIZE);
+			k = left < n - total ? left : n - total;
+			memcpy(buf + total, r->frame + r->given - HEAD_SIZE, k);
+		}
+		total += k;
+		r->given += k;
+		if (r->given == HEAD_SIZE + r->frameSize)
+			r->frame = NULL;
+	}
+	/* 0 (connection closed) when the client waits for a message that has not been recorded */
+	return total;
+}
+
+
+static ssize_t replayExchange(Connection* cnx, const struct iovec* iov, int niov) {
+	Replay* r = cnx->transportData;
+	Record rec;
+	size_t len = 0;
+
+	/* skip what the client has not read of the previous answer */
+	r->frame = NULL;
+	while (peekRecord(r, &rec) && rec.type != RECORD_COMMAND)
+		takeRecord(r, &rec);
+	if (!peekRecord(r, &rec))
+		return -1;
+	takeRecord(r, &rec);
+	r->commandTime = rec.time;
+	r->commandNow = monotonicNs();
+
+	/* compare with the recorded command */
+	bool same = true;
+	for (int i = 0; i < niov; i++) {
+		if (len + iov[i].iov_len > rec.size || memcmp(rec.data + len, iov[i].iov_base, iov[i].iov_len) != 0)
+			same = false;
+		len += iov[i].iov_len;
+	}
+	if (!same || len != rec.size) {
+		if (!r->divergences++)
+			dispDebug(cnx, __FUNCTION__, 0, "The session diverges from the recorded one: '%.*s' was recorded",
+			          (int) rec.size, rec.data);
+	}
+	return len;
+}
+
+
+static void replayClose(Connection* cnx) {
+	Replay* r = cnx->transportData;
+	if (r->divergences)
+		dispDebug(cnx, __FUNCTION__, 0, "%d commands differ from the recorded session", r->divergences);
+	free(r->log);
+	free(r);
+	cnx->transportData = NULL;
+}
+
+
+const Transport replayTransport = { "replay", replayConnect, replayRead, replayExchange, replayClose };
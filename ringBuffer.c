@@ -0,0 +1,88 @@
+/*
+Byte ring used by the client API to receive the messages from the server
+
+File: ringBuffer.c
+	Functions for the RingBuffer type (see ringBuffer.h)
+*/
+
+#include <string.h>
+
+#include "ringBuffer.h"
+
+
+/* Put back the byte replaced by the '\0' of the last view
+ * (the view is then no more terminated, it should not be used anymore)
+*/
+static void rbRelease(RingBuffer* rb) {
+	if (rb->held) {
+		*rb->held = rb->heldByte;
+		rb->held = NULL;
+	}
+}
+
+
+/* Initialize an empty ring buffer */
+void rbInit(RingBuffer* rb) {
+	rb->start = rb->end = 0;
+	rb->held = NULL;
+}
+
+
+/* Returns the number of bytes received but not yet consumed */
+size_t rbAvailable(const RingBuffer* rb) {
+	return rb->end - rb->start;
+}
+
+
+/* ---------------------------------------------------------------
+ * Get the place where new bytes can be written (typically by `read`)
+ * The ring is rewound when it is empty, and the unread bytes are moved back to the front when there is no room
+ * left at the end, so the free space is always contiguous.
+ * The views previously returned by `rbTake` are no longer valid after this call.
+ *
+ * Parameters:
+ * - rb: the ring buffer
+ * - room: filled with the number of bytes that can be written
+ *
+ * Returns a pointer to the free space (`rbCommit` should be called then with the number of bytes written)
+ */
+char* rbWritePtr(RingBuffer* rb, size_t* room) {
+	rbRelease(rb);
+	if (rb->start == rb->end)
+		rb->start = rb->end = 0;
+	else if (rb->end == RING_BUFFER_SIZE && rb->start > 0) {
+		memmove(rb->data, rb->data + rb->start, rb->end - rb->start);
+		rb->end -= rb->start;
+		rb->start = 0;
+	}
+	*room = RING_BUFFER_SIZE - rb->end;
+	return rb->data + rb->end;
+}
+
+
+/* Tell the ring buffer that `n` bytes have been written at the place given by `rbWritePtr` */
+void rbCommit(RingBuffer* rb, size_t n) {
+	rb->end += n;
+}
+
+
+/* ---------------------------------------------------------------
+ * Consume `n` bytes and returns them as a NUL-terminated view
+ * The view stays valid until the next call of a rb* function on this ring.
+ *
+ * Parameters:
+ * - rb: the ring buffer
+ * - n: number of bytes to consume (at most `rbAvailable(rb)`)
+ *
+ * Returns a pointer to the `n` bytes
+ */
+const char* rbTake(RingBuffer* rb, size_t n) {
+	rbRelease(rb);
+	char* view = rb->data + rb->start;
+	rb->start += n;
+	/* terminate the view, but keep the byte following it (start of the next message) */
+	rb->held = view + n;
+	rb->heldByte = *rb->held;
+	*rb->held = '\0';
+	return view;
+}
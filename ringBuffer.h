@@ -0,0 +1,36 @@
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+#include <stddef.h>
+
+
+/* size of a ring buffer (the biggest chunk of a message that can be handed out in one view) */
+#define RING_BUFFER_SIZE 65536
+
+
+/* Byte ring used to receive the messages
+ * Bytes are appended at `end` and consumed from `start`. Instead of wrapping around, the ring rewinds (when it is
+ * empty) or moves its few unread bytes back to the front (when it reaches the end), so that every message handed
+ * out is contiguous and can be used in place (pointer + length view), without any copy.
+ *
+ * A view can also be NUL-terminated in place (so that it can be given to strcmp, sscanf, etc.): the byte following
+ * the view is saved and restored before the ring is modified again.
+ */
+typedef struct {
+    char data[RING_BUFFER_SIZE + 1];    /* +1 to always have room for the terminating '\0' of a view */
+    size_t start;                       /* index of the first unread byte */
+    size_t end;                         /* index following the last received byte */
+    char* held;                         /* byte replaced by the '\0' terminating the last view (NULL if none) */
+    char heldByte;                      /* its original value */
+} RingBuffer;
+
+
+/* prototypes */
+void rbInit(RingBuffer* rb);
+size_t rbAvailable(const RingBuffer* rb);
+char* rbWritePtr(RingBuffer* rb, size_t* room);
+void rbCommit(RingBuffer* rb, size_t n);
+const char* rbTake(RingBuffer* rb, size_t n);
+
+
+#endif
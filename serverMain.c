@@ -0,0 +1,43 @@
+/*
+Local stand-in for the CGS server (Ticket to Ride)
+
+File: serverMain.c
+	Standalone server, for the clients that connect by TCP or by a Unix socket
+	usage: cgsServer [port | unix:PATH]      (port 15001 by default)
+
+	gcc -o cgsServer serverMain.c localServer.c localGame.c localMaps.c clientAPI.c ticketToRide.c ringBuffer.c encoder.c
+	    transport.c uringTransport.c inprocTransport.c replayTransport.c recorder.c latency.c logger.c arena.c -pthread
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#include "localServer.h"
+
+
+#define DEFAULT_PORT 15001
+
+
+int main(int argc, char** argv) {
+	const char* address = NULL;
+	unsigned int port = DEFAULT_PORT;
+
+	if (argc > 1) {
+		if (strncmp(argv[1], "unix:", 5) == 0)
+			address = argv[1];
+		else
+			port = atoi(argv[1]);
+	}
+
+	/* a client that disconnects should not kill the server */
+	signal(SIGPIPE, SIG_IGN);
+
+	if (address)
+		printf("Local CGS server on %s\n", address);
+	else
+		printf("Local CGS server on port %u\n", port);
+	fflush(stdout);
+	return runLocalServer(address, port) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -5,26 +5,376 @@
 #include "clientAPI.h"
 
 
-/* global variables used in intern, so the user do not have to pass them once again) */
-int nbTr;        		/* number of tracks */
-int nbC;				/* number of cities */
-char** cityNames;		/* array of city names (used by printCity) */
-CardColor faceUp[5];   /* store the face up cards returned by the get/sendMove */
+/* where the latencies of each game are printed by quitGame (NULL: they are not printed) */
+static FILE* latencyReport = NULL;
+
 
 /* -----------------------
- * Dummy function that does
- * a string copy (exactly as strcpy)
- * but replace the '_' by ' ' in the same time it does the copy
+ * Intern functions used to decode the answers of the server and encode the moves
+ * They are shared by the functions below and by the asynchronous client (eventLoop.c)
  */
-void strCpyReplace(char* dest, const char* src)
-{
-	while(*src) {
-		if (*src != '_')
-			*dest++ = *src;
-		else
-			*dest++ = ' ';
-		src++;
+
+
+/* Release the data of the previous game (when several games are played on the same connection) */
+static void resetGameData(GameContext* game){
+	resetArena(&game->arena);
+	game->cityOffsets = NULL;
+	game->cityPool = NULL;
+}
+
+
+/* Parse the answer of WAIT_GAME
+ * `gameName` is the name of the game, `sizes` the number of cities and tracks */
+void parseGameSizes(GameContext* game, const char* gameName, const char* sizes, GameData* gameData){
+	resetGameData(game);
+	sscanf(sizes, "%d %d", &game->nbCities, &game->nbTracks);
+	gameData->nbTracks = game->nbTracks;
+	gameData->nbCities = game->nbCities;
+	gameData->gameName = arenaStrdup(&game->arena, gameName);
+	/* get the seed from the name */
+	char seedstr[7];
+	strncpy(seedstr, gameName, 6);
+	seedstr[6] = '\0';
+	sscanf(seedstr, "%x", &gameData->gameSeed);
+}
+
+
+/* Make room for `n` more bytes in the pool of names (its size is doubled when it is full, and the names are moved to
+ * a new place of the arena; the reserve of initGameDataParser is usually enough)
+ * Returns false if it cannot be allocated */
+static bool growNamePool(GameDataParser* parser, size_t n){
+	if (parser->poolLen + n <= parser->poolSize)
+		return true;
+	size_t size = parser->poolSize ? 2 * parser->poolSize : 256;
+	while (size < parser->poolLen + n)
+		size *= 2;
+	char* pool = (char*) arenaAlloc(&parser->game->arena, size);
+	if (!pool)
+		return false;
+	if (parser->poolLen)
+		memcpy(pool, parser->game->cityPool, parser->poolLen);
+	parser->game->cityPool = pool;
+	parser->poolSize = size;
+	return true;
+}
+
+
+/* A token (name or number) is completely read: store it */
+static void endToken(GameDataParser* parser){
+	GameContext* game = parser->game;
+	int field = parser->field++;
+	int value = parser->negative ? -parser->value : parser->value;
+
+	parser->inToken = false;
+	parser->negative = false;
+	parser->value = 0;
+	if (field < game->nbCities) {
+		/* terminate the name (its place has been reserved) */
+		game->cityPool[parser->poolLen++] = '\0';
+		return;
+	}
+	/* then the tracks (5 values each), the 5 face up cards and the 4 initial cards; extra values are ignored */
+	field -= game->nbCities;
+	if (field < 5 * game->nbTracks)
+		parser->gameData->trackData[field] = value;
+	else if ((field -= 5 * game->nbTracks) < 5)
+		game->faceUp[field] = (CardColor) value;
+	else if (field - 5 < 4)
+		parser->gameData->cards[field - 5] = (CardColor) value;
+}
+
+
+/* Hash of a name of a city, with a seed ('_' and ' ' are the same, see getCityId) */
+static unsigned int hashCityName(const char* name, size_t length, unsigned int seed){
+	unsigned int h = 2166136261u ^ (seed * 0x9E3779B9u);
+	for(size_t i = 0; i < length; i++){
+		h ^= (unsigned char) (name[i] == '_' ? ' ' : name[i]);
+		h *= 16777619u;
 	}
+	/* final mix, so that all the bits count in the modulo */
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	return h ^ (h >> 16);
+}
+
+
+#define MAX_HASH_DISPLACEMENT 65535     /* displacements tried for a bucket, before the hash is given up */
+
+/* Build the minimal perfect hash of the names of the cities (hash and displace): the names are put in nbCities
+ * buckets by a first hash; then, from the largest bucket to the smallest, the bucket gets the first displacement (seed
+ * of a second hash) that sends all its names to free slots. A name is then found with two hashes.
+ * If no displacement fits (very unlikely), the hash is not built, and getCityId scans the names. */
+static void buildCityHash(GameContext* game){
+	int n = game->nbCities;
+	game->cityHash = game->citySlots = NULL;
+	if (n <= 0 || n > 65535)
+		return;
+
+	unsigned short* displacement = (unsigned short*) arenaAlloc(&game->arena, n * sizeof(unsigned short));
+	unsigned short* slots = (unsigned short*) arenaAlloc(&game->arena, n * sizeof(unsigned short));
+	int* bucket = (int*) arenaAlloc(&game->arena, n * sizeof(int));    /* bucket of each city (only used here) */
+	int* size = (int*) arenaAlloc(&game->arena, n * sizeof(int));      /* number of cities of each bucket */
+	if (!displacement || !slots || !bucket || !size)
+		return;
+
+	int largest = 0;
+	for(int b = 0; b < n; b++){
+		displacement[b] = 0;
+		slots[b] = 0xFFFF;          /* free */
+		size[b] = 0;
+	}
+	for(int i = 0; i < n; i++){
+		size_t length;
+		const char* name = getCityNameView(game, i, &length);
+		bucket[i] = hashCityName(name, length, 0) % n;
+		if (++size[bucket[i]] > largest)
+			largest = size[bucket[i]];
+	}
+
+	for(int s = largest; s > 0; s--)
+		for(int b = 0; b < n; b++){
+			if (size[b] != s)
+				continue;
+			unsigned int d;
+			for(d = 1; d <= MAX_HASH_DISPLACEMENT; d++){
+				/* try to place the cities of the bucket (undone if one of them falls on a taken slot) */
+				int placed = 0, i;
+				for(i = 0; i < n; i++){
+					if (bucket[i] != b)
+						continue;
+					size_t length;
+					const char* name = getCityNameView(game, i, &length);
+					unsigned int slot = hashCityName(name, length, d) % n;
+					if (slots[slot] != 0xFFFF)
+						break;
+					slots[slot] = i;
+					placed++;
+				}
+				if (i == n)
+					break;
+				for(int k = 0; k < n && placed > 0; k++)
+					if (slots[k] != 0xFFFF && bucket[slots[k]] == b){
+						slots[k] = 0xFFFF;
+						placed--;
+					}
+			}
+			if (d > MAX_HASH_DISPLACEMENT)
+				return;
+			displacement[b] = d;
+		}
+
+	game->cityHash = displacement;
+	game->citySlots = slots;
+}
+
+
+/* Prepare the parsing of the data of the game (answer of GET_GAME_DATA)
+ * The sizes (parseGameSizes) should be known. The data is then given by chunks, as they are received (feedGameData),
+ * and the parsing is ended by endGameData */
+void initGameDataParser(GameDataParser* parser, GameContext* game, GameData* gameData){
+	parser->game = game;
+	parser->gameData = gameData;
+	parser->field = 0;
+	parser->value = 0;
+	parser->inToken = false;
+	parser->negative = false;
+	parser->poolSize = parser->poolLen = 0;
+	parser->error = ALL_GOOD;
+
+	/* the names are stored one after the other in a single pool (indexed by endGameData) */
+	game->cityOffsets = NULL;
+	gameData->trackData = (int*) arenaAlloc(&game->arena, sizeof(int) * gameData->nbTracks * 5);
+	if (!gameData->trackData || !growNamePool(parser, 16 * game->nbCities + 1))
+		parser->error = MEMORY_ALLOCATION_ERROR;
+}
+
+
+/* Parse a chunk of the data of the game (the tokens can be cut between two chunks) */
+void feedGameData(GameDataParser* parser, const char* chunk, size_t n){
+	int nbCities = parser->game->nbCities;
+	const char* end = chunk + n;
+
+	if (parser->error != ALL_GOOD)
+		return;
+	for(; chunk < end; chunk++) {
+		char c = *chunk;
+		if (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\0') {
+			if (parser->inToken)
+				endToken(parser);
+			continue;
+		}
+		if (parser->field < nbCities) {
+			/* a character of a name ('_' replaced by a space), with room for the final '\0' */
+			if (!growNamePool(parser, 2)) {
+				parser->error = MEMORY_ALLOCATION_ERROR;
+				return;
+			}
+			parser->game->cityPool[parser->poolLen++] = (c == '_') ? ' ' : c;
+		}
+		else if (c >= '0' && c <= '9')
+			parser->value = 10 * parser->value + (c - '0');
+		else if (c == '-' && !parser->inToken)
+			parser->negative = true;
+		else {
+			parser->error = SERVER_ERROR;
+			return;
+		}
+		parser->inToken = true;
+	}
+}
+
+
+/* End the parsing of the data of the game: the last token is stored, and the names are indexed
+ * Returns the error code (SERVER_ERROR if the data is invalid or incomplete) */
+ResultCode endGameData(GameDataParser* parser){
+	GameContext* game = parser->game;
+
+	if (parser->error != ALL_GOOD)
+		return parser->error;
+	if (parser->inToken)
+		endToken(parser);
+	if (parser->field < game->nbCities + 5 * game->nbTracks + 9)
+		return SERVER_ERROR;
+
+	/* the pool is not moved anymore: index the names, and hash them */
+	unsigned int* offsets = (unsigned int*) arenaAlloc(&game->arena, (game->nbCities + 1) * sizeof(unsigned int));
+	if (!offsets)
+		return MEMORY_ALLOCATION_ERROR;
+	const char* name = game->cityPool;
+	for(int i=0; i < game->nbCities; i++){
+		offsets[i] = name - game->cityPool;
+		name += strlen(name) + 1;
+	}
+	offsets[game->nbCities] = name - game->cityPool;
+	game->cityOffsets = offsets;
+	buildCityHash(game);
+	return ALL_GOOD;
+}
+
+
+/* Give a chunk of the data of the game, received by getGameData, to the parser */
+static void readGameData(void* parser, const char* chunk, size_t n){
+	feedGameData((GameDataParser*) parser, chunk, n);
+}
+
+
+/* Parse the data of the game (answer of GET_GAME_DATA), received in a single message */
+ResultCode parseGameData(GameContext* game, const char* data, size_t n, GameData* gameData){
+	GameDataParser parser;
+	initGameDataParser(&parser, game, gameData);
+	feedGameData(&parser, data, n);
+	return endGameData(&parser);
+}
+
+
+/* Parse the opponent's move (answer of GET_MOVE)
+ * `moveStr` is the move, `msg` the associated message; `moveResult->state` should already be set */
+void parseOpponentMove(GameContext* game, const char* moveStr, const char* msg, MoveData* moveData, MoveResult* moveResult){
+	int obj[3];
+	const char* p;
+	unsigned int nbchar;
+	int replay;
+
+	moveResult->replay = false;
+	if (moveResult->state == NORMAL_MOVE) {
+		sscanf(moveStr, "%d%n", (int*) &moveData->action, &nbchar);
+		p = moveStr + nbchar;
+		if (moveData->action == CLAIM_ROUTE) {
+			sscanf(p, "%d %d %d %d", &moveData->claimRoute.from, &moveData->claimRoute.to, (int*)&moveData->claimRoute.color, &moveData->claimRoute.nbLocomotives);
+		}
+		else if (moveData->action == DRAW_CARD) {
+			sscanf(msg, "%d %d %d %d %d %d %d", &replay, (int*) &moveData->drawCard, (int*) game->faceUp, (int*) game->faceUp+1, (int*) game->faceUp+2, (int*) game->faceUp+3, (int*) game->faceUp+4);
+			moveResult->replay =  (bool) replay;
+		}
+		else if (moveData->action == DRAW_BLIND_CARD){
+			sscanf(msg, "%d", &replay);
+			moveResult->replay = (bool) replay;
+			moveResult->card = NONE;		/* we don't know which card the opponent has */
+		}
+		else if (moveData->action == DRAW_OBJECTIVES) {
+			moveResult->replay = true;
+		}
+		else if (moveData->action == CHOOSE_OBJECTIVES) {
+			sscanf(p, "%d %d %d", obj, obj + 1, obj + 2);
+			for(int i=0;i<3;i++)
+			    moveData->chooseObjectives[i] = (bool) obj[i];
+		}
+	}
+
+    // the message of the server (when the move ends the game) is set by the caller, as a view in its storage (see
+    // getMoveView); the opponent's messages (sendMessage) are not given with the moves
+    moveResult->message = NULL;
+    moveResult->opponentMessage = NULL;
+}
+
+
+/* Encode our move as the integers sent with PLAY_MOVE
+ * Returns the number of values (at most 5) */
+int encodeMove(const MoveData* moveData, int* values){
+	values[0] = moveData->action;
+    switch(moveData->action){
+        case CLAIM_ROUTE:
+            values[1] = moveData->claimRoute.from;
+            values[2] = moveData->claimRoute.to;
+            values[3] = moveData->claimRoute.color;
+            values[4] = moveData->claimRoute.nbLocomotives;
+            return 5;
+		case DRAW_CARD:
+			values[1] = moveData->drawCard;
+			return 2;
+        case CHOOSE_OBJECTIVES:
+            values[1] = (int) moveData->chooseObjectives[0];
+            values[2] = (int) moveData->chooseObjectives[1];
+            values[3] = (int) moveData->chooseObjectives[2];
+            return 4;
+    	default:
+    		return 1;
+    }
+}
+
+
+/* Parse the answer of the server to our move (answer of PLAY_MOVE)
+ * `moveResult->state` should already be set */
+void parseMoveAnswer(GameContext* game, const MoveData* moveData, const char* answer, MoveResult* moveResult){
+	const char *str = answer;
+	int nbchar;
+	int replay;
+
+	// the message of the server (when the move ends the game) is set by the caller, as a view in its storage (see
+	// sendMoveView); the text of a normal move is its data, not a message
+	moveResult->message = NULL;
+	moveResult->opponentMessage = NULL;
+	moveResult->replay = false;
+	if (moveResult->state != NORMAL_MOVE)
+		return;
+
+    switch(moveData->action){
+	    case DRAW_BLIND_CARD:
+        	/* get card drawn */
+	        sscanf(answer, "%d %d", &replay, (int*)&moveResult->card);
+	        moveResult->replay = replay;
+		    break;
+
+		case DRAW_CARD:
+        	sscanf(answer, "%d %d %d %d %d %d", &replay, (int*)game->faceUp, (int*)game->faceUp+1, (int*)game->faceUp+2, (int*)game->faceUp+3, (int*)game->faceUp+4);
+        	moveResult->replay = replay;
+		    break;
+
+		case DRAW_OBJECTIVES: {
+                Objective *p = moveResult->objectives;
+                for (int i = 0; i < 3; i++, p++) {
+                    sscanf(str, "%d %d %d%n", &p->from, &p->to, &p->score, &nbchar);
+                    str += nbchar;
+                }
+            	moveResult->replay = true;
+            }
+            break;
+
+    	default:
+    		break;
+    }
 }
 
 
@@ -35,13 +385,18 @@ void strCpyReplace(char* dest, const char* src)
  * This is a blocking function, it will wait until the connection is established, it may take some time.
  *
  * Parameters:
- * - address: (string) address of the server
+ * - game: (GameContext*) context of the game, allocated by the user (filled by the function)
+ * - address: (string) address of the server ("unix:PATH" for a Unix socket, "inproc:NAME" for a server in the program)
  * - port: (int) port number used for the connection
  * - name: (string) your bot's name
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode connectToCGS(const char* address, unsigned int port, const char* name){
-    connectToCGSServer(__FUNCTION__, address, port, name);
+ResultCode connectToCGS(GameContext* game, const char* address, unsigned int port, const char* name){
+    game->cityOffsets = NULL;
+    game->cityPool = NULL;
+    initArena(&game->arena);
+    game->nbCities = game->nbTracks = 0;
+    connectToCGSServer(&game->cnx, __FUNCTION__, address, port, name);
     return ALL_GOOD;
 }
 
@@ -51,9 +406,11 @@ ResultCode connectToCGS(const char* address, unsigned int port, const char* name
  * After connecting, you need to send game settings to the server to start a game.
  * You need to provide a string for the game setting and a GameData struct to store the game data returned by the server.
   *
- * The fields `gameName` and `trackData` (of GameData) are allocated by the function, so they need to be freed by the user
+ * The fields `gameName` and `trackData` (of GameData) are allocated in the arena of the game (game->arena, see
+ * arena.h): they must not be freed, and are valid until the next game on this context or quitGame
  *
  * Parameters:
+ * - game: (GameContext*) context of the game
 * - gameType: string (max 200 characters) type of the game we want to play (empty string for regular game)
  *             "TRAINING xxxx" to play with the bot xxxx
  *             "TOURNAMENT xxxx" to join the tournament xxxx
@@ -71,57 +428,20 @@ ResultCode connectToCGS(const char* address, unsigned int port, const char* name
  * - gameData: (GameData*) store the game data
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode sendGameSettings(const char* gameSettings, GameData* gameData){
-    char data[4096];
-    int nbchar;
-	char *p, **name;
-	char city[20];
+ResultCode sendGameSettings(GameContext* game, const char* gameSettings, GameData* gameData){
+    char data[128];
+    GameDataParser parser;
 
     /* wait for a game  and parse the data*/
 	char gameName[50];
-	waitForGame(__FUNCTION__, gameSettings, gameName, data);
-	sscanf(data, "%d %d", &nbC, &nbTr);
-	gameData->nbTracks = nbTr;
-	gameData->nbCities = nbC;
-	cityNames = (char**) malloc(nbC*sizeof(char*));
-	gameData->gameName = (char*)malloc((strlen(gameName)+1)*sizeof(char));
-	strcpy(gameData->gameName, gameName);
-	/* get the seed from the name */
-	char seedstr[7];
-	strncpy(seedstr, gameName, 6);
-	seedstr[6] = '\0';
-	sscanf(seedstr, "%x", &gameData->gameSeed);
-
-	/* wait for the game data */
-	gameData->starter = getGameData( __FUNCTION__, data, 4096);
-
-	/* copy the cities' names */
-	p = data;
-	name = cityNames;
-	for(int i=0; i < nbC; i++){
-		sscanf(p, "%s%n", city, &nbchar);
-		p += nbchar;
-		*name = (char*) malloc(strlen(city)+1);
-		strCpyReplace(*(name++), city);
-	}
-
-	/* copy the data in the tracks array */
-	gameData->trackData = (int*) malloc(sizeof(int) * gameData->nbTracks * 5);
-	int* tracks = gameData->trackData;
-	if (!gameData->trackData) return MEMORY_ALLOCATION_ERROR;
-	for(int i=0; i < nbTr; i++){
-		sscanf(p, "%d %d %d %d %d %n", tracks, tracks+1, tracks+2, tracks+3, tracks+4, &nbchar);
-		tracks += 5;
-		p += nbchar;
-	}
+	waitForGame(&game->cnx, __FUNCTION__, gameSettings, gameName, data);
+	parseGameSizes(game, gameName, data, gameData);
 
-	/* get the 5 face up cards, but ignore them */
-	sscanf(p, "%d %d %d %d %d %n", (int*)faceUp, (int*)faceUp+1, (int*)faceUp+2, (int*)faceUp+3, (int*)faceUp+4, &nbchar);
-	p += nbchar;
-	/* get the 4 initial cards */
-	sscanf(p, "%d %d %d %d", (int*)gameData->cards, (int*)gameData->cards+1, (int*)gameData->cards+2, (int*)gameData->cards+3);
+	/* wait for the game data, parsed as it is received */
+	initGameDataParser(&parser, game, gameData);
+	gameData->starter = getGameData(&game->cnx, __FUNCTION__, readGameData, &parser);
 
-	return ALL_GOOD;
+	return endGameData(&parser);
 }
 
 
@@ -132,59 +452,22 @@ ResultCode sendGameSettings(const char* gameSettings, GameData* gameData){
  * You need to provide an empty MoveData struct and an empty MoveResult struct to store the move data returned by the server.
  * MoveData struct store the move your opponent did and MoveResult struct store the result of the move.
  *
- * The fields `opponentMessage` and `message` (of moveResult) are allocated by the function, so they need to be freed by the user
+ * The fields `opponentMessage` and `message` (of moveResult) are set to NULL: nothing is allocated, and nothing must be
+ * freed (the message of the server is only kept by getMoveView and sendMoveView, as a view in a MoveScratch)
  *
  * Parameters:
+ * - game: (GameContext*) context of the game
  * - moveData: (GameSettings*) data defining the opponent's move
  * - moreResult: (MoveResult*) data returned after the move
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode getMove(MoveData* moveData, MoveResult* moveResult){
-	char moveStr[MAX_GET_MOVE];
-	char msg[MAX_MESSAGE];
-	int obj[3];
-	char* p;
-	unsigned int nbchar;
-	int replay;
-
-
-	/* get the move */
-	moveResult->state = getCGSMove(__FUNCTION__, moveStr, msg);
-	moveResult->replay = false;
-
-	/* extract result */
-	if (moveResult->state == NORMAL_MOVE) {
-		sscanf(moveStr, "%d%n", (int*) &moveData->action, &nbchar);
-		p = moveStr + nbchar;
-		if (moveData->action == CLAIM_ROUTE) {
-			sscanf(p, "%d %d %d %d", &moveData->claimRoute.from, &moveData->claimRoute.to, (int*)&moveData->claimRoute.color, &moveData->claimRoute.nbLocomotives);
-		}
-		else if (moveData->action == DRAW_CARD) {
-			sscanf(msg, "%d %d %d %d %d %d %d", &replay, (int*) &moveData->drawCard, (int*) faceUp, (int*) faceUp+1, (int*) faceUp+2, (int*) faceUp+3, (int*) faceUp+4);
-			moveResult->replay =  (bool) replay;
-		}
-		else if (moveData->action == DRAW_BLIND_CARD){
-			sscanf(msg, "%d", &replay);
-			moveResult->replay = (bool) replay;
-			moveResult->card = NONE;		/* we don't know which card the opponent has */
-		}
-		else if (moveData->action == DRAW_OBJECTIVES) {
-			moveResult->replay = true;
-		}
-		else if (moveData->action == CHOOSE_OBJECTIVES) {
-			sscanf(p, "%d %d %d", obj, obj + 1, obj + 2);
-			for(int i=0;i<3;i++)
-			    moveData->chooseObjectives[i] = (bool) obj[i];
-		}
-	}
-
-    //TODO: get the messages
-    moveResult->message = NULL;
-    moveResult->opponentMessage = NULL;
-
-	return ALL_GOOD;
-
+ResultCode getMove(GameContext* game, MoveData* moveData, MoveResult* moveResult){
+	MoveScratch scratch;
+	ResultCode ret = getMoveView(game, &scratch, moveData, moveResult);
 
+	/* the messages are not kept (they would be views inside the scratch) */
+	moveResult->message = NULL;
+	return ret;
 }
 
 
@@ -195,74 +478,79 @@ ResultCode getMove(MoveData* moveData, MoveResult* moveResult){
  * You need to provide a MoveData struct containing your move and an empty MoveResult struct to store the result of the
  * move returned by the server.
  *
- * The fields `opponentMessage` and `message` (of moveResult) are allocated by the function, so they need to be freed by the user
+ * The fields `opponentMessage` and `message` (of moveResult) are set to NULL: nothing is allocated, and nothing must be
+ * freed (the message of the server is only kept by getMoveView and sendMoveView, as a view in a MoveScratch)
  *
  * Parameters:
+ * - game: (GameContext*) context of the game
  * - moveData: (GameSettings*) data defining our move
  * - moreResult: (MoveResult*) data returned after the move
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode sendMove(const MoveData *moveData, MoveResult* moveResult){
-    char msg[256];
-	char answer[MAX_MESSAGE], *str = answer;
-	int nbchar;
-	int replay;
+ResultCode sendMove(GameContext* game, const MoveData *moveData, MoveResult* moveResult){
+	MoveScratch scratch;
+	ResultCode ret = sendMoveView(game, &scratch, moveData, moveResult);
 
-	// TODO: manage messages
+	/* the messages are not kept (they would be views inside the scratch) */
 	moveResult->message = NULL;
-	moveResult->opponentMessage = NULL;
-	moveResult->replay = false;
-    // send the appropriate message
-    switch(moveData->action){
+	return ret;
+}
 
-        case CLAIM_ROUTE:
-            sprintf(msg, "1 %d %d %d %d", moveData->claimRoute.from, moveData->claimRoute.to, moveData->claimRoute.color, moveData->claimRoute.nbLocomotives);
-	        moveResult->state = sendCGSMove(__FUNCTION__, msg, answer);
-	        break;
 
-	    case DRAW_BLIND_CARD:
-	        moveResult->state = sendCGSMove(__FUNCTION__, "2", answer);
-        	/* get card drawn */
-	        if (moveResult->state == NORMAL_MOVE) {
-		        sscanf(answer, "%d %d", &replay, (int*)&moveResult->card);
-	        	moveResult->replay = replay;
-	        }
-		    break;
 
-		case DRAW_CARD:
-			sprintf(msg, "3 %d", moveData->drawCard);
-	        moveResult->state = sendCGSMove(__FUNCTION__, msg, answer);
-        	if (moveResult->state == NORMAL_MOVE) {
-        		sscanf(answer, "%d %d %d %d %d %d", &replay, (int*)faceUp, (int*)faceUp+1, (int*)faceUp+2, (int*)faceUp+3, (int*)faceUp+4);
-        		moveResult->replay = replay;
-        	}
-		    break;
+/* -------------------------------------
+ * Get the move of the opponent, without any allocation (see getMove)
+ * The answer of the server is stored in `scratch`, and the field `message` of moveResult (the message of the server,
+ * when the move is not a NORMAL_MOVE, NULL otherwise) is a view inside it: it must not be freed, and is valid until
+ * the next use of `scratch`. `opponentMessage` is always NULL.
+ *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ * - scratch: (MoveScratch*) storage of the answer (allocated by the user, reused for each move)
+ * - moveData: (MoveData*) data defining the opponent's move
+ * - moveResult: (MoveResult*) data returned after the move
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode getMoveView(GameContext* game, MoveScratch* scratch, MoveData* moveData, MoveResult* moveResult){
+	/* get the move */
+	moveResult->state = getCGSMove(&game->cnx, __FUNCTION__, scratch->move, scratch->text);
 
-		case DRAW_OBJECTIVES:
-			moveResult->state = sendCGSMove(__FUNCTION__, "4", answer);
-            if (moveResult->state == NORMAL_MOVE) {
-                Objective *p = moveResult->objectives;
-                for (int i = 0; i < 3; i++, p++) {
-                    sscanf(str, "%d %d %d%n", &p->from, &p->to, &p->score, &nbchar);
-                    str += nbchar;
-                }
-            	moveResult->replay = true;
-            }
-            break;
+	/* extract result */
+	parseOpponentMove(game, scratch->move, scratch->text, moveData, moveResult);
+	if (moveResult->state != NORMAL_MOVE)
+		moveResult->message = scratch->text;
 
-        case CHOOSE_OBJECTIVES:
-            sprintf(msg, "5 %d %d %d", (int) moveData->chooseObjectives[0], (int) moveData->chooseObjectives[1], (int) moveData->chooseObjectives[2]);
-	        moveResult->state = sendCGSMove(__FUNCTION__, msg, answer);
-            break;
+	return ALL_GOOD;
+}
 
-    	default:
-    		sprintf(msg, "%d", moveData->action);
-    		moveResult->state = sendCGSMove(__FUNCTION__, msg, answer);
-    		return PARAM_ERROR;
-    }
 
-    return ALL_GOOD;
 
+/* -------------------------------------
+ * Send the move to the server, without any allocation (see sendMove)
+ * The answer of the server is stored in `scratch`, and the field `message` of moveResult (the message of the server,
+ * when the move is not a NORMAL_MOVE, NULL otherwise) is a view inside it: it must not be freed, and is valid until
+ * the next use of `scratch`. `opponentMessage` is always NULL.
+ *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ * - scratch: (MoveScratch*) storage of the answer (allocated by the user, reused for each move)
+ * - moveData: (MoveData*) data defining our move
+ * - moveResult: (MoveResult*) data returned after the move
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode sendMoveView(GameContext* game, MoveScratch* scratch, const MoveData *moveData, MoveResult* moveResult){
+	int values[5];
+
+    // send the appropriate message
+	int nvalues = encodeMove(moveData, values);
+	moveResult->state = sendCGSMoveValues(&game->cnx, __FUNCTION__, values, nvalues, scratch->text);
+	parseMoveAnswer(game, moveData, scratch->text, moveResult);
+	if (moveResult->state != NORMAL_MOVE)
+		moveResult->message = scratch->text;
+
+	if (moveData->action < CLAIM_ROUTE || moveData->action > CHOOSE_OBJECTIVES)
+		return PARAM_ERROR;
+    return ALL_GOOD;
 }
 
 
@@ -271,12 +559,13 @@ ResultCode sendMove(const MoveData *moveData, MoveResult* moveResult){
  * It returns the 5 face-up cards
  *
  * Parameters:
+ * - game: (GameContext*) context of the game
  * - boardState: (BoardState*) the 5 face-up cards
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode getBoardState(BoardState* boardState){
+ResultCode getBoardState(GameContext* game, BoardState* boardState){
     for(int i=0;i<5;i++)
-        boardState->card[i] = faceUp[i];
+        boardState->card[i] = game->faceUp[i];
     return ALL_GOOD;
 }
 
@@ -285,11 +574,12 @@ ResultCode getBoardState(BoardState* boardState){
  * You need to provide the message as a string. It should be less than 256 characters long.
  *
  * Parameters:
+ * - game: (GameContext*) context of the game
  * - message: (string) the message sent
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode sendMessage(const char* message){
-    sendCGSComment( __FUNCTION__, message);
+ResultCode sendMessage(GameContext* game, const char* message){
+    sendCGSComment(&game->cnx, __FUNCTION__, message);
     return ALL_GOOD;
 }
 
@@ -298,9 +588,12 @@ ResultCode sendMessage(const char* message){
  * This function is used to display the game board during a game.
  * It will print the colored board in the console.
  *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode printBoard(){
-    printCGSGame(__FUNCTION__);
+ResultCode printBoard(GameContext* game){
+    printCGSGame(&game->cnx, __FUNCTION__);
     return ALL_GOOD;
 }
 
@@ -309,28 +602,142 @@ ResultCode printBoard(){
  * This function prints the city name
  *
  * Parameters:
+ * - game: (GameContext*) context of the game
  * - cityId: (int) id of the city to be printed
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode printCity(unsigned int cityId){
-	printf("%s", cityNames[cityId]);
+ResultCode printCity(GameContext* game, unsigned int cityId){
+	size_t length;
+	const char* name = getCityNameView(game, cityId, &length);
+	if (!name)
+		return PARAM_ERROR;
+	logBytes(name, length);
 	return ALL_GOOD;
 }
 
 
+/* -------------------------------------
+ * This function gives the name of a city (to display it with the logger, for example)
+ *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ * - cityId: (int) id of the city
+ *
+ * Returns the name of the city (valid until the end of the game), or NULL if the id is not valid */
+const char* getCityName(const GameContext* game, unsigned int cityId){
+	size_t length;
+	return getCityNameView(game, cityId, &length);
+}
+
+
+/* -------------------------------------
+ * This function gives the name of a city and its length, in constant time (a view inside the pool of names)
+ *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ * - cityId: (int) id of the city
+ * - length: (size_t*) filled with the length of the name
+ *
+ * Returns the name of the city (valid until the end of the game), or NULL if the id is not valid */
+const char* getCityNameView(const GameContext* game, unsigned int cityId, size_t* length){
+	*length = 0;
+	if (!game->cityOffsets || cityId >= (unsigned int) game->nbCities)
+		return NULL;
+	*length = game->cityOffsets[cityId + 1] - game->cityOffsets[cityId] - 1;
+	return game->cityPool + game->cityOffsets[cityId];
+}
+
+
+/* Compare a name given to getCityId with the name of a city ('_' matches a space) */
+static bool sameCityName(const GameContext* game, unsigned int cityId, const char* name, size_t length){
+	size_t n;
+	const char* cityName = getCityNameView(game, cityId, &n);
+	if (n != length)
+		return false;
+	for(size_t i = 0; i < n; i++)
+		if ((name[i] == '_' ? ' ' : name[i]) != cityName[i])
+			return false;
+	return true;
+}
+
+
+/* -------------------------------------
+ * This function gives the id of a city from its name (read in a log, a replay or a configuration file, for example)
+ * The names are found in constant time, by a minimal perfect hash built when the map is received. A '_' of the name
+ * matches a space (the server writes the spaces of the names as '_').
+ *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ * - name: (string) name of the city (not necessarily NUL-terminated)
+ * - length: (size_t) length of the name
+ *
+ * Returns the id of the city, or -1 if there is no city of that name */
+int getCityId(const GameContext* game, const char* name, size_t length){
+	int n = game->nbCities;
+	if (!game->cityOffsets)
+		return -1;
+	if (game->cityHash) {
+		unsigned int bucket = hashCityName(name, length, 0) % n;
+		unsigned int city = game->citySlots[hashCityName(name, length, game->cityHash[bucket]) % n];
+		return sameCityName(game, city, name, length) ? (int) city : -1;
+	}
+	for(int i = 0; i < n; i++)
+		if (sameCityName(game, i, name, length))
+			return i;
+	return -1;
+}
+
+
 /* -------------------------------------
  * This function is used to quit the currently running game.
  *
  *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode quitGame(){
+ResultCode quitGame(GameContext* game){
+	/* report the latencies (after the records of the logger) */
+	if (latencyReport) {
+		logFlush();
+		latPrint(&game->cnx.latency, latencyReport, game->cnx.playerName);
+	}
+
 	/* free the data */
-	char** p = cityNames;
-	for(int i=0; i<nbC; i++)
-		free(*p++);
-	free(cityNames);
+	freeArena(&game->arena);
+	game->cityOffsets = NULL;
+	game->cityPool = NULL;
 	/* close the connection */
-	closeCGSConnection(__FUNCTION__);
+	closeCGSConnection(&game->cnx, __FUNCTION__);
 
 	return ALL_GOOD;
-}
\ No newline at end of file
+}
+
+/* -------------------------------------
+ * Get the latencies of the commands sent during the game (a snapshot of the histograms, see latency.h)
+ * It can be called during the game, or after quitGame. The snapshots of several games can be gathered with `latMerge`.
+ *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ * - stats: (LatencyStats*) filled with the histograms
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode getLatencies(const GameContext* game, LatencyStats* stats){
+	if (!stats)
+		return PARAM_ERROR;
+	*stats = game->cnx.latency;
+	return ALL_GOOD;
+}
+
+
+/* -------------------------------------
+ * Print the latencies (count, mean, p50, p99 and max of each command) of every game when it is quitted
+ *
+ * Parameters:
+ * - f: (FILE*) where the latencies are printed (NULL to stop)
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode reportLatencies(FILE* f){
+	latencyReport = f;
+	return ALL_GOOD;
+}
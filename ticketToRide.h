@@ -33,14 +33,16 @@ Copyright 2025 T. Hilaire, V. Le Lièvre
 /*
 
     1. How to use:
+        Everything about a game is stored in a GameContext, that you allocate (global variable, or malloc) and give to
+        every function. So one process can play several games at the same time (one GameContext per game).
+
         To connect to the server and play a game you have to call (in order):
-            - ResultCode connectToCGS(const char *address, unsigned int port)
-            - ResultCode sendName(const char *name)
-            - ResultCode sendGameSettings(GameSettings gameSettings, GameData* gameData)
+            - ResultCode connectToCGS(GameContext* game, const char *address, unsigned int port, const char* name)
+            - ResultCode sendGameSettings(GameContext* game, const char* gameSettings, GameData* gameData)
 
         You will then be connected to a game and will be able to play by calling:
-            - ResultCode getMove(MoveData* moveData, MoveResult* moveResult)
-            - ResultCode sendMove(const MoveData *moveData, MoveResult* moveResult)
+            - ResultCode getMove(GameContext* game, MoveData* moveData, MoveResult* moveResult)
+            - ResultCode sendMove(GameContext* game, const MoveData *moveData, MoveResult* moveResult)
 
     2. Constants:
         To communicate actions to the server you can use CONSTANTS variables, defined
@@ -72,8 +74,12 @@ Copyright 2025 T. Hilaire, V. Le Lièvre
 
         Variables that need to be freed are detailed in the comment of each function
 
-        NOTE: you are likely to create multiple instance of MoveData, don't forget
-        to free opponentMessage, or you will likely encounter Segmentation fault error.
+        NOTE: the messages of a MoveResult (opponentMessage, message) are never allocated: they are NULL, or views
+        inside a MoveScratch, and must not be freed.
+
+        To avoid any allocation during the game, getMoveView and sendMoveView can be used instead of getMove and
+        sendMove: the answers of the server are stored in a MoveScratch given by the caller (one per game, reused for
+        every move), and the messages of the MoveResult are views inside it (nothing to free).
 
 */
 
@@ -81,6 +87,7 @@ Copyright 2025 T. Hilaire, V. Le Lièvre
 #ifndef __TICKET_TO_RIDE_H__
 #define __TICKET_TO_RIDE_H__
 #include "clientAPI.h"
+#include "arena.h"
 #include <stdbool.h>
 
 
@@ -162,6 +169,14 @@ typedef struct MoveResult_ {
 } MoveResult;
 
 
+/* storage of the answers of the server to a move, given by the user to getMoveView and sendMoveView
+ * It is reused for every move of a game: the views given in the MoveResult are valid until its next use */
+typedef struct {
+    char move[MAX_GET_MOVE];        // the move of the opponent
+    char text[MAX_MESSAGE];         // the message (or the data) associated with the move
+} MoveScratch;
+
+
 /* data returned when we call getBoardState
  * here the five face-up cards
  */
@@ -190,6 +205,23 @@ typedef struct {
 } GameData;
 
 
+/* context of a game
+ * everything the API has to remember about a game (the connection, the map, etc.), so the user do not have to pass
+ * them once again, and so that several games can be played at the same time
+ * It is allocated by the user, and filled by `connectToCGS` and `sendGameSettings` */
+typedef struct {
+    Connection cnx;         /* connection to the server */
+    int nbTracks;           /* number of tracks */
+    int nbCities;           /* number of cities */
+    char* cityPool;         /* storage of the city names (one after the other, NUL-terminated) */
+    unsigned int* cityOffsets;      /* offset of each name in cityPool, and the end of the pool (nbCities + 1) */
+    unsigned short* cityHash;       /* minimal perfect hash of the names (see getCityId): displacement of each bucket */
+    unsigned short* citySlots;      /* city of each slot of the hash (both NULL if the hash could not be built) */
+    Arena arena;            /* data of the game (names, track data), reset by the next game and freed by quitGame */
+    CardColor faceUp[5];    /* store the face up cards returned by the get/sendMove */
+} GameContext;
+
+
 
 /*
 
@@ -204,22 +236,28 @@ typedef struct {
  * This is a blocking function, it will wait until the connection is established, it may take some time.
  *
  * Parameters:
- * - address: (string) address of the server
+ * - game: (GameContext*) context of the game, allocated by the user (filled by the function)
+ * - address: (string) address of the server ("unix:PATH" for a Unix socket, "inproc:NAME" for a server in the program,
+ *            "replay:PATH" to play back a session recorded with `recordSessions`, see recorder.h)
  * - port: (int) port number used for the connection
  * - name: (string) your bot's name
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode connectToCGS(const char* address, unsigned int port, const char* name);
+ResultCode connectToCGS(GameContext* game, const char* address, unsigned int port, const char* name);
 
 
 /* -------------------------------------
  * Send the game settings to the server in order to start a game
  * After connecting, you need to send game settings to the server to start a game.
  * You need to provide a string for the game setting and a GameData struct to store the game data returned by the server.
+ * When a game is over (a move has returned a state other than NORMAL_MOVE), this function can be called again to
+ * play another game on the same connection (session mode: no new connection and no CLIENT_NAME, just WAIT_GAME).
   *
- * The fields `gameName` and `trackData` (of GameData) are allocated by the function, so they need to be freed by the user
+ * The fields `gameName` and `trackData` (of GameData) are allocated in the arena of the game (game->arena, see
+ * arena.h): they must not be freed, and are valid until the next game on this context or quitGame
  *
  * Parameters:
+ * - game: (GameContext*) context of the game
 * - gameType: string (max 200 characters) type of the game we want to play (empty string for regular game)
  *             "TRAINING xxxx" to play with the bot xxxx
  *             "TOURNAMENT xxxx" to join the tournament xxxx
@@ -237,7 +275,7 @@ ResultCode connectToCGS(const char* address, unsigned int port, const char* name
  * - gameData: (GameData*) store the game data
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode sendGameSettings(const char* gameSettings, GameData* gameData);
+ResultCode sendGameSettings(GameContext* game, const char* gameSettings, GameData* gameData);
 
 
 /* -------------------------------------
@@ -246,14 +284,16 @@ ResultCode sendGameSettings(const char* gameSettings, GameData* gameData);
  * You need to provide an empty MoveData struct and an empty MoveResult struct to store the move data returned by the server.
  * MoveData struct store the move your opponent did and MoveResult struct store the result of the move.
  *
- * The fields `opponentMessage` and `message` (of moveResult) are allocated by the function, so they need to be freed by the user
+ * The fields `opponentMessage` and `message` (of moveResult) are set to NULL: nothing is allocated, and nothing must be
+ * freed (the message of the server is only kept by getMoveView and sendMoveView, as a view in a MoveScratch)
  *
  * Parameters:
+ * - game: (GameContext*) context of the game
  * - moveData: (GameSettings*) data defining the opponent's move
  * - moreResult: (MoveResult*) data returned after the move
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode getMove(MoveData* moveData, MoveResult* moveResult);
+ResultCode getMove(GameContext* game, MoveData* moveData, MoveResult* moveResult);
 
 
 /* -------------------------------------
@@ -262,14 +302,48 @@ ResultCode getMove(MoveData* moveData, MoveResult* moveResult);
  * You need to provide a MoveData struct containing your move and an empty MoveResult struct to store the result of the
  * move returned by the server.
  *
- * The fields `opponentMessage` and `message` (of moveResult) are allocated by the function, so they need to be freed by the user
+ * The fields `opponentMessage` and `message` (of moveResult) are set to NULL: nothing is allocated, and nothing must be
+ * freed (the message of the server is only kept by getMoveView and sendMoveView, as a view in a MoveScratch)
  *
  * Parameters:
+ * - game: (GameContext*) context of the game
  * - moveData: (GameSettings*) data defining our move
  * - moreResult: (MoveResult*) data returned after the move
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode sendMove(const MoveData *moveData, MoveResult* moveResult);
+ResultCode sendMove(GameContext* game, const MoveData *moveData, MoveResult* moveResult);
+
+
+/* -------------------------------------
+ * Get the move of the opponent, without any allocation (see getMove)
+ * The answer of the server is stored in `scratch`, and the field `message` of moveResult (the message of the server,
+ * when the move is not a NORMAL_MOVE, NULL otherwise) is a view inside it: it must not be freed, and is valid until
+ * the next use of `scratch`. `opponentMessage` is always NULL.
+ *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ * - scratch: (MoveScratch*) storage of the answer (allocated by the user, reused for each move)
+ * - moveData: (MoveData*) data defining the opponent's move
+ * - moveResult: (MoveResult*) data returned after the move
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode getMoveView(GameContext* game, MoveScratch* scratch, MoveData* moveData, MoveResult* moveResult);
+
+
+/* -------------------------------------
+ * Send the move to the server, without any allocation (see sendMove)
+ * The answer of the server is stored in `scratch`, and the field `message` of moveResult (the message of the server,
+ * when the move is not a NORMAL_MOVE, NULL otherwise) is a view inside it: it must not be freed, and is valid until
+ * the next use of `scratch`. `opponentMessage` is always NULL.
+ *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ * - scratch: (MoveScratch*) storage of the answer (allocated by the user, reused for each move)
+ * - moveData: (MoveData*) data defining our move
+ * - moveResult: (MoveResult*) data returned after the move
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode sendMoveView(GameContext* game, MoveScratch* scratch, const MoveData *moveData, MoveResult* moveResult);
 
 
 /* -------------------------------------
@@ -277,10 +351,11 @@ ResultCode sendMove(const MoveData *moveData, MoveResult* moveResult);
  * It returns the 5 face-up cards
  *
  * Parameters:
+ * - game: (GameContext*) context of the game
  * - boardState: (BoardState*) the 5 face-up cards
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode getBoardState(BoardState* boardState);
+ResultCode getBoardState(GameContext* game, BoardState* boardState);
 
 
 /* -------------------------------------
@@ -288,36 +363,129 @@ ResultCode getBoardState(BoardState* boardState);
  * You need to provide the message as a string. It should be less than 256 characters long.
  *
  * Parameters:
+ * - game: (GameContext*) context of the game
  * - message: (string) the message sent
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode sendMessage(const char* message);
+ResultCode sendMessage(GameContext* game, const char* message);
 
 
 /* -------------------------------------
  * This function is used to display the game board during a game.
  * It will print the colored board in the console.
  *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode printBoard();
+ResultCode printBoard(GameContext* game);
 
 
 /* -------------------------------------
  * This function prints the city name
  *
  * Parameters:
+ * - game: (GameContext*) context of the game
  * - cityId: (int) id of the city to be printed
  *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode printCity(unsigned int cityId);
+ResultCode printCity(GameContext* game, unsigned int cityId);
+
+
+/* -------------------------------------
+ * This function gives the name of a city (to display it with the logger, for example)
+ *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ * - cityId: (int) id of the city
+ *
+ * Returns the name of the city (valid until the end of the game), or NULL if the id is not valid */
+const char* getCityName(const GameContext* game, unsigned int cityId);
+
+
+/* -------------------------------------
+ * This function gives the name of a city and its length, in constant time (a view inside the pool of names)
+ *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ * - cityId: (int) id of the city
+ * - length: (size_t*) filled with the length of the name
+ *
+ * Returns the name of the city (valid until the end of the game), or NULL if the id is not valid */
+const char* getCityNameView(const GameContext* game, unsigned int cityId, size_t* length);
+
+
+/* -------------------------------------
+ * This function gives the id of a city from its name (read in a log, a replay or a configuration file, for example)
+ * The names are found in constant time, by a minimal perfect hash built when the map is received. A '_' of the name
+ * matches a space (the server writes the spaces of the names as '_').
+ *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ * - name: (string) name of the city (not necessarily NUL-terminated)
+ * - length: (size_t) length of the name
+ *
+ * Returns the id of the city, or -1 if there is no city of that name */
+int getCityId(const GameContext* game, const char* name, size_t length);
 
 
 /* -------------------------------------
  * This function is used to quit the currently running game.
  *
  *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode quitGame(GameContext* game);
+
+
+/* -------------------------------------
+ * Get the latencies of the commands sent during the game (a snapshot of the histograms of the connection)
+ * The latency of a command is the time between its sending and the reception of its whole answer (see latency.h).
+ * It can be called during the game, or after quitGame; the snapshots of several games can be gathered with `latMerge`.
+ *
+ * Parameters:
+ * - game: (GameContext*) context of the game
+ * - stats: (LatencyStats*) filled with the histograms
+ *
  * Returns the error code (ALL_GOOD if everything is ok) */
-ResultCode quitGame();
+ResultCode getLatencies(const GameContext* game, LatencyStats* stats);
+
+
+/* -------------------------------------
+ * Print the latencies (count, mean, p50, p99 and max of each command) of every game when it is quitted (quitGame)
+ *
+ * Parameters:
+ * - f: (FILE*) where the latencies are printed (NULL to stop)
+ *
+ * Returns the error code (ALL_GOOD if everything is ok) */
+ResultCode reportLatencies(FILE* f);
+
+
+/* incremental parser of the data of the game (answer of GET_GAME_DATA), fed by chunks as they are received (intern) */
+typedef struct {
+    GameContext* game;
+    GameData* gameData;
+    int field;              /* index of the token being read (cities' names, then tracks, face up cards and initial cards) */
+    int value;              /* value of the number being read */
+    bool negative;
+    bool inToken;           /* true if a token has begun (it can be cut between two chunks) */
+    size_t poolSize;        /* size of the pool of names (game->cityPool) */
+    size_t poolLen;         /* bytes used in the pool */
+    ResultCode error;       /* ALL_GOOD, or the first error met */
+} GameDataParser;
+
+
+/* intern functions (decode the answers of the server, encode the moves), shared with the asynchronous client */
+void parseGameSizes(GameContext* game, const char* gameName, const char* sizes, GameData* gameData);
+void initGameDataParser(GameDataParser* parser, GameContext* game, GameData* gameData);
+void feedGameData(GameDataParser* parser, const char* chunk, size_t n);
+ResultCode endGameData(GameDataParser* parser);
+ResultCode parseGameData(GameContext* game, const char* data, size_t n, GameData* gameData);
+void parseOpponentMove(GameContext* game, const char* moveStr, const char* msg, MoveData* moveData, MoveResult* moveResult);
+int encodeMove(const MoveData* moveData, int* values);
+void parseMoveAnswer(GameContext* game, const MoveData* moveData, const char* answer, MoveResult* moveResult);
 
 
 #endif
@@ -0,0 +1,158 @@
+/*
+Transports used by the client API to exchange the bytes with the server
+
+File: transport.c
+	Selection of the transport, and the plain socket transport (TCP or Unix domain socket) (see transport.h)
+*/
+
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "clientAPI.h"
+
+#define h_addr h_addr_list[0] /* for backward compatibility */
+
+
+/* transports that can be selected by their name (for the sockets) */
+static const Transport* transports[] = { &socketTransport, &uringTransport };
+
+/* transport used by the sockets opened from now on */
+static const Transport* current = &socketTransport;
+
+
+/* Select (by its name) the transport used by the next sockets
+ * Returns false if there is no transport with this name */
+bool selectTransport(const char* name) {
+	for (size_t i = 0; i < sizeof(transports) / sizeof(transports[0]); i++)
+		if (strcmp(transports[i]->name, name) == 0) {
+			current = transports[i];
+			return true;
+		}
+	return false;
+}
+
+
+/* Returns the transport to use to reach the server `serverName`
+ * (the non-blocking connections are driven by their caller, with the socket) */
+const Transport* transportFor(const char* serverName, bool nonBlocking) {
+	if (strncmp(serverName, "inproc:", 7) == 0)
+		return &inprocTransport;
+	if (strncmp(serverName, "replay:", 7) == 0 || strncmp(serverName, "replay-paced:", 13) == 0)
+		return &replayTransport;
+	return nonBlocking ? &socketTransport : current;
+}
+
+
+/* Write all the pieces (`writev` may write only a part of them)
+ * Returns the number of bytes written, or -1 on error */
+ssize_t writeAll(int fd, const struct iovec* iov, int niov) {
+	ssize_t total = 0;
+	size_t skip = 0;        /* bytes of iov[0] already written */
+	while (niov > 0) {
+		struct iovec first = { (char*) iov->iov_base + skip, iov->iov_len - skip };
+		struct iovec pieces[8];
+		int n = niov < 8 ? niov : 8;
+		pieces[0] = first;
+		memcpy(pieces + 1, iov + 1, (n - 1) * sizeof(struct iovec));
+		ssize_t r = writev(fd, pieces, n);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		total += r;
+		/* skip the pieces completely written */
+		r += skip;
+		while (niov > 0 && (size_t) r >= iov->iov_len) {
+			r -= iov->iov_len;
+			iov++;
+			niov--;
+		}
+		skip = r;
+	}
+	return total;
+}
+
+
+
+/* -------------------------------------
+ * Open a socket connected to the server (TCP, or Unix domain socket for the "unix:PATH" addresses)
+ * Quit the program if the connection to the server cannot be established
+ *
+ * Parameters:
+ * - cnx: connection to the server
+ * - fct: name of the function that opens the connection (used for the logging)
+ * - serverName: (string) address of the server
+ * - port: (int) port number used for the connection (TCP only)
+ * - nonBlocking: true to have a non-blocking socket (the connection is then in progress when the function returns)
+ */
+void socketConnect(Connection* cnx, const char* fct, const char* serverName, unsigned int port, bool nonBlocking) {
+	struct sockaddr_storage addr;
+	socklen_t len;
+
+	bzero((char *) &addr, sizeof(addr));
+	if (strncmp(serverName, "unix:", 5) == 0) {
+		/* Unix domain socket */
+		struct sockaddr_un* un = (struct sockaddr_un*) &addr;
+		if (strlen(serverName + 5) >= sizeof(un->sun_path))
+			dispError(cnx, fct, "The path of the socket is too long (%s)", serverName + 5);
+		un->sun_family = AF_UNIX;
+		strcpy(un->sun_path, serverName + 5);
+		len = sizeof(struct sockaddr_un);
+	}
+	else {
+		/* Get the server */
+		struct hostent *server = gethostbyname(serverName);
+		if (server == NULL)
+			dispError(cnx, fct, "Unable to find the server by its name");
+		struct sockaddr_in* in = (struct sockaddr_in*) &addr;
+		in->sin_family = AF_INET;
+		bcopy(server->h_addr, &in->sin_addr.s_addr, server->h_length);
+		in->sin_port = htons(port);
+		len = sizeof(struct sockaddr_in);
+	}
+	dispDebug(cnx, fct,1, "Open connection with the server %s", serverName);
+
+	/* Create a socket point, connected */
+	cnx->sockfd = socket(addr.ss_family, SOCK_STREAM, 0);
+	if (cnx->sockfd < 0)
+		dispError(cnx, fct, "Impossible to open socket");
+	if (nonBlocking)
+		fcntl(cnx->sockfd, F_SETFL, fcntl(cnx->sockfd, F_GETFL) | O_NONBLOCK);
+
+	/* Now connect to the server */
+	if (connect(cnx->sockfd, (struct sockaddr*) &addr, len) < 0 && !(nonBlocking && errno == EINPROGRESS))
+		dispError(cnx, fct, "Connection to the server '%s' on port %d impossible.", serverName, port);
+}
+
+
+/* Close the socket */
+void socketClose(Connection* cnx) {
+	close(cnx->sockfd);
+	cnx->sockfd = -1;
+}
+
+
+
+/* plain socket transport */
+
+static ssize_t socketRead(Connection* cnx, char* buf, size_t n) {
+	ssize_t r;
+	do
+		r = read(cnx->sockfd, buf, n);
+	while (r < 0 && errno == EINTR);
+	return r;
+}
+
+static ssize_t socketExchange(Connection* cnx, const struct iovec* iov, int niov) {
+	/* the answer is read later, by `read` */
+	return writeAll(cnx->sockfd, iov, niov);
+}
+
+const Transport socketTransport = { "socket", socketConnect, socketRead, socketExchange, socketClose };
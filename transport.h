@@ -0,0 +1,71 @@
+#ifndef __TRANSPORT_H__
+#define __TRANSPORT_H__
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+
+struct Connection_;
+
+
+/* Transport used by a connection to reach the server and exchange the bytes with it
+ * The client API only uses these functions to talk to the server. The transport is chosen when the connection is
+ * opened, from the address of the server:
+ *  - "inproc:NAME": in-process channel, to a server registered with `registerInprocServer` in the same program
+ *  - "unix:PATH": Unix domain socket
+ *  - "replay:PATH" / "replay-paced:PATH": session recorded in the log PATH (see recorder.h), played back as fast as
+ *    possible / at the pace of the server
+ *  - otherwise: TCP (name of the server)
+ * and for the sockets, with `selectTransport`, the way the syscalls are done:
+ *  - "socket": plain `read`/`writev` on the socket (default)
+ *  - "io_uring": io_uring with registered buffers; a command and the first bytes of its answer are exchanged with a
+ *    single `io_uring_enter` (only for the blocking connections; if io_uring is not available, the socket is used)
+ */
+typedef struct {
+    const char* name;
+    /* open the connection (quit the program if it is impossible); a transport may give the connection to another one */
+    void (*connect)(struct Connection_* cnx, const char* fct, const char* serverName, unsigned int port, bool nonBlocking);
+    /* read (blocking) at most `n` bytes; returns the number of bytes read, 0 if the connection is closed, -1 on error */
+    ssize_t (*read)(struct Connection_* cnx, char* buf, size_t n);
+    /* send a whole command, and may already receive (a part of) its answer in the receive ring; returns -1 on error */
+    ssize_t (*exchange)(struct Connection_* cnx, const struct iovec* iov, int niov);
+    /* close the connection, and release what `connect` has allocated */
+    void (*close)(struct Connection_* cnx);
+} Transport;
+
+
+/* Server living in the same program, reached by the "inproc:NAME" addresses
+ * Its functions are called in the thread of the client. Every answer to a command (acknowledgment included) should be
+ * given by `inprocReply` before `command` returns (the client reads nothing else), so a command that has to wait
+ * (WAIT_GAME, GET_MOVE) waits inside `command`.
+ */
+typedef struct InprocServer_ {
+    void* data;                 /* data of the server (free to use) */
+    /* a client is connected; returns the data of its session (given to the other functions) */
+    void* (*connect)(struct InprocServer_* server, struct Connection_* cnx);
+    /* a command is received (NUL-terminated, of size `n`) */
+    void (*command)(void* session, struct Connection_* cnx, const char* cmd, size_t n);
+    /* the client is disconnected */
+    void (*disconnect)(void* session);
+} InprocServer;
+
+
+/* available transports */
+extern const Transport socketTransport;
+extern const Transport uringTransport;
+extern const Transport inprocTransport;
+extern const Transport replayTransport;
+
+
+/* prototypes */
+bool selectTransport(const char* name);
+const Transport* transportFor(const char* serverName, bool nonBlocking);
+ssize_t writeAll(int fd, const struct iovec* iov, int niov);
+void socketConnect(struct Connection_* cnx, const char* fct, const char* serverName, unsigned int port, bool nonBlocking);
+void socketClose(struct Connection_* cnx);
+bool registerInprocServer(const char* name, InprocServer* server);
+void inprocReply(struct Connection_* cnx, const char* msg, size_t n);
+
+
+#endif
@@ -0,0 +1,298 @@
+/*
+Transports used by the client API to exchange the bytes with the server
+
+File: uringTransport.c
+	io_uring transport (see transport.h)
+	The io_uring syscalls are used directly (liburing is not needed).
+
+	Each connection has its own small io_uring. The receive ring and the storage of the encoder are registered, so
+	the reads and the encoded commands use fixed buffers. To send a command, its write is linked to a read of the
+	answer, and both are submitted and waited by a single `io_uring_enter`.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "clientAPI.h"
+
+
+#define URING_ENTRIES 4     /* a command needs at most 2 entries (write + read) */
+
+/* buffers registered for each connection */
+#define BUF_RING 0          /* the receive ring */
+#define BUF_COMMAND 1       /* the storage of the encoder */
+
+/* user data of the requests */
+#define REQ_WRITE 1
+#define REQ_READ 2
+
+
+/* the io_uring of a connection */
+typedef struct {
+    int fd;
+    /* submission queue */
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    struct io_uring_sqe* sqes;
+    /* completion queue */
+    unsigned *cqHead, *cqTail, *cqMask;
+    struct io_uring_cqe* cqes;
+    /* mappings */
+    void* sqMap;
+    size_t sqMapSize;
+    void* cqMap;
+    size_t cqMapSize;
+    size_t sqesSize;
+} URing;
+
+
+/* Release the io_uring (the parts that have been created) */
+static void freeURing(URing* u) {
+	if (u->sqes)
+		munmap(u->sqes, u->sqesSize);
+	if (u->cqMap && u->cqMap != u->sqMap)
+		munmap(u->cqMap, u->cqMapSize);
+	if (u->sqMap)
+		munmap(u->sqMap, u->sqMapSize);
+	if (u->fd >= 0)
+		close(u->fd);
+	free(u);
+}
+
+
+/* Get a free submission entry (there is always one, since the requests are waited before new ones are made) */
+static struct io_uring_sqe* getSqe(URing* u) {
+	unsigned tail = *u->sqTail;
+	unsigned index = tail & *u->sqMask;
+	struct io_uring_sqe* sqe = &u->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	u->sqArray[index] = index;
+	__atomic_store_n(u->sqTail, tail + 1, __ATOMIC_RELEASE);
+	return sqe;
+}
+
+
+/* Submit `n` requests and wait for their completions
+ * The results are given in `res`, indexed by the user data of the requests (REQ_*)
+ * Returns false if io_uring_enter has failed */
+static bool submitAndWait(URing* u, unsigned n, int* res) {
+	unsigned done = 0;
+	unsigned toSubmit = n;
+	while (done < n) {
+		int r = syscall(__NR_io_uring_enter, u->fd, toSubmit, n - done, IORING_ENTER_GETEVENTS, NULL, 0);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		toSubmit -= (unsigned) r < toSubmit ? (unsigned) r : toSubmit;
+		/* reap the completions */
+		unsigned head = *u->cqHead;
+		while (head != __atomic_load_n(u->cqTail, __ATOMIC_ACQUIRE)) {
+			struct io_uring_cqe* cqe = &u->cqes[head & *u->cqMask];
+			res[cqe->user_data] = cqe->res;
+			head++;
+			done++;
+		}
+		__atomic_store_n(u->cqHead, head, __ATOMIC_RELEASE);
+	}
+	return true;
+}
+
+
+/* Fill a submission entry for a read into the receive ring
+ * Returns false if the ring has no room */
+static bool prepRead(Connection* cnx, URing* u) {
+	size_t room;
+	char* p = rbWritePtr(&cnx->ring, &room);
+	if (room == 0)
+		return false;
+	struct io_uring_sqe* sqe = getSqe(u);
+	sqe->opcode = IORING_OP_READ_FIXED;
+	sqe->fd = cnx->sockfd;
+	sqe->addr = (unsigned long) p;
+	sqe->len = room;
+	sqe->buf_index = BUF_RING;
+	sqe->user_data = REQ_READ;
+	return true;
+}
+
+
+/* Create the io_uring of the connection
+ * Returns false if io_uring cannot be used */
+static bool uringInit(Connection* cnx) {
+	struct io_uring_params p;
+	URing* u = calloc(1, sizeof(URing));
+	if (!u)
+		return false;
+	u->fd = -1;
+
+	/* the ring is only used by the thread of the connection, so the completions can be run when we wait for them */
+	memset(&p, 0, sizeof(p));
+	p.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+	u->fd = syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+	if (u->fd < 0) {
+		memset(&p, 0, sizeof(p));
+		u->fd = syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+	}
+	if (u->fd < 0) {
+		freeURing(u);
+		return false;
+	}
+
+	/* map the queues */
+	u->sqMapSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	u->cqMapSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (u->cqMapSize > u->sqMapSize)
+			u->sqMapSize = u->cqMapSize;
+		u->cqMapSize = u->sqMapSize;
+	}
+	u->sqMap = mmap(NULL, u->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+	if (u->sqMap == MAP_FAILED) {
+		u->sqMap = NULL;
+		freeURing(u);
+		return false;
+	}
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		u->cqMap = u->sqMap;
+	else {
+		u->cqMap = mmap(NULL, u->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+		if (u->cqMap == MAP_FAILED) {
+			u->cqMap = NULL;
+			freeURing(u);
+			return false;
+		}
+	}
+	u->sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+	u->sqes = mmap(NULL, u->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+	if (u->sqes == MAP_FAILED) {
+		u->sqes = NULL;
+		freeURing(u);
+		return false;
+	}
+	char* sq = u->sqMap;
+	char* cq = u->cqMap;
+	u->sqHead = (unsigned*) (sq + p.sq_off.head);
+	u->sqTail = (unsigned*) (sq + p.sq_off.tail);
+	u->sqMask = (unsigned*) (sq + p.sq_off.ring_mask);
+	u->sqArray = (unsigned*) (sq + p.sq_off.array);
+	u->cqHead = (unsigned*) (cq + p.cq_off.head);
+	u->cqTail = (unsigned*) (cq + p.cq_off.tail);
+	u->cqMask = (unsigned*) (cq + p.cq_off.ring_mask);
+	u->cqes = (struct io_uring_cqe*) (cq + p.cq_off.cqes);
+
+	/* register the receive ring and the storage of the encoder (the connection should not move from now on) */
+	struct iovec bufs[2] = {
+		{ cnx->ring.data, sizeof(cnx->ring.data) },
+		{ cnx->command, MAX_COMMAND }
+	};
+	if (syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_BUFFERS, bufs, 2) < 0) {
+		freeURing(u);
+		return false;
+	}
+
+	cnx->transportData = u;
+	return true;
+}
+
+
+static void uringConnect(Connection* cnx, const char* fct, const char* serverName, unsigned int port, bool nonBlocking) {
+	socketConnect(cnx, fct, serverName, port, nonBlocking);
+	if (!uringInit(cnx)) {
+		dispDebug(cnx, fct, 1, "io_uring cannot be used, the socket is used instead");
+		cnx->transport = &socketTransport;
+	}
+}
+
+
+static ssize_t uringRead(Connection* cnx, char* buf, size_t n) {
+	URing* u = cnx->transportData;
+	int res[3] = { 0 };
+	struct io_uring_sqe* sqe = getSqe(u);
+	sqe->opcode = IORING_OP_READ_FIXED;
+	sqe->fd = cnx->sockfd;
+	sqe->addr = (unsigned long) buf;
+	sqe->len = n;
+	sqe->buf_index = BUF_RING;      /* `buf` is always in the receive ring */
+	sqe->user_data = REQ_READ;
+	if (!submitAndWait(u, 1, res))
+		return -1;
+	return res[REQ_READ] < 0 ? -1 : res[REQ_READ];
+}
+
+
+static ssize_t uringExchange(Connection* cnx, const struct iovec* iov, int niov) {
+	URing* u = cnx->transportData;
+	int res[3] = { 0 };
+	size_t len = 0;
+	for (int i = 0; i < niov; i++)
+		len += iov[i].iov_len;
+
+	/* the write: the encoded commands are in a registered buffer, the others are given as they are */
+	struct io_uring_sqe* sqe = getSqe(u);
+	sqe->fd = cnx->sockfd;
+	if (niov == 1 && iov->iov_base >= (void*) cnx->command && (char*) iov->iov_base + len <= cnx->command + MAX_COMMAND) {
+		sqe->opcode = IORING_OP_WRITE_FIXED;
+		sqe->addr = (unsigned long) iov->iov_base;
+		sqe->len = len;
+		sqe->buf_index = BUF_COMMAND;
+	}
+	else {
+		sqe->opcode = IORING_OP_WRITEV;
+		sqe->addr = (unsigned long) iov;
+		sqe->len = niov;
+	}
+	sqe->user_data = REQ_WRITE;
+
+	/* linked to the read of the answer */
+	unsigned n = 1;
+	sqe->flags = IOSQE_IO_LINK;
+	if (prepRead(cnx, u))
+		n = 2;
+	else
+		sqe->flags = 0;
+
+	if (!submitAndWait(u, n, res) || res[REQ_WRITE] < 0)
+		return -1;
+
+	if (n == 2 && res[REQ_READ] > 0)
+		rbCommit(&cnx->ring, res[REQ_READ]);
+	else if (n == 2 && res[REQ_READ] < 0 && res[REQ_READ] != -ECANCELED && res[REQ_READ] != -EINTR)
+		return -1;
+
+	/* short write (the read has then been cancelled): the rest is written by the socket */
+	if ((size_t) res[REQ_WRITE] < len) {
+		struct iovec rest[8];
+		int nrest = 0;
+		size_t skip = res[REQ_WRITE];
+		for (int i = 0; i < niov && nrest < 8; i++) {
+			if (skip >= iov[i].iov_len) {
+				skip -= iov[i].iov_len;
+				continue;
+			}
+			rest[nrest].iov_base = (char*) iov[i].iov_base + skip;
+			rest[nrest++].iov_len = iov[i].iov_len - skip;
+			skip = 0;
+		}
+		if (writeAll(cnx->sockfd, rest, nrest) < 0)
+			return -1;
+	}
+
+	return len;
+}
+
+
+static void uringClose(Connection* cnx) {
+	if (cnx->transportData)
+		freeURing(cnx->transportData);
+	cnx->transportData = NULL;
+	socketClose(cnx);
+}
+
+
+const Transport uringTransport = { "io_uring", uringConnect, uringRead, uringExchange, uringClose };